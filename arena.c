@@ -0,0 +1,167 @@
+#include "arena.h"
+#include "memory.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A block of the arena, its data starts at the next BUFFER_ALIGNMENT boundary
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;  // Bytes of data
+    size_t used;
+    int dedicated;  // 1 when the block holds a single allocation larger than a quarter of a block
+} ARENA_BLOCK;
+
+#define BLOCK_HEADER ((sizeof(ARENA_BLOCK) + BUFFER_ALIGNMENT - 1) & ~(size_t)(BUFFER_ALIGNMENT - 1))
+
+struct arena {
+    ARENA_BLOCK *blocks;  // Current block first, the bump pointer only moves in it
+    size_t next_block_size;
+    void *last;  // Last allocation of the current block, the only one that can grow in place
+    pthread_mutex_t lock;
+};
+
+static char *block_data(ARENA_BLOCK *block) {
+    return (char *)block + BLOCK_HEADER;
+}
+
+static size_t round_to_alignment(size_t size) {
+    return (size + BUFFER_ALIGNMENT - 1) & ~(size_t)(BUFFER_ALIGNMENT - 1);
+}
+
+// Function to create an arena and its first block
+ARENA *arena_create(size_t block_size) {
+    ARENA *arena = (ARENA *)malloc(sizeof(ARENA));
+    if (arena == NULL) return NULL;
+    arena->blocks = NULL;
+    arena->next_block_size = block_size > 0 ? round_to_alignment(block_size) : ARENA_DEFAULT_BLOCK;
+    arena->last = NULL;
+    pthread_mutex_init(&arena->lock, NULL);
+    return arena;
+}
+
+// Function to release an arena with every buffer allocated from it
+void arena_destroy(ARENA *arena) {
+    if (arena == NULL) return;
+    ARENA_BLOCK *block = arena->blocks;
+    while (block != NULL) {
+        ARENA_BLOCK *next = block->next;
+        aligned_buffer_free(block);
+        block = next;
+    }
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+// Allocate with the lock held
+static void *arena_alloc_locked(ARENA *arena, size_t size) {
+    size = round_to_alignment(size);
+    ARENA_BLOCK *current = arena->blocks;
+    if (current != NULL && current->size - current->used >= size) {
+        void *ptr = block_data(current) + current->used;
+        current->used += size;
+        arena->last = ptr;
+        return ptr;
+    }
+
+    // Allocations larger than a quarter of a block get a block of their own behind the current one,
+    // so that the room left in the current block is not abandoned
+    size_t block_size = arena->next_block_size;
+    int dedicated = size > block_size / 4;
+    if (dedicated) block_size = size;
+    ARENA_BLOCK *block = (ARENA_BLOCK *)aligned_buffer_alloc(BLOCK_HEADER + block_size);
+    if (block == NULL) return NULL;
+    block->size = block_size;
+    block->used = size;
+    block->dedicated = dedicated;
+    if (dedicated && current != NULL) {
+        block->next = current->next;
+        current->next = block;
+    } else {
+        block->next = current;
+        arena->blocks = block;
+        arena->last = block_data(block);
+        if (arena->next_block_size < ARENA_MAX_BLOCK) arena->next_block_size *= 2;
+    }
+    return block_data(block);
+}
+
+// Function to bump-allocate a buffer
+void *arena_alloc(ARENA *arena, size_t size) {
+    if (size == 0) return NULL;
+    pthread_mutex_lock(&arena->lock);
+    void *ptr = arena_alloc_locked(arena, size);
+    pthread_mutex_unlock(&arena->lock);
+    return ptr;
+}
+
+// Grow the dedicated block holding ptr as an aligned buffer, so that a large buffer is remapped rather than
+// copied (see aligned_buffer_realloc); NULL when ptr is not alone in its block or on failure
+static void *grow_dedicated_locked(ARENA *arena, void *ptr, size_t new_size) {
+    ARENA_BLOCK **link = &arena->blocks;
+    while (*link != NULL && !((*link)->dedicated && block_data(*link) == ptr)) link = &(*link)->next;
+    ARENA_BLOCK *block = *link;
+    if (block == NULL) return NULL;
+    size_t needed = round_to_alignment(new_size);
+    ARENA_BLOCK *grown = (ARENA_BLOCK *)aligned_buffer_realloc(block, BLOCK_HEADER + block->size,
+                                                               BLOCK_HEADER + needed);
+    if (grown == NULL) return NULL;
+    grown->size = needed;
+    grown->used = needed;
+    *link = grown;
+    if (arena->last == ptr) arena->last = block_data(grown);
+    return block_data(grown);
+}
+
+// Function to resize a buffer, in place when it is the last allocation of the current block or when it shrinks
+// A buffer alone in its dedicated block grows with that block and is not copied into the arena again
+void *arena_realloc(ARENA *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) return arena_alloc(arena, new_size);
+    if (new_size == 0) return NULL;
+    pthread_mutex_lock(&arena->lock);
+    void *new_ptr = ptr;
+    ARENA_BLOCK *current = arena->blocks;
+    if (ptr == arena->last) {
+        size_t offset = (size_t)((char *)ptr - block_data(current));
+        size_t needed = round_to_alignment(new_size);
+        if (current->size - offset >= needed) {
+            current->used = offset + needed;
+            pthread_mutex_unlock(&arena->lock);
+            return ptr;
+        }
+    }
+    if (new_size > old_size) {
+        new_ptr = grow_dedicated_locked(arena, ptr, new_size);
+        if (new_ptr != NULL) {
+            pthread_mutex_unlock(&arena->lock);
+            return new_ptr;
+        }
+        new_ptr = arena_alloc_locked(arena, new_size);
+        if (new_ptr != NULL) memcpy(new_ptr, ptr, old_size);
+    }
+    pthread_mutex_unlock(&arena->lock);
+    return new_ptr;
+}
+
+// Function to copy a string into the arena
+char *arena_strdup(ARENA *arena, const char *str) {
+    size_t length = strlen(str) + 1;
+    char *copy = (char *)arena_alloc(arena, length);
+    if (copy != NULL) memcpy(copy, str, length);
+    return copy;
+}
+
+// Function to get the bytes held by an arena
+size_t arena_memory_usage(ARENA *arena, size_t *unused) {
+    size_t total = 0, free_bytes = 0;
+    if (arena != NULL) {
+        pthread_mutex_lock(&arena->lock);
+        for (ARENA_BLOCK *block = arena->blocks; block != NULL; block = block->next) {
+            total += BLOCK_HEADER + block->size;
+            free_bytes += block->size - block->used;
+        }
+        pthread_mutex_unlock(&arena->lock);
+    }
+    if (unused != NULL) *unused = free_bytes;
+    return total;
+}
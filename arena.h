@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator owning a few large blocks, released all at once by arena_destroy
+// Allocations are aligned on BUFFER_ALIGNMENT bytes and are never freed one by one: a buffer that grows
+// moves to a new place unless it is the last allocation of its block, and the old space is reclaimed
+// only with the arena. A buffer larger than a quarter of a block gets a block of its own, which later
+// grows like an aligned buffer (remapped without copying from MAPPED_BUFFER_SIZE up, where supported). Calls may come from several threads (compact_dataframe compacts columns in parallel).
+
+typedef struct arena ARENA;
+
+// First block size when none is given, later blocks double up to ARENA_MAX_BLOCK
+#define ARENA_DEFAULT_BLOCK (1 << 20)
+#define ARENA_MAX_BLOCK (64 << 20)
+
+// Function prototypes for managing arenas
+
+// Create an arena whose first block holds block_size bytes (0 for ARENA_DEFAULT_BLOCK); NULL on failure
+ARENA *arena_create(size_t block_size);
+
+// Release every block of the arena and the arena itself
+void arena_destroy(ARENA *arena);
+
+// Allocate size bytes, NULL for size 0 or on failure
+void *arena_alloc(ARENA *arena, size_t size);
+
+// Same contract as aligned_buffer_realloc; shrinking keeps the buffer in place, and growing a buffer that
+// owns a dedicated block resizes that block instead of copying the buffer
+void *arena_realloc(ARENA *arena, void *ptr, size_t old_size, size_t new_size);
+
+// Copy of a string in the arena
+char *arena_strdup(ARENA *arena, const char *str);
+
+// Bytes of the blocks of the arena, and the part of them not handed out yet
+size_t arena_memory_usage(ARENA *arena, size_t *unused);
+
+#endif // ARENA_H
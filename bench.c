@@ -0,0 +1,575 @@
+#include "cdataframe.h"
+#include "filter.h"
+#include "groupby.h"
+#include "join.h"
+#include "kernels.h"
+#include "sort.h"
+#include "writer.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Benchmark suite: bulk loads, scans, reductions, lookups, formatting, display, grouping and sort of every
+// column type
+//
+// Usage: cdataframe_bench [--rows N,N,...] [--types T,T,...] [--filter NAME] [--seed S] [--json]
+//   --rows    row counts to run, 1000,1000000,100000000 by default
+//   --types   parse_type names plus NULLVAL, every type by default
+//   --filter  only the benchmarks whose name contains NAME
+//   --seed    seed of the data generators, 42 by default, so that runs are comparable across commits
+//   --json    print one JSON document instead of the table
+// Sizes that would not fit in half of the physical memory are skipped with a note on stderr.
+
+#define DEFAULT_ROWS "1000,1000000,100000000"
+#define DEFAULT_SEED 42
+#define POOL_ROWS (1u << 20)  // Distinct generated values, larger columns cycle through them
+#define MIN_TIME_NS 2e8  // Short benchmarks are repeated until they ran this long
+#define MAX_ITERATIONS 1000
+#define MAX_SIZES 16
+
+// Generated values of one type and the pivots of the scans
+typedef struct bench_data {
+    ENUM_TYPE type;
+    void *pool;  // POOL_ROWS typed values, char * for STRING
+    char *strings;  // Storage of the STRING pool
+    void *pivot;  // A value in the middle of the range, for count_compare
+    void *absent;  // A value inside the range that was never generated, for check_value_existence
+    CustomStructure pivot_storage;
+    CustomStructure absent_storage;
+} BENCH_DATA;
+
+// State shared by the benchmarks of one type and row count
+typedef struct bench_context {
+    BENCH_DATA *data;
+    unsigned int rows;
+    COLUMN *col;  // Column built by the load benchmarks, owned by df once the scans start
+    DATAFRAME *df;
+    char *format_buffer;
+    int null_fd;
+} BENCH_CONTEXT;
+
+// A benchmark runs once and returns the nanoseconds of the part being measured
+typedef double (*BENCH_FUNCTION)(BENCH_CONTEXT *ctx);
+
+// Options of the command line
+typedef struct bench_options {
+    unsigned int sizes[MAX_SIZES];
+    unsigned int num_sizes;
+    int types[STRUCTURE + 1];  // 1 for each type to run
+    const char *filter;
+    unsigned long long int seed;
+    int json;
+} BENCH_OPTIONS;
+
+static int results_printed = 0;
+
+// Monotonic clock in nanoseconds
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// splitmix64, the same sequence on every platform for a given seed
+static unsigned long long int next_random(unsigned long long int *state) {
+    unsigned long long int z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Peak resident set size of the process in bytes, 0 where it is not available
+static unsigned long long int peak_rss_bytes(void) {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (unsigned long long int)usage.ru_maxrss;
+#else
+    return (unsigned long long int)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// Half of the physical memory, the budget of one column and its index
+static unsigned long long int memory_budget(void) {
+#ifdef _SC_PHYS_PAGES
+    long pages = sysconf(_SC_PHYS_PAGES), page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) return (unsigned long long int)pages * (unsigned long long int)page_size / 2;
+#endif
+    return ULLONG_MAX;
+}
+
+static const char *type_name(ENUM_TYPE type) {
+    static const char *names[] = {"?", "NULLVAL", "UINT", "INT", "CHAR", "FLOAT", "DOUBLE", "STRING", "STRUCTURE"};
+    return type >= NULLVAL && type <= STRUCTURE ? names[type] : names[0];
+}
+
+// Average bytes of one generated STRING value, arena terminator included
+#define STRING_BYTES 13
+
+// Fill the pool of a type with POOL_ROWS values; numbers are even (or multiples of 0.5)
+// and letters skip 'm' so that the absent pivots stay inside the range of the data
+static int generate_data(BENCH_DATA *data, ENUM_TYPE type, unsigned long long int seed) {
+    memset(data, 0, sizeof(BENCH_DATA));
+    data->type = type;
+    unsigned long long int state = seed ^ ((unsigned long long int)type << 32);
+    size_t width = type == STRING ? sizeof(char *) : type_size(type);
+    if (width > 0) {
+        data->pool = malloc((size_t)POOL_ROWS * width);
+        if (!data->pool) return 0;
+    }
+    if (type == STRING) {
+        data->strings = (char *)malloc((size_t)POOL_ROWS * 24);
+        if (!data->strings) return 0;
+    }
+
+    static const char letters[] = "abcdefghijklnopqrstuvwxyz";
+    size_t used = 0;
+    for (unsigned int i = 0; i < POOL_ROWS; i++) {
+        unsigned long long int r = next_random(&state);
+        double half = ((double)(r % 2000000001ULL) - 1e9) * 0.5;
+        switch (type) {
+            case UINT:
+                ((unsigned int *)data->pool)[i] = (unsigned int)r & ~1u;
+                break;
+            case INT:
+                ((int *)data->pool)[i] = (int)((unsigned int)r & ~1u);
+                break;
+            case CHAR:
+                ((char *)data->pool)[i] = letters[r % (sizeof(letters) - 1)];
+                break;
+            case FLOAT:
+                ((float *)data->pool)[i] = (float)((double)(r % 2000001ULL) - 1e6) * 0.5f;
+                break;
+            case DOUBLE:
+                ((double *)data->pool)[i] = half;
+                break;
+            case STRING: {
+                // Up to 16 hex digits, so never "zz"
+                char *str = data->strings + used;
+                int length = snprintf(str, 24, "%llx", r >> (4 * (r % 13)));
+                ((char **)data->pool)[i] = str;
+                used += (size_t)length + 1;
+                break;
+            }
+            case STRUCTURE: {
+                CustomStructure *cs = &((CustomStructure *)data->pool)[i];
+                memset(cs, 0, sizeof(CustomStructure));
+                cs->id = (int)i;
+                cs->value = half;
+                snprintf(cs->description, sizeof(cs->description), "item %u", i);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Pivot storage is large enough for any type
+    switch (type) {
+        case UINT:
+            *(unsigned int *)&data->pivot_storage = UINT_MAX / 2;
+            *(unsigned int *)&data->absent_storage = 1;
+            break;
+        case INT:
+            *(int *)&data->pivot_storage = 0;
+            *(int *)&data->absent_storage = 1;
+            break;
+        case CHAR:
+            *(char *)&data->pivot_storage = 'm';
+            *(char *)&data->absent_storage = 'm';
+            break;
+        case FLOAT:
+            *(float *)&data->pivot_storage = 0.0f;
+            *(float *)&data->absent_storage = 0.25f;
+            break;
+        case DOUBLE:
+            *(double *)&data->pivot_storage = 0.0;
+            *(double *)&data->absent_storage = 0.25;
+            break;
+        case STRING:
+            strcpy((char *)&data->pivot_storage, "8");
+            strcpy((char *)&data->absent_storage, "zz");
+            break;
+        case STRUCTURE:
+            data->pivot_storage.value = 0.0;
+            data->absent_storage.value = 0.25;
+            break;
+        default:
+            break;
+    }
+    data->pivot = &data->pivot_storage;
+    data->absent = &data->absent_storage;
+    return 1;
+}
+
+static void free_data(BENCH_DATA *data) {
+    free(data->pool);
+    free(data->strings);
+}
+
+// Generated value of a row, what insert_value expects (NULL for NULLVAL)
+static void *pool_value(BENCH_DATA *data, unsigned int row) {
+    unsigned int i = row & (POOL_ROWS - 1);
+    switch (data->type) {
+        case STRING:
+            return ((char **)data->pool)[i];
+        case NULLVAL:
+            return NULL;
+        default:
+            return (char *)data->pool + (size_t)i * type_size(data->type);
+    }
+}
+
+// Bytes held by the rows of the benchmark column, the unit of the GB/s figures
+static double payload_bytes(BENCH_CONTEXT *ctx) {
+    MEMORY_USAGE usage;
+    column_memory_usage(ctx->col, &usage);
+    return (double)(usage.payload + usage.mapped);
+}
+
+// Start a new empty column for a load benchmark, outside of the measured time
+static int fresh_column(BENCH_CONTEXT *ctx) {
+    if (ctx->col != NULL) delete_column(&ctx->col);
+    ctx->col = create_column(ctx->data->type, "bench");
+    return ctx->col != NULL;
+}
+
+static double bench_insert_value(BENCH_CONTEXT *ctx) {
+    if (!fresh_column(ctx)) return -1;
+    double start = now_ns();
+    for (unsigned int i = 0; i < ctx->rows; i++) {
+        insert_value(ctx->col, pool_value(ctx->data, i));
+    }
+    return now_ns() - start;
+}
+
+static double bench_column_append_n(BENCH_CONTEXT *ctx) {
+    if (ctx->data->type == NULLVAL) return -1;  // No typed array to append from
+    if (!fresh_column(ctx)) return -1;
+    double start = now_ns();
+    for (unsigned int done = 0; done < ctx->rows;) {
+        unsigned int n = ctx->rows - done < POOL_ROWS ? ctx->rows - done : POOL_ROWS;
+        column_append_n(ctx->col, ctx->data->pool, n);
+        done += n;
+    }
+    return now_ns() - start;
+}
+
+static double bench_count_compare(BENCH_CONTEXT *ctx) {
+    COMPARE_COUNTS counts = {0, 0, 0};
+    double start = now_ns();
+    count_compare(ctx->col, ctx->data->pivot, &counts);
+    return now_ns() - start;
+}
+
+// Select the values greater than the pivot, about half of the rows
+static double bench_column_filter(BENCH_CONTEXT *ctx) {
+    double start = now_ns();
+    SELECTION *sel = column_filter(ctx->col, FILTER_GT, ctx->data->pivot, NULL);
+    double elapsed = now_ns() - start;
+    if (sel == NULL) return -1;
+    free_selection(&sel);
+    return elapsed;
+}
+
+// Copy the rows of the same selection into a new dataframe
+static double bench_dataframe_filter(BENCH_CONTEXT *ctx) {
+    SELECTION *sel = column_filter(ctx->col, FILTER_GT, ctx->data->pivot, NULL);
+    if (sel == NULL) return -1;
+    double start = now_ns();
+    DATAFRAME *filtered = dataframe_filter(ctx->df, sel);
+    double elapsed = now_ns() - start;
+    free_selection(&sel);
+    if (filtered == NULL) return -1;
+    free_dataframe(filtered);
+    return elapsed;
+}
+
+static double aggregate_with(BENCH_CONTEXT *ctx, SUM_MODE mode) {
+    if (!has_reduce_kernel(ctx->data->type)) return -1;
+    COLUMN_AGGREGATES aggregates;
+    double start = now_ns();
+    column_aggregate(ctx->col, mode, &aggregates);
+    return now_ns() - start;
+}
+
+static double bench_column_aggregate(BENCH_CONTEXT *ctx) {
+    return aggregate_with(ctx, SUM_PLAIN);
+}
+
+static double bench_column_aggregate_kahan(BENCH_CONTEXT *ctx) {
+    return aggregate_with(ctx, SUM_KAHAN);
+}
+
+static double bench_column_aggregate_pairwise(BENCH_CONTEXT *ctx) {
+    return aggregate_with(ctx, SUM_PAIRWISE);
+}
+
+// Only the column of the benchmark is in the dataframe, the value is absent so every row is visited
+static double bench_check_value_existence(BENCH_CONTEXT *ctx) {
+    double start = now_ns();
+    int found = check_value_existence(ctx->df, ctx->data->absent);
+    double elapsed = now_ns() - start;
+    if (found) fprintf(stderr, "check_value_existence found an absent %s value.\n", type_name(ctx->data->type));
+    return elapsed;
+}
+
+static double bench_convert_value(BENCH_CONTEXT *ctx) {
+    double start = now_ns();
+    for (unsigned int i = 0; i < ctx->rows; i++) {
+        convert_value(ctx->col, i, ctx->format_buffer, 256);
+    }
+    return now_ns() - start;
+}
+
+// The print_col output, written to the null device
+static double bench_display(BENCH_CONTEXT *ctx) {
+    if (ctx->null_fd < 0) return -1;
+    TEXT_WRITER writer;
+    double start = now_ns();
+    writer_init(&writer, ctx->null_fd);
+    write_column_rows(ctx->col, 0, ctx->col->size, &writer);
+    writer_close(&writer);
+    return now_ns() - start;
+}
+
+// Group by the values of the column, counting each group (about min(rows, POOL_ROWS) groups)
+static double bench_group_by(BENCH_CONTEXT *ctx) {
+    if (ctx->data->type == NULLVAL) return -1;  // Not a key type
+    unsigned int key = 0;
+    AGGREGATION count = {0, AGG_COUNT};
+    double start = now_ns();
+    DATAFRAME *groups = dataframe_group_by(ctx->df, &key, 1, &count, 1);
+    double elapsed = now_ns() - start;
+    if (groups == NULL) return -1;
+    free_dataframe(groups);
+    return elapsed;
+}
+
+// Inner join of the column with a dimension of its first min(rows, POOL_ROWS) values, built on the dimension
+static double bench_join(BENCH_CONTEXT *ctx) {
+    if (ctx->data->type == NULLVAL || ctx->data->type == CHAR) return -1;  // Not a key type, or too few distinct keys
+    DATAFRAME *dimension = create_dataframe();
+    COLUMN *key = add_new_column_to_dataframe(dimension, ctx->data->type, "key");
+    unsigned int n = ctx->rows < POOL_ROWS ? ctx->rows : POOL_ROWS;
+    if (key == NULL || !column_append_n(key, ctx->data->pool, n)) {
+        free_dataframe(dimension);
+        return -1;
+    }
+    double start = now_ns();
+    DATAFRAME *joined = dataframe_join(ctx->df, dimension, 0, 0, JOIN_INNER);
+    double elapsed = now_ns() - start;
+    free_dataframe(dimension);
+    if (joined == NULL) return -1;
+    free_dataframe(joined);
+    return elapsed;
+}
+
+static double bench_sort_column(BENCH_CONTEXT *ctx) {
+    double start = now_ns();
+    sort_column(ctx->col, ASC);
+    return now_ns() - start;
+}
+
+// Print the result of a benchmark, as a table line or as a JSON object of the results array
+static void report(const BENCH_OPTIONS *options, const char *name, ENUM_TYPE type, unsigned int rows,
+                   unsigned int iterations, double mean_ns, double bytes, const MEMORY_STATS *memory) {
+    double ns_per_row = rows > 0 ? mean_ns / rows : 0;
+    double gb_per_s = mean_ns > 0 ? bytes / mean_ns : 0;
+    unsigned long long int rss = peak_rss_bytes();
+    if (options->json) {
+        printf("%s\n    {\"benchmark\": \"%s\", \"type\": \"%s\", \"rows\": %u, \"iterations\": %u, "
+               "\"ns_per_row\": %.4f, \"gb_per_s\": %.4f, \"peak_rss_bytes\": %llu, \"peak_tracked_bytes\": %zu}",
+               results_printed > 0 ? "," : "", name, type_name(type), rows, iterations, ns_per_row, gb_per_s, rss,
+               memory->peak);
+    } else {
+        printf("%-28s %-9s %11u %12.3f %9.3f %13.1f %13.1f\n", name, type_name(type), rows, ns_per_row, gb_per_s,
+               rss / 1048576.0, memory->peak / 1048576.0);
+    }
+    results_printed++;
+}
+
+// Run a benchmark until MIN_TIME_NS has passed (at least once) and report the mean time of a run
+static void run_benchmark(const BENCH_OPTIONS *options, BENCH_CONTEXT *ctx, const char *name, BENCH_FUNCTION fn) {
+    if (options->filter != NULL && strstr(name, options->filter) == NULL) return;
+    reset_memory_peak();
+    double total = 0;
+    unsigned int iterations = 0;
+    while (iterations < MAX_ITERATIONS && (iterations == 0 || total < MIN_TIME_NS)) {
+        double elapsed = fn(ctx);
+        if (elapsed < 0) return;  // Not applicable to this type
+        total += elapsed;
+        iterations++;
+    }
+    MEMORY_STATS memory;
+    get_memory_stats(&memory);
+    report(options, name, ctx->data->type, ctx->rows, iterations, total / iterations, payload_bytes(ctx), &memory);
+}
+
+// Every benchmark of one type at one row count
+static void run_suite(const BENCH_OPTIONS *options, BENCH_DATA *data, unsigned int rows) {
+    BENCH_CONTEXT ctx = {data, rows, NULL, NULL, NULL, -1};
+    ctx.format_buffer = (char *)malloc(256);
+#ifndef _WIN32
+    ctx.null_fd = open("/dev/null", O_WRONLY);
+#endif
+
+    // The loads leave the column that the other benchmarks read
+    run_benchmark(options, &ctx, "insert_value", bench_insert_value);
+    run_benchmark(options, &ctx, "column_append_n", bench_column_append_n);
+    if (ctx.col == NULL || ctx.col->size != rows) {
+        fresh_column(&ctx);
+        for (unsigned int i = 0; i < rows; i++) insert_value(ctx.col, pool_value(data, i));
+    }
+    ctx.df = create_dataframe();
+    if (ctx.df == NULL || add_column_to_dataframe(ctx.df, ctx.col) != 0) {
+        fprintf(stderr, "Failed to set up the %s dataframe.\n", type_name(data->type));
+        delete_column(&ctx.col);
+        free_dataframe(ctx.df);
+        free(ctx.format_buffer);
+        return;
+    }
+
+    run_benchmark(options, &ctx, "count_compare", bench_count_compare);
+    if (has_compare_kernel(data->type)) {
+        // Same scan with each kernel level the processor supports
+        static const char *level_names[] = {"count_compare/scalar", "count_compare/sse2", "count_compare/avx2"};
+        KERNEL_LEVEL best = get_kernel_level();
+        for (int level = KERNEL_SCALAR; level <= (int)best; level++) {
+            set_kernel_level((KERNEL_LEVEL)level);
+            run_benchmark(options, &ctx, level_names[level], bench_count_compare);
+        }
+        set_kernel_level(best);
+    }
+    run_benchmark(options, &ctx, "column_filter", bench_column_filter);
+    run_benchmark(options, &ctx, "dataframe_filter", bench_dataframe_filter);
+    run_benchmark(options, &ctx, "column_aggregate", bench_column_aggregate);
+    run_benchmark(options, &ctx, "column_aggregate/kahan", bench_column_aggregate_kahan);
+    run_benchmark(options, &ctx, "column_aggregate/pairwise", bench_column_aggregate_pairwise);
+    if (has_reduce_kernel(data->type) && get_kernel_level() > KERNEL_SCALAR) {
+        // The reductions have scalar and AVX2 kernels only
+        KERNEL_LEVEL best = get_kernel_level();
+        set_kernel_level(KERNEL_SCALAR);
+        run_benchmark(options, &ctx, "column_aggregate/scalar", bench_column_aggregate);
+        set_kernel_level(best);
+    }
+    run_benchmark(options, &ctx, "check_value_existence", bench_check_value_existence);
+    run_benchmark(options, &ctx, "convert_value", bench_convert_value);
+    run_benchmark(options, &ctx, "display", bench_display);
+    run_benchmark(options, &ctx, "group_by", bench_group_by);
+    run_benchmark(options, &ctx, "join", bench_join);
+    run_benchmark(options, &ctx, "sort_column", bench_sort_column);
+
+    free_dataframe(ctx.df);
+    free(ctx.format_buffer);
+    if (ctx.null_fd >= 0) close(ctx.null_fd);
+}
+
+// Bytes a column of rows values of a type needs at its peak: values and their growth copy,
+// then the sort index and its scratch row arrays, and the strings
+static unsigned long long int estimate_bytes(ENUM_TYPE type, unsigned int rows) {
+    unsigned long long int width = type == STRING ? sizeof(unsigned long long int) : type_size(type);
+    unsigned long long int per_row = 2 * width + 2 * sizeof(unsigned long long int) + (type == STRING ? 2 * STRING_BYTES : 0);
+    return (unsigned long long int)rows * per_row;
+}
+
+static int parse_options(int argc, char **argv, BENCH_OPTIONS *options) {
+    const char *rows = DEFAULT_ROWS;
+    const char *types = NULL;
+    memset(options, 0, sizeof(BENCH_OPTIONS));
+    options->seed = DEFAULT_SEED;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            options->json = 1;
+        } else if (i + 1 < argc && strcmp(argv[i], "--rows") == 0) {
+            rows = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--types") == 0) {
+            types = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--filter") == 0) {
+            options->filter = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--rows N,N,...] [--types T,T,...] [--filter NAME] [--seed S] [--json]\n",
+                    argv[0]);
+            return 0;
+        }
+    }
+
+    for (const char *p = rows; *p != '\0' && options->num_sizes < MAX_SIZES;) {
+        char *end;
+        unsigned long long int n = strtoull(p, &end, 10);
+        if (end == p || n == 0 || n > UINT_MAX) {
+            fprintf(stderr, "Invalid row count in '%s'.\n", rows);
+            return 0;
+        }
+        options->sizes[options->num_sizes++] = (unsigned int)n;
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    for (int type = NULLVAL; type <= STRUCTURE; type++) options->types[type] = types == NULL;
+    while (types != NULL && *types != '\0') {
+        char name[16];
+        size_t length = strcspn(types, ",");
+        snprintf(name, sizeof(name), "%.*s", (int)length, types);
+        int type = strcmp(name, "NULLVAL") == 0 ? (int)NULLVAL : (int)parse_type(name);
+        if (type < NULLVAL || type > STRUCTURE) {
+            fprintf(stderr, "Unknown type '%s'.\n", name);
+            return 0;
+        }
+        options->types[type] = 1;
+        types += length + (types[length] == ',');
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    BENCH_OPTIONS options;
+    if (!parse_options(argc, argv, &options)) return 1;
+
+    static const char *level_names[] = {"scalar", "sse2", "avx2"};
+    unsigned int threads = thread_pool_size(get_default_thread_pool());
+    if (options.json) {
+        printf("{\n  \"seed\": %llu,\n  \"threads\": %u,\n  \"kernel\": \"%s\",\n  \"pool_rows\": %u,\n  \"results\": [",
+               options.seed, threads, level_names[get_kernel_level()], POOL_ROWS);
+    } else {
+        printf("seed %llu, %u threads, %s kernels\n", options.seed, threads, level_names[get_kernel_level()]);
+        printf("%-28s %-9s %11s %12s %9s %13s %13s\n", "benchmark", "type", "rows", "ns/row", "GB/s",
+               "peak RSS MB", "tracked MB");
+    }
+
+    unsigned long long int budget = memory_budget();
+    for (int type = NULLVAL; type <= STRUCTURE; type++) {
+        if (!options.types[type]) continue;
+        BENCH_DATA data;
+        if (!generate_data(&data, (ENUM_TYPE)type, options.seed)) {
+            fprintf(stderr, "Failed to generate the %s data.\n", type_name((ENUM_TYPE)type));
+            free_data(&data);
+            return 1;
+        }
+        for (unsigned int s = 0; s < options.num_sizes; s++) {
+            unsigned long long int needed = estimate_bytes((ENUM_TYPE)type, options.sizes[s]);
+            if (needed > budget) {
+                fprintf(stderr, "Skipping %s at %u rows: needs about %llu MB.\n", type_name((ENUM_TYPE)type),
+                        options.sizes[s], needed >> 20);
+                continue;
+            }
+            run_suite(&options, &data, options.sizes[s]);
+        }
+        free_data(&data);
+    }
+
+    if (options.json) printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+// Packed bitmaps of one bit per row, stored in 64-row words
+
+#define BITMAP_WORD_BITS 64
+
+// Number of 64-bit words needed to hold n bits
+static inline unsigned long long int bitmap_words(unsigned long long int n) {
+    return (n + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+}
+
+static inline int bitmap_get(const unsigned long long int *bitmap, unsigned long long int i) {
+    return (int)((bitmap[i / BITMAP_WORD_BITS] >> (i % BITMAP_WORD_BITS)) & 1ULL);
+}
+
+static inline void bitmap_set(unsigned long long int *bitmap, unsigned long long int i) {
+    bitmap[i / BITMAP_WORD_BITS] |= 1ULL << (i % BITMAP_WORD_BITS);
+}
+
+static inline void bitmap_clear(unsigned long long int *bitmap, unsigned long long int i) {
+    bitmap[i / BITMAP_WORD_BITS] &= ~(1ULL << (i % BITMAP_WORD_BITS));
+}
+
+// Mask of the bits of word w that fall below n, all ones for every word but the last
+static inline unsigned long long int bitmap_tail_mask(unsigned long long int w, unsigned long long int n) {
+    unsigned long long int remaining = n - w * BITMAP_WORD_BITS;
+    return remaining >= BITMAP_WORD_BITS ? ~0ULL : (1ULL << remaining) - 1;
+}
+
+// Mask of the bits of word w that fall in the row range [start, end)
+static inline unsigned long long int bitmap_range_mask(unsigned long long int w, unsigned long long int start,
+                                                       unsigned long long int end) {
+    unsigned long long int mask = bitmap_tail_mask(w, end);
+    if (w == start / BITMAP_WORD_BITS) mask &= ~0ULL << (start % BITMAP_WORD_BITS);
+    return mask;
+}
+
+static inline int popcount64(unsigned long long int word) {
+    return __builtin_popcountll(word);
+}
+
+// Index of the lowest set bit, word must not be 0
+static inline int lowest_bit64(unsigned long long int word) {
+    return __builtin_ctzll(word);
+}
+
+// Run the statements given after i for every row i of [start, end) whose bit is set (every row when bitmap is NULL)
+// Each 64-row word is classified with one popcount: full words take a dense loop, empty words are
+// skipped and mixed words only visit their set bits
+#define FOR_EACH_SET_BIT(bitmap, start, end, i, ...)                                           \
+    for (unsigned long long int w_ = (start) / BITMAP_WORD_BITS; w_ < bitmap_words(end); w_++) { \
+        unsigned long long int mask_ = bitmap_range_mask(w_, (start), (end));                  \
+        if ((bitmap) != NULL) mask_ &= (bitmap)[w_];                                           \
+        int set_ = popcount64(mask_);                                                          \
+        unsigned int base_ = (unsigned int)(w_ * BITMAP_WORD_BITS);                            \
+        if (set_ == 0) continue;                                                               \
+        if (set_ == BITMAP_WORD_BITS) {                                                        \
+            for (unsigned int i = base_; i < base_ + BITMAP_WORD_BITS; i++) { __VA_ARGS__ }    \
+        } else {                                                                               \
+            for (unsigned long long int m_ = mask_; m_ != 0; m_ &= m_ - 1) {                   \
+                unsigned int i = base_ + (unsigned int)lowest_bit64(m_);                       \
+                __VA_ARGS__                                                                    \
+            }                                                                                  \
+        }                                                                                      \
+    }
+
+#endif // BITMAP_H
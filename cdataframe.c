@@ -1,7 +1,25 @@
 #include "cdataframe.h"
+#include "hashindex.h"
+#include "zonemap.h"
+#include "kernels.h"
+#include "memory.h"
+#include "writer.h"
+#include "stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include "string.h"
+#include <stdatomic.h>
+
+#ifdef CDATAFRAME_STATS
+// Cells of a dataframe, the rows counted by the instrumentation of the operations over every column
+static unsigned long long int dataframe_cells(const DATAFRAME *df) {
+    unsigned long long int cells = 0;
+    for (unsigned int i = 0; df != NULL && i < df->column_count; i++) {
+        if (df->columns[i] != NULL) cells += df->columns[i]->size;
+    }
+    return cells;
+}
+#endif
 
 // Creates an empty dataframe
 DATAFRAME *create_dataframe() {
@@ -13,9 +31,86 @@ DATAFRAME *create_dataframe() {
     df->columns = NULL;
     df->column_count = 0;
     df->max_columns = 0;
+    df->pool = NULL;
+    df->mapping = NULL;
+    df->mapping_size = 0;
+    df->auto_compact_percent = 0;
+    df->arena = NULL;
     return df;
 }
 
+// Creates an empty dataframe with an allocation arena for its columns, block_size 0 for the default
+// The arena is released by free_dataframe, so removing a column does not give its memory back before that
+DATAFRAME *create_arena_dataframe(size_t block_size) {
+    DATAFRAME *df = create_dataframe();
+    if (!df) return NULL;
+    df->arena = arena_create(block_size);
+    if (!df->arena) {
+        fprintf(stderr, "Memory allocation failed for the dataframe arena.\n");
+        free(df);
+        return NULL;
+    }
+    return df;
+}
+
+// Creates a column in the arena of the dataframe (on the heap without one) and adds it
+COLUMN *add_new_column_to_dataframe(DATAFRAME *df, ENUM_TYPE type, char *title) {
+    if (!df || !title) return NULL;
+    COLUMN *col = create_arena_column(df->arena, type, title);
+    if (!col) return NULL;
+    if (add_column_to_dataframe(df, col) != 0) {
+        delete_column(&col);
+        return NULL;
+    }
+    return col;
+}
+
+// Gives the dataframe its own pool of num_threads threads, 0 to go back to the process-wide pool
+int set_dataframe_thread_count(DATAFRAME *df, unsigned int num_threads) {
+    if (!df) return -1;
+    THREAD_POOL *pool = NULL;
+    if (num_threads > 0) {
+        pool = create_thread_pool(num_threads);
+        if (!pool) return -1;
+    }
+    free_thread_pool(df->pool);
+    df->pool = pool;
+    return 0;
+}
+
+// Pool running the scans of a dataframe
+static THREAD_POOL *dataframe_pool(DATAFRAME *df) {
+    return df->pool ? df->pool : get_default_thread_pool();
+}
+
+// A range of rows of one column, the unit of work of parallel scans
+typedef struct morsel {
+    unsigned int column;
+    unsigned int start;
+    unsigned int end;
+} MORSEL;
+
+// Splits the given columns into morsels, one per column segment; the caller frees the array
+static MORSEL *split_into_morsels(DATAFRAME *df, unsigned int first_column, unsigned int last_column,
+                                  unsigned int *count) {
+    unsigned int total = 0;
+    for (unsigned int i = first_column; i < last_column; i++) {
+        total += (df->columns[i]->size + SEGMENT_ROWS - 1) / SEGMENT_ROWS;
+    }
+    *count = total;
+    MORSEL *morsels = (MORSEL *)malloc((total > 0 ? total : 1) * sizeof(MORSEL));
+    if (!morsels) return NULL;
+
+    unsigned int k = 0;
+    for (unsigned int i = first_column; i < last_column; i++) {
+        for (unsigned int start = 0; start < df->columns[i]->size; start += SEGMENT_ROWS) {
+            unsigned int end = df->columns[i]->size - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : df->columns[i]->size;
+            morsels[k++] = (MORSEL){i, start, end};
+        }
+    }
+    return morsels;
+}
+
 // Fills the dataframe from user input
 void fill_dataframe_from_user(DATAFRAME *df) {
     if (!df) {
@@ -55,6 +150,7 @@ void fill_dataframe_from_user(DATAFRAME *df) {
 // Converts a string representation of a type into an ENUM_TYPE
 ENUM_TYPE parse_type(const char *typeStr) {
     if (strcmp(typeStr, "INT") == 0) return INT;
+    else if (strcmp(typeStr, "UINT") == 0) return UINT;
     else if (strcmp(typeStr, "FLOAT") == 0) return FLOAT;
     else if (strcmp(typeStr, "DOUBLE") == 0) return DOUBLE;
     else if (strcmp(typeStr, "CHAR") == 0) return CHAR;
@@ -66,6 +162,7 @@ ENUM_TYPE parse_type(const char *typeStr) {
 
 // Example of a hard_fill_dataframe function without dynamic type determination
 void hard_fill_dataframe(DATAFRAME *df, void **data, unsigned int num_rows, unsigned int num_columns) {
+    STAT_SCOPE(HARD_FILL_DATAFRAME, (unsigned long long int)num_rows * num_columns);
     if (!df || !data) {
         fprintf(stderr, "Invalid arguments for hard filling the dataframe.\n");
         return;
@@ -75,9 +172,7 @@ void hard_fill_dataframe(DATAFRAME *df, void **data, unsigned int num_rows, unsi
         ENUM_TYPE fixed_type = INT; // Example fixed type, replace with actual logic
         COLUMN *col = create_column(fixed_type, "Predefined Column");
         add_column_to_dataframe(df, col);
-        for (unsigned int j = 0; j < num_rows; j++) {
-            insert_value(col, ((void **)data[i])[j]); // Assuming data is appropriately typed
-        }
+        column_append_n(col, data[i], num_rows); // Assuming data[i] is an array of num_rows values of the column type
     }
 }
 
@@ -138,22 +233,52 @@ void *read_data_based_on_type(ENUM_TYPE type) {
 
 // Frees resources associated with the dataframe
 void free_dataframe(DATAFRAME *df) {
+    STAT_SCOPE(FREE_DATAFRAME, dataframe_cells(df));
     if (df == NULL) return;
 
     // Loop through each column and delete it using delete_column
     for (unsigned int i = 0; i < df->column_count; i++) {
         if (df->columns[i] != NULL) {
-            delete_column(df->columns[i]);  // Ensure this function frees all resources within the column
+            delete_column(&df->columns[i]);  // Ensure this function frees all resources within the column
         }
     }
 
-    // Free the array of column pointers
+    // Free the array of column pointers, the pool owned by the dataframe, the file its columns are mapped from
+    // and the arena of its columns in a few large blocks
     free(df->columns);
+    free_thread_pool(df->pool);
+    unmap_file(df->mapping, df->mapping_size);
+    arena_destroy(df->arena);
 
     // Finally free the dataframe structure itself
     free(df);
 }
 
+// Sum of the memory usage of the columns plus the dataframe itself; a file mapping counts whole as mapped
+void dataframe_memory_usage(const DATAFRAME *df, MEMORY_USAGE *usage) {
+    if (usage == NULL) return;
+    memset(usage, 0, sizeof(MEMORY_USAGE));
+    if (df == NULL) return;
+
+    usage->overhead = sizeof(DATAFRAME) + (size_t)df->max_columns * sizeof(COLUMN *);
+    for (unsigned int i = 0; i < df->column_count; i++) {
+        MEMORY_USAGE col_usage;
+        column_memory_usage(df->columns[i], &col_usage);
+        usage->payload += col_usage.payload;
+        usage->overhead += col_usage.overhead;
+        usage->indexes += col_usage.indexes;
+        usage->slack += col_usage.slack;
+        usage->mapped += col_usage.mapped;
+    }
+    if (df->mapping != NULL) usage->mapped = df->mapping_size;
+    // Room of the arena blocks not handed out yet (the space left behind by buffers that moved is not reported)
+    if (df->arena != NULL) {
+        size_t unused;
+        arena_memory_usage(df->arena, &unused);
+        usage->slack += unused;
+    }
+}
+
 // Adds a column to the dataframe
 int add_column_to_dataframe(DATAFRAME *df, COLUMN *col) {
     if (df == NULL || col == NULL) return -1;
@@ -168,111 +293,254 @@ int add_column_to_dataframe(DATAFRAME *df, COLUMN *col) {
     return 0;
 }
 
+typedef struct render_job {
+    COLUMN *col;
+    MORSEL *morsels;
+    TEXT_WRITER *texts;  // One in-memory writer per morsel of the wave
+} RENDER_JOB;
+
+// Renders the rows of one morsel with the same layout as print_col
+static void render_morsel(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    RENDER_JOB *job = (RENDER_JOB *)ctx;
+    MORSEL m = job->morsels[task_index];
+    write_column_rows(job->col, m.start, m.end, &job->texts[task_index]);
+}
+
+// Writes a column like print_col, rendering waves of morsels in parallel and writing them in order
+static void write_column_parallel(DATAFRAME *df, unsigned int column, TEXT_WRITER *out) {
+    COLUMN *col = df->columns[column];
+    writer_put_string(out, "Column '");
+    writer_put_string(out, col->title);
+    writer_put_string(out, "':\n");
+
+    unsigned int count;
+    MORSEL *morsels = split_into_morsels(df, column, column + 1, &count);
+    unsigned int wave = thread_pool_size(dataframe_pool(df)) * 2;
+    TEXT_WRITER *texts = (TEXT_WRITER *)malloc(wave * sizeof(TEXT_WRITER));
+    if (!morsels || !texts) {
+        free(morsels);
+        free(texts);
+        write_column_rows(col, 0, col->size, out);
+        return;
+    }
+    for (unsigned int k = 0; k < wave; k++) {
+        writer_init(&texts[k], -1);
+    }
+    for (unsigned int first = 0; first < count; first += wave) {
+        unsigned int n = count - first < wave ? count - first : wave;
+        RENDER_JOB job = {col, morsels + first, texts};
+        thread_pool_run(dataframe_pool(df), n, render_morsel, &job);
+        for (unsigned int k = 0; k < n; k++) {
+            writer_put(out, texts[k].data, texts[k].length);
+            texts[k].length = 0;
+        }
+    }
+    for (unsigned int k = 0; k < wave; k++) {
+        writer_close(&texts[k]);
+    }
+    free(texts);
+    free(morsels);
+}
+
+// Starts a writer on standard output, after what printf has buffered
+static void open_stdout_writer(TEXT_WRITER *out) {
+    fflush(stdout);
+    writer_init(out, fileno(stdout));
+}
+
 // Displays the entire dataframe
 void display_full_dataframe(DATAFRAME *df) {
+    STAT_SCOPE(DISPLAY_FULL_DATAFRAME, dataframe_cells(df));
     if (!df || !df->columns) {
         printf("The dataframe is empty or uninitialized.\n");
         return;
     }
-    printf("Dataframe contains %u columns:\n", df->column_count);
+    TEXT_WRITER out;
+    open_stdout_writer(&out);
+    writer_put_string(&out, "Dataframe contains ");
+    writer_put_uint(&out, df->column_count);
+    writer_put_string(&out, " columns:\n");
     for (unsigned int i = 0; i < df->column_count; i++) {
-        printf("Column %d: %s\n", i + 1, df->columns[i]->title);
-        print_col(df->columns[i]);  // Assuming print_col() is a function to print column data
-    }
+        writer_put_string(&out, "Column ");
+        writer_put_uint(&out, i + 1);
+        writer_put_string(&out, ": ");
+        writer_put_string(&out, df->columns[i]->title);
+        writer_put_char(&out, '\n');
+        write_column_parallel(df, i, &out);
+    }
+    writer_close(&out);
 }
 
 void display_dataframe_rows(DATAFRAME *df, unsigned int rows) {
+    STAT_SCOPE(DISPLAY_DATAFRAME_ROWS, dataframe_cells(df));
     if (!df || !df->columns) {
         printf("The dataframe is empty or uninitialized.\n");
         return;
     }
     printf("Displaying up to %u rows from each of the %u columns:\n", rows, df->column_count);
+    TEXT_WRITER out;
+    open_stdout_writer(&out);
     for (unsigned int i = 0; i < df->column_count; i++) {
         COLUMN *col = df->columns[i];
-        printf("Column %d (%s):\n", i + 1, col->title);
-
-        // Print each row in the column up to the specified limit
-        for (unsigned int j = 0; j < rows && j < col->size; j++) {
-            switch (col->column_type) {
-                case INT:
-                    printf("%d: %d\n", j + 1, *((int*)col->data[j]));
-                    break;
-                case FLOAT:
-                    printf("%d: %f\n", j + 1, *((float*)col->data[j]));
-                    break;
-                case DOUBLE:
-                    printf("%d: %lf\n", j + 1, *((double*)col->data[j]));
-                    break;
-                case STRING:
-                    printf("%d: %s\n", j + 1, (char*)col->data[j]);
-                    break;
-                case STRUCTURE:
-                    CustomStructure *cs = (CustomStructure*)col->data[j];
-                    printf("%d: ID = %d, Value = %.2f\n", j + 1, cs->id, cs->value);
-                    break;
-                default:
-                    printf("%d: Unhandled data type.\n", j + 1);
-                    break;
-            }
+        writer_put_string(&out, "Column ");
+        writer_put_uint(&out, i + 1);
+        writer_put_string(&out, " (");
+        writer_put_string(&out, col->title);
+        writer_put_string(&out, "):\n");
+
+        // Print each row in the column up to the specified limit, deleted rows aside
+        for (unsigned int j = 0, shown = 0; shown < rows && j < col->size; j++) {
+            if (is_deleted_at(col, j)) continue;
+            shown++;
+            writer_put_uint(&out, j + 1);
+            writer_put_string(&out, ": ");
+            write_value(col, j, &out);
+            writer_put_char(&out, '\n');
         }
     }
+    writer_close(&out);
 }
 
 
 void add_row_to_dataframe(DATAFRAME *df, void **row_data) {
+    STAT_SCOPE(ADD_ROW_TO_DATAFRAME, df != NULL ? df->column_count : 0);
     if (!df || !df->columns) {
         printf("Dataframe is not properly initialized.\n");
         return;
     }
     for (unsigned int i = 0; i < df->column_count; i++) {
-        if (insert_value(df->columns[i], row_data[i]) != 0) {
+        if (!insert_value(df->columns[i], row_data[i])) {
             printf("Failed to insert data in column %d.\n", i + 1);
         }
     }
 }
 
+// Appends num_rows rows at once, columns_data[i] being the typed array of values for column i
+int add_rows_to_dataframe(DATAFRAME *df, void **columns_data, unsigned int num_rows) {
+    STAT_SCOPE(ADD_ROWS_TO_DATAFRAME, df != NULL ? (unsigned long long int)num_rows * df->column_count : 0);
+    if (!df || !df->columns || !columns_data) {
+        printf("Dataframe is not properly initialized.\n");
+        return -1;
+    }
+    for (unsigned int i = 0; i < df->column_count; i++) {
+        if (!column_append_n(df->columns[i], columns_data[i], num_rows)) {
+            printf("Failed to append data to column %d.\n", i + 1);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 void delete_row_from_dataframe(DATAFRAME *df, unsigned int row_index) {
-    if (!df) {
+    delete_rows_from_dataframe(df, &row_index, 1);
+}
+
+// Deletes num_rows rows given by their numbers; they are only marked, compact_dataframe removes them
+int delete_rows_from_dataframe(DATAFRAME *df, const unsigned int *rows, unsigned int num_rows) {
+    STAT_SCOPE(DELETE_ROWS_FROM_DATAFRAME, df != NULL ? (unsigned long long int)num_rows * df->column_count : 0);
+    if (!df || (!rows && num_rows > 0)) {
         printf("Dataframe is not initialized.\n");
-        return;
+        return -1;
     }
 
-    // Check each column to ensure the row index is valid before deletion
+    // Check each column to ensure the row indexes are valid before deletion
     for (unsigned int i = 0; i < df->column_count; i++) {
-        if (row_index >= df->columns[i]->size) {
-            printf("Row index %u is out of bounds for column %u.\n", row_index, i + 1);
-            return;  // If any column doesn't have enough rows, abort the operation
+        for (unsigned int k = 0; k < num_rows; k++) {
+            if (rows[k] >= df->columns[i]->size) {
+                printf("Row index %u is out of bounds for column %u.\n", rows[k], i + 1);
+                return -1;  // If any column doesn't have enough rows, abort the operation
+            }
+        }
+        if (df->columns[i]->read_only) {
+            printf("Column %u is read-only.\n", i + 1);
+            return -1;
         }
     }
 
-    // Decrease the size of each column by one, effectively hiding the last row
-    // This is a logical deletion and does not free any memory
+    // Marking a row is O(1): the values stay in place, hidden behind a cleared validity bit
     for (unsigned int i = 0; i < df->column_count; i++) {
-        df->columns[i]->size--;
+        for (unsigned int k = 0; k < num_rows; k++) {
+            if (!column_delete_row(df->columns[i], rows[k])) {
+                printf("Failed to delete row %u of column %u.\n", rows[k], i + 1);
+                return -1;
+            }
+        }
+    }
+
+    // Dead string bytes weigh against the arena like deleted rows against the column
+    if (df->auto_compact_percent > 0) {
+        for (unsigned int i = 0; i < df->column_count; i++) {
+            COLUMN *col = df->columns[i];
+            if ((unsigned long long int)col->deleted_count * 100 >= (unsigned long long int)col->size * df->auto_compact_percent ||
+                (col->strings_dead > 0 && col->strings_dead * 100 >= col->strings_size * df->auto_compact_percent)) {
+                return compact_dataframe(df);
+            }
+        }
+    }
+    return 0;
+}
+
+typedef struct compact_job {
+    DATAFRAME *df;
+    atomic_int failed;
+} COMPACT_JOB;
+
+// Compacts one column
+static void compact_column_task(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    COMPACT_JOB *job = (COMPACT_JOB *)ctx;
+    if (!column_compact(job->df->columns[task_index])) {
+        atomic_store_explicit(&job->failed, 1, memory_order_relaxed);
     }
 }
 
+// Removes the deleted rows of every column, the columns in parallel; the remaining rows are renumbered
+int compact_dataframe(DATAFRAME *df) {
+    STAT_SCOPE(COMPACT_DATAFRAME, dataframe_cells(df));
+    if (!df) {
+        printf("Dataframe is not initialized.\n");
+        return -1;
+    }
+    COMPACT_JOB job = {df, 0};
+    thread_pool_run(dataframe_pool(df), df->column_count, compact_column_task, &job);
+    if (atomic_load(&job.failed)) {
+        printf("Failed to compact the dataframe.\n");
+        return -1;
+    }
+    return 0;
+}
+
 
 void display_dataframe_columns(DATAFRAME *df, unsigned int columns) {
+    STAT_SCOPE(DISPLAY_DATAFRAME_COLUMNS, dataframe_cells(df));
     if (!df || !df->columns) {
         printf("Dataframe is empty or uninitialized.\n");
         return;
     }
     printf("Displaying the first %u columns out of %u total columns:\n", columns, df->column_count);
+    TEXT_WRITER out;
+    open_stdout_writer(&out);
     for (unsigned int i = 0; i < columns && i < df->column_count; i++) {
-        printf("Column %u (%s):\n", i + 1, df->columns[i]->title);
-        print_col(df->columns[i]);  // Assumes a function to print column data
-    }
+        writer_put_string(&out, "Column ");
+        writer_put_uint(&out, i + 1);
+        writer_put_string(&out, " (");
+        writer_put_string(&out, df->columns[i]->title);
+        writer_put_string(&out, "):\n");
+        write_column_parallel(df, i, &out);
+    }
+    writer_close(&out);
 }
 
 
 void remove_column_from_dataframe(DATAFRAME *df, unsigned int index) {
+    STAT_SCOPE(REMOVE_COLUMN_FROM_DATAFRAME, df != NULL && index < df->column_count ? df->columns[index]->size : 0);
     if (!df || index >= df->column_count) {
         printf("Invalid column index or empty dataframe.\n");
         return;
     }
     // Free the column resources
-    delete_column(df->columns[index]);  // Assumes free_column correctly frees all column data
+    delete_column(&df->columns[index]);  // Assumes free_column correctly frees all column data
 
     // Shift all columns to the left to fill the gap
     for (unsigned int i = index; i < df->column_count - 1; i++) {
@@ -297,29 +565,81 @@ void rename_column_title(DATAFRAME *df, unsigned int column_index, const char *n
         printf("Invalid column index or new title.\n");
         return;
     }
-    char *new_title_copy = strdup(new_title);
+    COLUMN *col = df->columns[column_index];
+    char *new_title_copy = col->arena ? arena_strdup(col->arena, new_title) : strdup(new_title);
     if (!new_title_copy) {
         printf("Failed to allocate memory for new title.\n");
         return;
     }
-    free(df->columns[column_index]->title);
-    df->columns[column_index]->title = new_title_copy;
+    if (!col->arena) free(col->title);
+    col->title = new_title_copy;
 }
 
 
+typedef struct existence_job {
+    DATAFRAME *df;
+    void *value;
+    MORSEL *morsels;
+    const unsigned char *answered;  // 1 for the columns already answered by an index
+    atomic_int found;
+} EXISTENCE_JOB;
+
+// Looks for the value in one morsel, skipped as soon as any worker has found it
+static void find_value_in_morsel(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    EXISTENCE_JOB *job = (EXISTENCE_JOB *)ctx;
+    if (atomic_load_explicit(&job->found, memory_order_relaxed)) return;
+    MORSEL m = job->morsels[task_index];
+    if (job->answered[m.column]) return;
+    COLUMN *col = job->df->columns[m.column];
+    COMPARE_COUNTS counts = {0, 0, 0};
+    zone_map_scan(col, m.start, m.end, job->value, &counts);
+    if (counts.equal > 0) {
+        atomic_store_explicit(&job->found, 1, memory_order_relaxed);
+    }
+}
+
 int check_value_existence(DATAFRAME *df, void *value) {
+    STAT_SCOPE(CHECK_VALUE_EXISTENCE, dataframe_cells(df));
     if (!df || !value) {
         printf("Invalid dataframe or value.\n");
         return 0;
     }
+    unsigned char *answered = (unsigned char *)calloc(df->column_count + 1, 1);
+    if (!answered) {
+        printf("Memory allocation failed for the scan.\n");
+        return 0;
+    }
+    // Columns with a hash index answer first in O(1), then those with a sorted index in O(log n)
     for (unsigned int i = 0; i < df->column_count; i++) {
-        for (unsigned int j = 0; j < df->columns[i]->size; j++) {
-            if (compare_values(df->columns[i]->column_type, df->columns[i]->data[j], value) == 0) {
-                return 1;  // Value found
-            }
+        unsigned long long int equal;
+        COMPARE_COUNTS counts;
+        if (hash_index_count(df->columns[i], value, &equal)) {
+            answered[i] = 1;
+        } else if (count_compare_with_index(df->columns[i], value, &counts)) {
+            answered[i] = 1;
+            equal = counts.equal;
+        } else {
+            continue;
         }
+        if (equal > 0) {
+            free(answered);
+            return 1;  // Value found
+        }
+    }
+
+    unsigned int count;
+    MORSEL *morsels = split_into_morsels(df, 0, df->column_count, &count);
+    if (!morsels) {
+        free(answered);
+        printf("Memory allocation failed for the scan.\n");
+        return 0;
     }
-    return 0;  // Value not found
+    EXISTENCE_JOB job = {df, value, morsels, answered, 0};
+    thread_pool_run(dataframe_pool(df), count, find_value_in_morsel, &job);
+    free(morsels);
+    free(answered);
+    return atomic_load(&job.found);  // 1 if the value was found
 }
 
 
@@ -328,47 +648,16 @@ void *get_cell_value(DATAFRAME *df, unsigned int row, unsigned int column) {
         printf("Invalid row or column index.\n");
         return NULL;
     }
-    return df->columns[column]->data[row];
+    return get_value_at(df->columns[column], row);
 }
 
 void set_cell_value(DATAFRAME *df, unsigned int row, unsigned int column, void *value) {
-    if (!df || column >= df->column_count || row >= df->columns[column]->size || !value) {
-        printf("Invalid row or column index, or null value provided.\n");
+    if (!df || column >= df->column_count || row >= df->columns[column]->size) {
+        printf("Invalid row or column index.\n");
         return;
     }
-
-    // Free the current memory if necessary
-    if (df->columns[column]->column_type == STRING) {
-        free(df->columns[column]->data[row]);  // Only free if it's a string or similarly dynamically allocated type
-    }
-
-    // Assign the new value based on the type
-    switch (df->columns[column]->column_type) {
-        case INT:
-            // Assuming value is a pointer to the integer to be assigned
-            *(int *)(df->columns[column]->data[row]) = *(int *)value;
-            break;
-        case FLOAT:
-            *(float *)(df->columns[column]->data[row]) = *(float *)value;
-            break;
-        case DOUBLE:
-            *(double *)(df->columns[column]->data[row]) = *(double *)value;
-            break;
-        case STRING:
-            // Duplicate the string to handle it safely
-            df->columns[column]->data[row] = strdup((char *)value);
-            break;
-        case STRUCTURE:
-            // If value is assumed to be a pointer to CustomStructure, allocate new memory and copy the data
-            df->columns[column]->data[row] = malloc(sizeof(CustomStructure));
-            if (df->columns[column]->data[row]) {
-                memcpy(df->columns[column]->data[row], value, sizeof(CustomStructure));
-            } else {
-                printf("Memory allocation failed for structure.\n");
-            }
-        default:
-            printf("Unhandled data type.\n");
-            break;
+    if (!set_value_at(df->columns[column], row, value)) {
+        printf("Failed to set the cell value.\n");
     }
 }
 
@@ -389,7 +678,7 @@ void display_row_count(DATAFRAME *df) {
     if (!df || df->column_count == 0 || !df->columns[0]) {
         printf("Dataframe is empty or not properly initialized.\n");
     } else {
-        printf("Number of rows: %u\n", df->columns[0]->size);
+        printf("Number of rows: %u\n", df->columns[0]->size - df->columns[0]->deleted_count);
     }
 }
 
@@ -402,37 +691,216 @@ void display_column_count(DATAFRAME *df) {
 }
 
 int count_cells_equal_to(DATAFRAME *df, void *value) {
-    int count = 0;
+    COMPARE_COUNTS total;
+    count_cells_compare(df, value, NULL, &total);
+    return (int)total.equal;
+}
+
+int count_cells_greater_than(DATAFRAME *df, void *value) {
+    COMPARE_COUNTS total;
+    count_cells_compare(df, value, NULL, &total);
+    return (int)total.greater;
+}
+
+int count_cells_less_than(DATAFRAME *df, void *value) {
+    COMPARE_COUNTS total;
+    count_cells_compare(df, value, NULL, &total);
+    return (int)total.less;
+}
+
+typedef struct compare_job {
+    DATAFRAME *df;
+    void *value;
+    MORSEL *morsels;
+    COMPARE_COUNTS *partials;  // One row of column_count counts per worker
+} COMPARE_JOB;
+
+// Scans one morsel into the partial counts of the worker running it
+static void compare_morsel(void *ctx, unsigned int task_index, unsigned int worker) {
+    COMPARE_JOB *job = (COMPARE_JOB *)ctx;
+    MORSEL m = job->morsels[task_index];
+    COLUMN *col = job->df->columns[m.column];
+    zone_map_scan(col, m.start, m.end, job->value,
+                  &job->partials[(size_t)worker * job->df->column_count + m.column]);
+}
+
+// Counts the cells less than, equal to and greater than a value in one scan of every column
+// The columns are split into row morsels scanned in parallel; per_column (column_count entries) and total are optional
+void count_cells_compare(DATAFRAME *df, void *value, COMPARE_COUNTS *per_column, COMPARE_COUNTS *total) {
+    STAT_SCOPE(COUNT_CELLS_COMPARE, dataframe_cells(df));
+    if (total) total->less = total->equal = total->greater = 0;
+    if (!df || !value || df->column_count == 0) return;
+
+    THREAD_POOL *pool = dataframe_pool(df);
+    unsigned int workers = thread_pool_size(pool);
+    unsigned int count;
+    MORSEL *morsels = split_into_morsels(df, 0, df->column_count, &count);
+    COMPARE_COUNTS *partials = (COMPARE_COUNTS *)calloc((size_t)workers * df->column_count, sizeof(COMPARE_COUNTS));
+    if (!morsels || !partials) {
+        printf("Memory allocation failed for the scan.\n");
+        free(morsels);
+        free(partials);
+        return;
+    }
+
+    // Columns with a sorted index are answered by binary search, only the others are scanned
+    COMPARE_COUNTS *indexed = (COMPARE_COUNTS *)calloc(df->column_count, sizeof(COMPARE_COUNTS));
+    char *is_indexed = (char *)calloc(df->column_count, 1);
+    if (indexed && is_indexed) {
+        for (unsigned int i = 0; i < df->column_count; i++) {
+            is_indexed[i] = (char)count_compare_with_index(df->columns[i], value, &indexed[i]);
+        }
+        unsigned int kept = 0;
+        for (unsigned int k = 0; k < count; k++) {
+            if (!is_indexed[morsels[k].column]) morsels[kept++] = morsels[k];
+        }
+        count = kept;
+        for (unsigned int i = 0; i < df->column_count; i++) {
+            partials[i] = indexed[i];  // Worker 0 row, the scans add to it
+        }
+    }
+    free(indexed);
+    free(is_indexed);
+
+    COMPARE_JOB job = {df, value, morsels, partials};
+    thread_pool_run(pool, count, compare_morsel, &job);
+
+    // Merge the per-worker partial counts
     for (unsigned int i = 0; i < df->column_count; i++) {
-        for (unsigned int j = 0; j < df->columns[i]->size; j++) {
-            if (compare_values(df->columns[i]->column_type, df->columns[i]->data[j], value) == 0) {
-                count++;
-            }
+        COMPARE_COUNTS counts = {0, 0, 0};
+        for (unsigned int w = 0; w < workers; w++) {
+            COMPARE_COUNTS *partial = &partials[(size_t)w * df->column_count + i];
+            counts.less += partial->less;
+            counts.equal += partial->equal;
+            counts.greater += partial->greater;
+        }
+        if (per_column) per_column[i] = counts;
+        if (total) {
+            total->less += counts.less;
+            total->equal += counts.equal;
+            total->greater += counts.greater;
         }
     }
-    return count;
+    free(partials);
+    free(morsels);
 }
 
-int count_cells_greater_than(DATAFRAME *df, void *value) {
-    int count = 0;
+typedef struct histogram_job {
+    DATAFRAME *df;
+    void **pivots;
+    unsigned int num_pivots;
+    MORSEL *morsels;
+    unsigned long long int *partials;  // One row of column_count histograms per worker
+    atomic_int failed;
+} HISTOGRAM_JOB;
+
+// Buckets one morsel into the partial histogram of the worker running it
+static void histogram_morsel(void *ctx, unsigned int task_index, unsigned int worker) {
+    HISTOGRAM_JOB *job = (HISTOGRAM_JOB *)ctx;
+    MORSEL m = job->morsels[task_index];
+    size_t buckets = (size_t)job->num_pivots + 1;
+    unsigned long long int *counts = &job->partials[((size_t)worker * job->df->column_count + m.column) * buckets];
+    if (!column_histogram_range(job->df->columns[m.column], m.start, m.end, job->pivots, job->num_pivots, counts)) {
+        atomic_store_explicit(&job->failed, 1, memory_order_relaxed);
+    }
+}
+
+// Buckets every cell over ascending pivots in one scan of every column
+// The columns are split into row morsels bucketed in parallel like count_cells_compare
+// per_column holds column_count rows of num_pivots + 1 buckets, total num_pivots + 1 buckets; both are optional
+int count_cells_histogram(DATAFRAME *df, void **pivots, unsigned int num_pivots,
+                          unsigned long long int *per_column, unsigned long long int *total) {
+    STAT_SCOPE(COUNT_CELLS_HISTOGRAM, dataframe_cells(df));
+    if (!df || (pivots == NULL && num_pivots > 0)) return -1;
+    size_t buckets = (size_t)num_pivots + 1;
+    if (total) memset(total, 0, buckets * sizeof(unsigned long long int));
+    if (df->column_count == 0) return 0;
+
+    THREAD_POOL *pool = dataframe_pool(df);
+    unsigned int workers = thread_pool_size(pool);
+    unsigned int count;
+    MORSEL *morsels = split_into_morsels(df, 0, df->column_count, &count);
+    unsigned long long int *partials = (unsigned long long int *)calloc((size_t)workers * df->column_count * buckets,
+                                                                        sizeof(unsigned long long int));
+    if (!morsels || !partials) {
+        printf("Memory allocation failed for the histogram.\n");
+        free(morsels);
+        free(partials);
+        return -1;
+    }
+
+    HISTOGRAM_JOB job = {df, pivots, num_pivots, morsels, partials, 0};
+    thread_pool_run(pool, count, histogram_morsel, &job);
+    if (atomic_load(&job.failed)) {
+        printf("Memory allocation failed for the histogram.\n");
+        free(partials);
+        free(morsels);
+        return -1;
+    }
+
+    // Merge the per-worker partial histograms
     for (unsigned int i = 0; i < df->column_count; i++) {
-        for (unsigned int j = 0; j < df->columns[i]->size; j++) {
-            if (compare_values(df->columns[i]->column_type, df->columns[i]->data[j], value) > 0) {
-                count++;
-            }
+        for (size_t b = 0; b < buckets; b++) {
+            unsigned long long int counts = 0;
+            for (unsigned int w = 0; w < workers; w++) counts += partials[((size_t)w * df->column_count + i) * buckets + b];
+            if (per_column) per_column[(size_t)i * buckets + b] = counts;
+            if (total) total[b] += counts;
         }
     }
-    return count;
+    free(partials);
+    free(morsels);
+    return 0;
 }
 
-int count_cells_less_than(DATAFRAME *df, void *value) {
-    int count = 0;
+typedef struct reduce_job {
+    DATAFRAME *df;
+    MORSEL *morsels;
+    REDUCTION *partials;  // One per morsel
+} REDUCE_JOB;
+
+static void reduce_morsel(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    REDUCE_JOB *job = (REDUCE_JOB *)ctx;
+    MORSEL m = job->morsels[task_index];
+    COLUMN *col = job->df->columns[m.column];
+    reduce_kernel(col->values, col->validity, m.start, m.end, &job->partials[task_index]);
+}
+
+// Reduces every numeric column in one parallel pass over their segments, like column_aggregate for each of them
+// per_column receives column_count entries; those of the other columns have no value; returns 0 on success
+int dataframe_aggregate(DATAFRAME *df, SUM_MODE mode, COLUMN_AGGREGATES *per_column) {
+    STAT_SCOPE(DATAFRAME_AGGREGATE, dataframe_cells(df));
+    if (!df || !per_column) return -1;
+    unsigned int count;
+    MORSEL *morsels = split_into_morsels(df, 0, df->column_count, &count);
+    REDUCTION *partials = (REDUCTION *)malloc((count > 0 ? count : 1) * sizeof(REDUCTION));
+    if (!morsels || !partials) {
+        printf("Memory allocation failed for the aggregates.\n");
+        free(morsels);
+        free(partials);
+        return -1;
+    }
+    unsigned int kept = 0;
+    for (unsigned int k = 0; k < count; k++) {
+        COLUMN *col = df->columns[morsels[k].column];
+        if (!has_reduce_kernel(col->column_type)) continue;
+        morsels[kept] = morsels[k];
+        reduction_init(&partials[kept], col->column_type, mode);
+        kept++;
+    }
+
+    REDUCE_JOB job = {df, morsels, partials};
+    thread_pool_run(dataframe_pool(df), kept, reduce_morsel, &job);
+
+    // Morsels are in column then row order, so each column merges its segments in the order column_aggregate does
+    unsigned int k = 0;
     for (unsigned int i = 0; i < df->column_count; i++) {
-        for (unsigned int j = 0; j < df->columns[i]->size; j++) {
-            if (compare_values(df->columns[i]->column_type, df->columns[i]->data[j], value) < 0) {
-                count++;
-            }
-        }
+        REDUCTION total;
+        reduction_init(&total, df->columns[i]->column_type, mode);
+        for (; k < kept && morsels[k].column == i; k++) reduction_merge(&total, &partials[k]);
+        reduction_finish(&total, &per_column[i]);
     }
-    return count;
+    free(partials);
+    free(morsels);
+    return 0;
 }
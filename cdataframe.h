@@ -2,21 +2,31 @@
 #define CDATAFRAME_H
 
 #include "column.h"
+#include "threadpool.h"
 
 // Structure for a dataframe
 typedef struct dataframe {
     COLUMN **columns;         // Array of pointers to COLUMN
     unsigned int column_count;  // Number of columns in the dataframe
     unsigned int max_columns;   // Maximum capacity of columns array
+    THREAD_POOL *pool;          // Pool owned by the dataframe, NULL to use the process-wide pool
+    const char *mapping;        // File the read-only columns are mapped from (open_dataframe), NULL otherwise
+    size_t mapping_size;
+    unsigned int auto_compact_percent;  // Compact once a column has this percentage of deleted rows or dead string bytes, 0 (default) to never
+    ARENA *arena;               // Allocation arena of the columns made by add_new_column_to_dataframe, NULL for the heap
 } DATAFRAME;
 
 // Function prototypes for managing the dataframe
 DATAFRAME *create_dataframe();
+DATAFRAME *create_arena_dataframe(size_t block_size);
+COLUMN *add_new_column_to_dataframe(DATAFRAME *df, ENUM_TYPE type, char *title);
 void fill_dataframe_from_user(DATAFRAME *df);
 void hard_fill_dataframe(DATAFRAME *df, void **data, unsigned int num_rows, unsigned int num_columns);
 ENUM_TYPE parse_type(const char *typeStr);
 void *read_data_based_on_type(ENUM_TYPE type);
 void free_dataframe(DATAFRAME *df);
+int set_dataframe_thread_count(DATAFRAME *df, unsigned int num_threads);
+void dataframe_memory_usage(const DATAFRAME *df, MEMORY_USAGE *usage);
 
 
 // Function prototypes for displaying the dataframe
@@ -26,7 +36,10 @@ void display_dataframe_columns(DATAFRAME *df, unsigned int columns);
 
 // Function prototypes for usual operations
 void add_row_to_dataframe(DATAFRAME *df, void **row_data);
+int add_rows_to_dataframe(DATAFRAME *df, void **columns_data, unsigned int num_rows);
 void delete_row_from_dataframe(DATAFRAME *df, unsigned int row_index);
+int delete_rows_from_dataframe(DATAFRAME *df, const unsigned int *rows, unsigned int num_rows);
+int compact_dataframe(DATAFRAME *df);
 int add_column_to_dataframe(DATAFRAME *df, COLUMN *col);
 void remove_column_from_dataframe(DATAFRAME *df, unsigned int index);
 void rename_column_title(DATAFRAME *df, unsigned int column_index, const char *new_title);
@@ -41,5 +54,9 @@ void display_column_count(DATAFRAME *df);
 int count_cells_equal_to(DATAFRAME *df, void *value);
 int count_cells_greater_than(DATAFRAME *df, void *value);
 int count_cells_less_than(DATAFRAME *df, void *value);
+void count_cells_compare(DATAFRAME *df, void *value, COMPARE_COUNTS *per_column, COMPARE_COUNTS *total);
+int count_cells_histogram(DATAFRAME *df, void **pivots, unsigned int num_pivots,
+                          unsigned long long int *per_column, unsigned long long int *total);
+int dataframe_aggregate(DATAFRAME *df, SUM_MODE mode, COLUMN_AGGREGATES *per_column);
 
 #endif // CDATAFRAME_H
@@ -1,23 +1,61 @@
 #include "column.h"
+#include "memory.h"
+#include "arena.h"
+#include "bitmap.h"
+#include "hashindex.h"
+#include "zonemap.h"
+#include "kernels.h"
+#include "writer.h"
+#include "stats.h"
+#include "threadpool.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 
 #define REALOC_SIZE 256
+// Smallest string arena set_value_at repacks, below it the dead bytes are not worth a pass over the column
+#define STRINGS_REPACK_MIN (REALOC_SIZE * 16)
 
 
+// Width in bytes of a fixed-width type, 0 for STRING and NULLVAL
+size_t type_size(ENUM_TYPE type) {
+    switch (type) {
+        case UINT:
+            return sizeof(unsigned int);
+        case INT:
+            return sizeof(int);
+        case CHAR:
+            return sizeof(char);
+        case FLOAT:
+            return sizeof(float);
+        case DOUBLE:
+            return sizeof(double);
+        case STRUCTURE:
+            return sizeof(CustomStructure);
+        default:
+            return 0;
+    }
+}
 
 // Create a new column with specified type and title
 COLUMN *create_column(ENUM_TYPE type, char *title) {
-    COLUMN *col = (COLUMN *)malloc(sizeof(COLUMN));
+    return create_arena_column(NULL, type, title);
+}
+
+// Create a new column whose struct, title and buffers come from an arena (NULL for the heap)
+COLUMN *create_arena_column(ARENA *arena, ENUM_TYPE type, char *title) {
+    STAT_SCOPE(CREATE_COLUMN, 0);
+    COLUMN *col = arena != NULL ? (COLUMN *)arena_alloc(arena, sizeof(COLUMN)) : (COLUMN *)malloc(sizeof(COLUMN));
     if (col == NULL) {
         fprintf(stderr, "Failed to allocate memory for column structure.\n");
         return NULL;
     }
 
-    col->title = strdup(title); // Duplicate the title for the column
+    col->title = arena != NULL ? arena_strdup(arena, title) : strdup(title); // Duplicate the title for the column
     if (col->title == NULL) {
-        free(col);
+        if (arena == NULL) free(col);
         fprintf(stderr, "Failed to allocate memory for column title.\n");
         return NULL;
     }
@@ -25,71 +63,617 @@ COLUMN *create_column(ENUM_TYPE type, char *title) {
     col->size = 0;
     col->max_size = 0;
     col->column_type = type;
-    col->data = NULL; // Initialize data pointer as NULL
+    col->ops = get_column_ops(type);
+    col->values = NULL; // Initialize data pointer as NULL
+    col->elem_size = type == STRING ? sizeof(unsigned long long int) : type_size(type);
+    col->strings = NULL;
+    col->strings_size = 0;
+    col->strings_capacity = 0;
+    col->strings_dead = 0;
+    col->validity = NULL; // No bitmap until the first null is stored
+    col->deleted = NULL; // No bitmap until the first deletion
+    col->deleted_count = 0;
     col->index = NULL; // Indexing not handled at creation
+    col->valid_index = 0;
+    col->sort_dir = ASC;
+    col->zones = NULL; // Allocated with the value buffer
+    col->hash_index = NULL; // Built on demand by build_hash_index
+    col->read_only = 0;
+    col->arena = arena;
 
     return col;
 }
 
-// Function to insert a value into the column
-int insert_value(COLUMN *col, void *value) {
-    if (col->size >= col->max_size) {
-        size_t new_max_size = col->max_size == 0 ? REALOC_SIZE : col->max_size + REALOC_SIZE;
-        COL_TYPE **new_data = (COL_TYPE **)realloc(col->data, new_max_size * sizeof(COL_TYPE *));
-        if (!new_data) {
+// Function to resize a buffer of a column (values, strings, bitmaps or index), from its arena if it has one
+void *column_buffer_realloc(COLUMN *col, void *ptr, size_t old_size, size_t new_size) {
+    if (col->arena != NULL) return arena_realloc(col->arena, ptr, old_size, new_size);
+    return aligned_buffer_realloc(ptr, old_size, new_size);
+}
+
+// Function to release a buffer of a column, arena buffers go away with their arena
+void column_buffer_free(COLUMN *col, void *ptr) {
+    if (col->arena == NULL) aligned_buffer_free(ptr);
+}
+
+// Report a change attempted on a column mapped from a file
+static int check_writable(const COLUMN *col) {
+    if (col->read_only) {
+        fprintf(stderr, "Column '%s' is read-only.\n", col->title);
+        return 0;
+    }
+    return 1;
+}
+
+// Grow the storage of a column so that it can hold at least capacity values
+// The capacity at least doubles on each growth so that appends stay amortized O(1)
+static int grow_column(COLUMN *col, size_t capacity) {
+    if (capacity <= col->max_size) return 1;
+    if (!check_writable(col)) return 0;
+    if (capacity > UINT_MAX) {
+        fprintf(stderr, "Column capacity overflow.\n");
+        return 0;
+    }
+
+    size_t new_max_size = col->max_size == 0 ? REALOC_SIZE : (size_t)col->max_size * 2;
+    if (new_max_size < capacity) new_max_size = capacity;
+    if (new_max_size > SEGMENT_ROWS) new_max_size = (new_max_size + SEGMENT_ROWS - 1) / SEGMENT_ROWS * SEGMENT_ROWS;
+    if (new_max_size > UINT_MAX) new_max_size = UINT_MAX;
+
+    if (col->elem_size > 0) {
+        void *new_values = column_buffer_realloc(col, col->values, col->max_size * col->elem_size,
+                                                 new_max_size * col->elem_size);
+        if (!new_values) {
             fprintf(stderr, "Memory reallocation failed.\n");
             return 0;
         }
-        col->data = new_data;
-        col->max_size = new_max_size;
+        col->values = new_values;
+    }
+    if (col->index != NULL) {
+        unsigned long long int *new_index = (unsigned long long int *)column_buffer_realloc(
+                col, col->index, col->max_size * sizeof(unsigned long long int),
+                new_max_size * sizeof(unsigned long long int));
+        if (!new_index) {
+            fprintf(stderr, "Index reallocation failed.\n");
+            return 0;
+        }
+        col->index = new_index;
+    }
+    if (col->validity != NULL) {
+        size_t old_words = bitmap_words(col->max_size), new_words = bitmap_words(new_max_size);
+        unsigned long long int *new_validity = (unsigned long long int *)column_buffer_realloc(
+                col, col->validity, old_words * sizeof(unsigned long long int),
+                new_words * sizeof(unsigned long long int));
+        if (!new_validity) {
+            fprintf(stderr, "Validity bitmap reallocation failed.\n");
+            return 0;
+        }
+        // Rows past the logical size are kept marked valid
+        memset(new_validity + old_words, 0xFF, (new_words - old_words) * sizeof(unsigned long long int));
+        col->validity = new_validity;
+    }
+    if (col->deleted != NULL) {
+        size_t old_words = bitmap_words(col->max_size), new_words = bitmap_words(new_max_size);
+        unsigned long long int *new_deleted = (unsigned long long int *)column_buffer_realloc(
+                col, col->deleted, old_words * sizeof(unsigned long long int),
+                new_words * sizeof(unsigned long long int));
+        if (!new_deleted) {
+            fprintf(stderr, "Deletion bitmap reallocation failed.\n");
+            return 0;
+        }
+        memset(new_deleted + old_words, 0, (new_words - old_words) * sizeof(unsigned long long int));
+        col->deleted = new_deleted;
     }
+    if (!zone_map_reserve(col, new_max_size)) return 0;
+    col->max_size = new_max_size;
+    return 1;
+}
 
-    // Allocate memory for the new value based on the type of the column
-    void *new_value = NULL;
-    switch (col->column_type) {
-        case UINT:
-            new_value = malloc(sizeof(unsigned int));
-            if (new_value) *(unsigned int *)new_value = *(unsigned int *)value;
-            break;
-        case INT:
-            new_value = malloc(sizeof(int));
-            if (new_value) *(int *)new_value = *(int *)value;
-            break;
-        case CHAR:
-            new_value = malloc(sizeof(char));
-            if (new_value) *(char *)new_value = *(char *)value;
-            break;
-        case FLOAT:
-            new_value = malloc(sizeof(float));
-            if (new_value) *(float *)new_value = *(float *)value;
-            break;
-        case DOUBLE:
-            new_value = malloc(sizeof(double));
-            if (new_value) *(double *)new_value = *(double *)value;
-            break;
-        case STRING:
-            new_value = strdup((char *)value);
-            break;
-        case STRUCTURE:
-            new_value = malloc(sizeof(struct CustomStructure));  // Assuming CustomStructure is defined elsewhere
-            if (new_value) memcpy(new_value, value, sizeof(struct CustomStructure));
-            break;
-        default:
-            fprintf(stderr, "Unsupported type for insertion.\n");
+// Record whether a row holds a value, creating the validity bitmap on the first null
+static int set_validity(COLUMN *col, unsigned int index, int valid) {
+    if (col->validity == NULL) {
+        if (valid) return 1;
+        size_t words = bitmap_words(col->max_size);
+        col->validity = (unsigned long long int *)column_buffer_realloc(col, NULL, 0,
+                                                                        words * sizeof(unsigned long long int));
+        if (!col->validity) {
+            fprintf(stderr, "Failed to allocate the validity bitmap.\n");
             return 0;
+        }
+        memset(col->validity, 0xFF, words * sizeof(unsigned long long int));
     }
+    if (valid) {
+        bitmap_set(col->validity, index);
+    } else {
+        bitmap_clear(col->validity, index);
+    }
+    return 1;
+}
+
+// Function to make room for at least extra more bytes in the string arena of a STRING column
+int column_reserve_strings(COLUMN *col, size_t extra) {
+    size_t needed = col->strings_size + extra;
+    if (needed <= col->strings_capacity) return 1;
+    if (!check_writable(col)) return 0;
 
-    if (!new_value) {
-        fprintf(stderr, "Memory allocation for new value failed.\n");
+    size_t new_capacity = col->strings_capacity == 0 ? REALOC_SIZE * 16 : col->strings_capacity * 2;
+    if (new_capacity < needed) new_capacity = needed;
+    char *new_strings = (char *)column_buffer_realloc(col, col->strings, col->strings_size, new_capacity);
+    if (!new_strings) {
+        fprintf(stderr, "String arena reallocation failed.\n");
         return 0;
     }
+    col->strings = new_strings;
+    col->strings_capacity = new_capacity;
+    return 1;
+}
+
+// Function to copy a string at the end of the arena and return its offset, room must have been reserved
+unsigned long long int column_append_string(COLUMN *col, const char *str, size_t length) {
+    unsigned long long int offset = col->strings_size;
+    memcpy(col->strings + offset, str, length + 1);
+    col->strings_size += length + 1;
+    return offset;
+}
+
+// Count the string of a row as dead bytes of the arena once the row no longer refers to it
+static void release_string(COLUMN *col, unsigned int index) {
+    if (col->column_type == STRING && !is_null_at(col, index)) {
+        col->strings_dead += strlen(col->strings + ((unsigned long long int *)col->values)[index]) + 1;
+    }
+}
+
+// Function to reserve room for at least capacity values in the column
+int column_reserve(COLUMN *col, unsigned int capacity) {
+    STAT_SCOPE(COLUMN_RESERVE, 0);
+    if (col == NULL) return 0;
+    return grow_column(col, capacity);
+}
+
+// Number of non-null rows among the n first entries of the index, found by binary search since nulls are last
+static unsigned int indexed_valid_count(COLUMN *col, unsigned int n) {
+    if (col->validity == NULL) return n;
+    unsigned int lo = 0, hi = n;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if (is_null_at(col, (unsigned int)col->index[mid])) hi = mid; else lo = mid + 1;
+    }
+    return lo;
+}
 
-    col->data[col->size++] = new_value;
+// Whether a floating value is NaN, which compares equal to everything and so cannot be binary searched
+static int is_nan_value(ENUM_TYPE type, const void *value) {
+    if (type == FLOAT) return *(const float *)value != *(const float *)value;
+    if (type == DOUBLE) return *(const double *)value != *(const double *)value;
+    if (type == STRUCTURE) return ((const CustomStructure *)value)->value != ((const CustomStructure *)value)->value;
+    return 0;
+}
+
+// Keep the index valid after the row size - 1 has been appended, or drop it when the new value breaks the order
+static void repair_index_after_append(COLUMN *col) {
+    if (!col->valid_index) return;
+    unsigned int row = col->size - 1;
+    unsigned int valid = indexed_valid_count(col, row);  // The new row is not in the index yet
+
+    if (!is_null_at(col, row)) {
+        // A NaN compares equal to everything, so the order cannot be checked against it and the index is dropped
+        void *value = get_value_at(col, row);
+        if (is_nan_value(col->column_type, value) ||
+            (valid > 0 && is_nan_value(col->column_type, get_value_at(col, (unsigned int)col->index[valid - 1])))) {
+            col->valid_index = 0;
+            return;
+        }
+        // The new row goes after every valid row, so it must not sort before the last one
+        if (valid > 0) {
+            int cmp = col->ops->compare(value, get_value_at(col, (unsigned int)col->index[valid - 1]));
+            if (col->sort_dir == DESC) cmp = -cmp;
+            if (cmp < 0) {
+                col->valid_index = 0;
+                return;
+            }
+        }
+        memmove(col->index + valid + 1, col->index + valid, (size_t)(row - valid) * sizeof(unsigned long long int));
+        col->index[valid] = row;
+    } else {
+        // Nulls are kept in row order at the end
+        col->index[row] = row;
+    }
+}
+
+// Offset of a pointer inside the value buffer of a column, or the buffer size when it points elsewhere
+// A value read from the column itself (get_value_at) is found again by its offset once the buffer has moved
+static size_t value_buffer_offset(const COLUMN *col, const void *p) {
+    size_t bytes = (size_t)col->max_size * col->elem_size;
+    size_t offset = (uintptr_t)p - (uintptr_t)col->values;
+    return col->values != NULL && offset < bytes ? offset : bytes;
+}
+
+// Function to insert a value into the column, a NULL value inserts a null cell
+int insert_value(COLUMN *col, void *value) {
+    STAT_SCOPE(INSERT_VALUE, 1);
+    if (col->size >= col->max_size) {
+        // STRING values live in the arena, which string_copy takes care of
+        size_t bytes = (size_t)col->max_size * col->elem_size;
+        size_t offset = value != NULL && col->column_type != STRING ? value_buffer_offset(col, value) : bytes;
+        if (!grow_column(col, (size_t)col->size + 1)) return 0;
+        if (offset < bytes) value = (char *)col->values + offset;
+    }
+
+    // Every cell of a NULLVAL column is null
+    if (col->column_type == NULLVAL) value = NULL;
+
+    if (value == NULL) {
+        // Null cells keep zeroed storage so that the buffers stay fully initialized
+        if (col->elem_size > 0) {
+            memset((char *)col->values + (size_t)col->size * col->elem_size, 0, col->elem_size);
+        }
+    } else if (!col->ops->copy(col, col->size, value)) {
+        return 0;
+    }
+
+    if (!set_validity(col, col->size, value != NULL)) return 0;
+    col->size++;
+    repair_index_after_append(col);
+    zone_map_add_row(col, col->size - 1);
+    return hash_index_add_row(col, col->size - 1);
+}
+
+// Append n values from a typed array, the rows null_rows[0..null_count) of the batch (ascending) being nulls
+// Their validity bits are cleared before the zone map and the hash index see the rows
+static int append_values(COLUMN *col, const void *values, unsigned int n, const unsigned int *null_rows,
+                         unsigned int null_count) {
+    STAT_SCOPE(COLUMN_APPEND_N, n);
+    if (col == NULL || (values == NULL && n > 0) || (null_rows == NULL && null_count > 0)) return 0;
+    size_t bytes = (size_t)col->max_size * col->elem_size;
+    size_t offset = col->column_type != STRING ? value_buffer_offset(col, values) : bytes;
+    if (!grow_column(col, (size_t)col->size + n)) return 0;
+    if (offset < bytes) values = (const char *)col->values + offset;
+    if (n > 0) col->valid_index = 0;
+    unsigned int first = col->size;
+
+    if (col->column_type == STRING) {
+        // Size the arena once for the whole batch
+        char *const *strs = (char *const *)values;
+        size_t total = 0;
+        for (unsigned int i = 0, k = 0; i < n; i++) {
+            if (k < null_count && null_rows[k] == i) {
+                k++;
+            } else if (strs[i] != NULL) {
+                total += strlen(strs[i]) + 1;
+            }
+        }
+        // Strings of the arena itself are found again by their offset once the arena has moved
+        uintptr_t old_strings = (uintptr_t)col->strings;
+        size_t old_size = col->strings != NULL ? col->strings_size : 0;
+        if (!column_reserve_strings(col, total)) return 0;
+        unsigned long long int *offsets = (unsigned long long int *)col->values;
+        for (unsigned int i = 0, k = 0; i < n; i++) {
+            const char *str = strs[i];
+            if (k < null_count && null_rows[k] == i) {
+                str = NULL;
+                k++;
+            } else if (str != NULL && (uintptr_t)str - old_strings < old_size) {
+                str = col->strings + ((uintptr_t)str - old_strings);
+            }
+            if (!set_validity(col, col->size, str != NULL)) return 0;
+            offsets[col->size++] = str != NULL ? column_append_string(col, str, strlen(str)) : 0;
+        }
+    } else if (col->elem_size == 0) {
+        for (unsigned int i = 0; i < n; i++) {
+            if (!insert_value(col, NULL)) return 0;
+        }
+        return 1;
+    } else {
+        char *dst = (char *)col->values + (size_t)col->size * col->elem_size;
+        memmove(dst, values, (size_t)n * col->elem_size);
+        if (col->validity != NULL) {
+            for (unsigned int i = 0; i < n; i++) {
+                bitmap_set(col->validity, (size_t)col->size + i);
+            }
+        }
+        // Null cells keep zeroed storage so that the buffers stay fully initialized
+        for (unsigned int k = 0; k < null_count; k++) {
+            if (null_rows[k] >= n) return 0;
+            memset(dst + (size_t)null_rows[k] * col->elem_size, 0, col->elem_size);
+            if (!set_validity(col, col->size + null_rows[k], 0)) return 0;
+        }
+        col->size += n;
+    }
+
+    for (unsigned int i = first; i < col->size; i++) {
+        zone_map_add_row(col, i);
+        if (!hash_index_add_row(col, i)) return 0;
+    }
+    return 1;
+}
+
+// Function to append n values from a typed array in one call
+// values points to n unsigned int/int/char/float/double/CustomStructure, or n char * for STRING (NULL entries are nulls)
+int column_append_n(COLUMN *col, const void *values, unsigned int n) {
+    return append_values(col, values, n, NULL, 0);
+}
+
+// Function to append n values from a typed array in one call, some of them being nulls
+int column_append_n_nulls(COLUMN *col, const void *values, unsigned int n, const unsigned int *null_rows,
+                          unsigned int null_count) {
+    return append_values(col, values, n, null_rows, null_count);
+}
+
+// Copy the values of the gathered rows of a typed buffer, 0 for a row past the end of the source
+#define GATHER_TYPED(ctype, col, src, rows, n)                                                \
+    do {                                                                                       \
+        ctype *dst_ = (ctype *)(col)->values + (col)->size;                                    \
+        const ctype *from_ = (const ctype *)(src)->values;                                     \
+        for (unsigned int i_ = 0; i_ < (n); i_++) {                                            \
+            dst_[i_] = (rows)[i_] < (src)->size ? from_[(rows)[i_]] : (ctype)0;                \
+        }                                                                                      \
+    } while (0)
+
+// Function to append, in one call, the cells of some rows of another column of the same type
+int column_append_gather(COLUMN *col, COLUMN *src, const unsigned int *rows, unsigned int n) {
+    STAT_SCOPE(COLUMN_APPEND_GATHER, n);
+    if (col == NULL || src == NULL || col->column_type != src->column_type || (rows == NULL && n > 0)) return 0;
+    if (!grow_column(col, (size_t)col->size + n)) return 0;
+    if (n > 0) col->valid_index = 0;
+    unsigned int first = col->size;
+
+    if (col->column_type == STRING) {
+        // Size the arena once for the whole batch
+        size_t total = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            const char *str = (const char *)get_value_at(src, rows[i]);
+            if (str != NULL) total += strlen(str) + 1;
+        }
+        if (!column_reserve_strings(col, total)) return 0;
+        unsigned long long int *offsets = (unsigned long long int *)col->values;
+        for (unsigned int i = 0; i < n; i++) {
+            const char *str = (const char *)get_value_at(src, rows[i]);
+            if (!set_validity(col, col->size, str != NULL)) return 0;
+            offsets[col->size++] = str != NULL ? column_append_string(col, str, strlen(str)) : 0;
+        }
+    } else if (col->elem_size == 0) {
+        for (unsigned int i = 0; i < n; i++) {
+            if (!insert_value(col, NULL)) return 0;
+        }
+        return 1;
+    } else {
+        switch (col->elem_size) {
+            case 1:
+                GATHER_TYPED(char, col, src, rows, n);
+                break;
+            case 4:
+                GATHER_TYPED(unsigned int, col, src, rows, n);
+                break;
+            case 8:
+                GATHER_TYPED(unsigned long long int, col, src, rows, n);
+                break;
+            default:
+                for (unsigned int i = 0; i < n; i++) {
+                    char *dst = (char *)col->values + ((size_t)col->size + i) * col->elem_size;
+                    if (rows[i] < src->size) {
+                        memcpy(dst, (const char *)src->values + (size_t)rows[i] * col->elem_size, col->elem_size);
+                    } else {
+                        memset(dst, 0, col->elem_size);
+                    }
+                }
+                break;
+        }
+        // Null, deleted and missing source cells give null cells
+        for (unsigned int i = 0; i < n; i++) {
+            int valid = rows[i] < src->size && (src->validity == NULL || bitmap_get(src->validity, rows[i]));
+            if (!valid || col->validity != NULL) {
+                if (!set_validity(col, col->size + i, valid)) return 0;
+            }
+        }
+        col->size += n;
+    }
+
+    for (unsigned int i = first; i < col->size; i++) {
+        zone_map_add_row(col, i);
+        if (!hash_index_add_row(col, i)) return 0;
+    }
+    return 1;
+}
+
+// Function to overwrite the value at a given position, a NULL value makes the cell null
+int set_value_at(COLUMN *col, unsigned int index, void *value) {
+    STAT_SCOPE(SET_VALUE_AT, 1);
+    if (col == NULL || index >= col->size || !check_writable(col)) return 0;
+    if (is_deleted_at(col, index)) {
+        fprintf(stderr, "Row %u of column '%s' is deleted.\n", index, col->title);
+        return 0;
+    }
+    col->valid_index = 0;
+    if (col->column_type == NULLVAL) value = NULL;
+    hash_index_remove_row(col, index);
+    zone_map_remove_row(col, index);
+
+    if (value == NULL) {
+        release_string(col, index);
+        return set_validity(col, index, 0);
+    }
+    if (!col->ops->copy(col, index, value) || !set_validity(col, index, 1)) {
+        // The hash index and the zone map no longer know the value of the row
+        drop_hash_index(col);
+        zone_map_add_row(col, index);
+        return 0;
+    }
+    zone_map_add_row(col, index);
+    if (!hash_index_add_row(col, index)) return 0;
+    // Overwritten strings stay in the arena until half of it is dead
+    if (col->strings_dead >= STRINGS_REPACK_MIN && col->strings_dead * 2 >= col->strings_size) {
+        return column_repack_strings(col);
+    }
     return 1;
 }
 
+// Function to remove the last row of the column
+int remove_last_value(COLUMN *col) {
+    STAT_SCOPE(REMOVE_LAST_VALUE, 1);
+    if (col == NULL || col->size == 0 || !check_writable(col)) return 0;
+    hash_index_remove_row(col, col->size - 1);
+    zone_map_remove_row(col, col->size - 1);
+    release_string(col, col->size - 1);
+    if (is_deleted_at(col, col->size - 1)) {
+        bitmap_clear(col->deleted, col->size - 1);
+        col->deleted_count--;
+    }
+    col->size--;
+    col->valid_index = 0;
+    return 1;
+}
+
+// Function to mark a row deleted
+int column_delete_row(COLUMN *col, unsigned int index) {
+    STAT_SCOPE(COLUMN_DELETE_ROW, 1);
+    if (col == NULL || index >= col->size || !check_writable(col)) return 0;
+    if (is_deleted_at(col, index)) return 1;
+    if (col->deleted == NULL) {
+        size_t words = bitmap_words(col->max_size);
+        col->deleted = (unsigned long long int *)column_buffer_realloc(col, NULL, 0,
+                                                                       words * sizeof(unsigned long long int));
+        if (!col->deleted) {
+            fprintf(stderr, "Failed to allocate the deletion bitmap.\n");
+            return 0;
+        }
+        memset(col->deleted, 0, words * sizeof(unsigned long long int));
+    }
+    // The row leaves the indexes as its value disappears behind a cleared validity bit
+    hash_index_remove_row(col, index);
+    zone_map_remove_row(col, index);
+    release_string(col, index);
+    if (!set_validity(col, index, 0)) return 0;
+    bitmap_set(col->deleted, index);
+    col->deleted_count++;
+    col->valid_index = 0;
+    return 1;
+}
+
+// Function to tell whether a row is deleted
+int is_deleted_at(const COLUMN *col, unsigned int index) {
+    return col != NULL && col->deleted != NULL && index < col->size && bitmap_get(col->deleted, index);
+}
+
+// Function to rebuild the string arena with only the strings of the valid rows, dropping the dead bytes
+int column_repack_strings(COLUMN *col) {
+    if (col == NULL || col->column_type != STRING || !check_writable(col)) return 0;
+    unsigned long long int *offsets = (unsigned long long int *)col->values;
+    size_t total = 0;
+    FOR_EACH_SET_BIT(col->validity, 0, col->size, i,
+        total += strlen(col->strings + offsets[i]) + 1;
+    )
+    char *strings = (char *)column_buffer_realloc(col, NULL, 0, total > 0 ? total : 1);
+    if (!strings) {
+        fprintf(stderr, "String arena reallocation failed.\n");
+        return 0;
+    }
+    size_t used = 0;
+    FOR_EACH_SET_BIT(col->validity, 0, col->size, i,
+        size_t length = strlen(col->strings + offsets[i]) + 1;
+        memcpy(strings + used, col->strings + offsets[i], length);
+        offsets[i] = used;
+        used += length;
+    )
+    column_buffer_free(col, col->strings);
+    col->strings = strings;
+    col->strings_size = used;
+    col->strings_capacity = total > 0 ? total : 1;
+    col->strings_dead = 0;
+    return 1;
+}
+
+// Shrink the buffers of a column to capacity rows
+static int shrink_column(COLUMN *col, size_t capacity) {
+    if (col->elem_size > 0) {
+        void *new_values = column_buffer_realloc(col, col->values, col->max_size * col->elem_size,
+                                                 capacity * col->elem_size);
+        if (!new_values) {
+            fprintf(stderr, "Memory reallocation failed.\n");
+            return 0;
+        }
+        col->values = new_values;
+    }
+    if (col->index != NULL) {
+        unsigned long long int *new_index = (unsigned long long int *)column_buffer_realloc(
+                col, col->index, col->max_size * sizeof(unsigned long long int),
+                capacity * sizeof(unsigned long long int));
+        if (new_index) col->index = new_index;
+    }
+    if (col->validity != NULL) {
+        unsigned long long int *new_validity = (unsigned long long int *)column_buffer_realloc(
+                col, col->validity, bitmap_words(col->max_size) * sizeof(unsigned long long int),
+                bitmap_words(capacity) * sizeof(unsigned long long int));
+        if (new_validity) col->validity = new_validity;
+    }
+    col->max_size = (unsigned int)capacity;
+    return 1;
+}
+
+// Function to remove the deleted rows of a column
+int column_compact(COLUMN *col) {
+    STAT_SCOPE(COLUMN_COMPACT, col != NULL ? col->size : 0);
+    if (col == NULL) return 0;
+    if (col->deleted_count == 0) {
+        return col->strings_dead == 0 || column_repack_strings(col);
+    }
+    if (!check_writable(col)) return 0;
+
+    // Move every run of kept rows down, with its validity bits; a row only moves towards the front,
+    // so nothing is overwritten before it is read
+    unsigned int kept = 0;
+    char *values = (char *)col->values;
+    for (unsigned long long int w = 0; w < bitmap_words(col->size); w++) {
+        unsigned long long int live = ~col->deleted[w] & bitmap_tail_mask(w, col->size);
+        while (live != 0) {
+            unsigned int first = (unsigned int)lowest_bit64(live);
+            unsigned long long int rest = ~(live >> first);
+            unsigned int length = rest == 0 ? BITMAP_WORD_BITS - first : (unsigned int)lowest_bit64(rest);
+            unsigned int row = (unsigned int)(w * BITMAP_WORD_BITS) + first;
+            if (row != kept) {
+                if (col->elem_size > 0) {
+                    memmove(values + (size_t)kept * col->elem_size, values + (size_t)row * col->elem_size,
+                            (size_t)length * col->elem_size);
+                }
+                if (col->validity != NULL) {
+                    for (unsigned int k = 0; k < length; k++) {
+                        if (bitmap_get(col->validity, row + k)) {
+                            bitmap_set(col->validity, kept + k);
+                        } else {
+                            bitmap_clear(col->validity, kept + k);
+                        }
+                    }
+                }
+            }
+            kept += length;
+            live &= length + first >= BITMAP_WORD_BITS ? 0 : ~0ULL << (first + length);
+        }
+    }
+
+    // Rows past the logical size are kept marked valid
+    if (col->validity != NULL) {
+        for (unsigned int i = kept; i < col->size; i++) bitmap_set(col->validity, i);
+    }
+    column_buffer_free(col, col->deleted);
+    col->deleted = NULL;
+    col->deleted_count = 0;
+    col->size = kept;
+    col->valid_index = 0;
+
+    if (col->column_type == STRING && !column_repack_strings(col)) return 0;
+    size_t capacity = kept > REALOC_SIZE ? kept : REALOC_SIZE;
+    if (capacity < col->max_size && !shrink_column(col, capacity)) return 0;
+    // The hash index counts values, not positions, so it stays valid
+    return zone_map_rebuild(col);
+}
+
+// Function to tell whether the cell at a given position is null
+int is_null_at(COLUMN *col, unsigned int index) {
+    if (col == NULL || index >= col->size) return 1;
+    return col->validity != NULL && !bitmap_get(col->validity, index);
+}
+
 // Function to free the memory allocated for a column
 void delete_column(COLUMN **col_ptr) {
+    STAT_SCOPE(DELETE_COLUMN, col_ptr != NULL && *col_ptr != NULL ? (*col_ptr)->size : 0);
     if (col_ptr == NULL || *col_ptr == NULL) {
         fprintf(stderr, "Attempt to delete a null column pointer.\n");
         return;
@@ -97,37 +681,58 @@ void delete_column(COLUMN **col_ptr) {
 
     COLUMN *col = *col_ptr;
 
-    // Free each element in the data array
-    for (unsigned int i = 0; i < col->size; i++) {
-        if (col->data[i] != NULL) {
-            if (col->column_type == STRING) {
-                free(*(char **)(col->data[i]));  // Free the string before the pointer
-            }
-            free(col->data[i]);  // Free the data pointer itself
-        }
+    // Free the contiguous value buffer, the string arena, the bitmaps and the zone map,
+    // unless they belong to a file mapping, then the indexes
+    if (!col->read_only) {
+        column_buffer_free(col, col->values);
+        column_buffer_free(col, col->strings);
+        column_buffer_free(col, col->validity);
+        column_buffer_free(col, col->deleted);
+        free(col->zones);
     }
+    column_buffer_free(col, col->index);
+    drop_hash_index(col);
 
-    // Free the data array pointer
-    free(col->data);
-
-    // Free the column title and the column struct itself
-    free(col->title);
-    free(col);
+    // Free the column title and the column struct itself, unless they live in the allocation arena
+    if (col->arena == NULL) {
+        free(col->title);
+        free(col);
+    }
 
     // Set the pointer in the original reference to NULL
     *col_ptr = NULL;
 }
 
 
-void CustomStructureToString(CustomStructure *cs, char *str, size_t size) {
-    if (cs == NULL || str == NULL) {
-        snprintf(str, size, "NULL");
-        return;
+// Function to get the memory held by a column, split into payload, overhead, indexes and slack
+void column_memory_usage(const COLUMN *col, MEMORY_USAGE *usage) {
+    if (usage == NULL) return;
+    memset(usage, 0, sizeof(MEMORY_USAGE));
+    if (col == NULL) return;
+
+    size_t used_words = bitmap_words(col->size), words = bitmap_words(col->max_size);
+    // Dead bytes of the string arena count as slack, column_compact gives them back
+    size_t payload = (size_t)col->size * col->elem_size + col->strings_size - col->strings_dead;
+    size_t slack = (size_t)(col->max_size - col->size) * col->elem_size +
+                   (col->strings_capacity - col->strings_size) + col->strings_dead;
+    size_t overhead = zone_map_memory_usage(col);
+    if (col->validity != NULL) {
+        payload += used_words * sizeof(unsigned long long int);
+        slack += (words - used_words) * sizeof(unsigned long long int);
     }
-    // Create a formatted string with structure's fields
-    snprintf(str, size, "ID: %d, Value: %.2f, Description: %s", cs->id, cs->value, cs->description);
-}
+    if (col->deleted != NULL) overhead += words * sizeof(unsigned long long int);
 
+    if (col->read_only) {
+        usage->mapped = payload + slack + overhead;
+    } else {
+        usage->payload = payload;
+        usage->slack = slack;
+        usage->overhead = overhead;
+    }
+    usage->overhead += sizeof(COLUMN) + (col->title != NULL ? strlen(col->title) + 1 : 0);
+    if (col->index != NULL) usage->indexes += (size_t)col->max_size * sizeof(unsigned long long int);
+    usage->indexes += hash_index_memory_usage(col);
+}
 
 // Function to convert a column value to a string based on its data type
 void convert_value(COLUMN *col, unsigned long long int index, char *str, int size) {
@@ -135,100 +740,310 @@ void convert_value(COLUMN *col, unsigned long long int index, char *str, int siz
         snprintf(str, size, "NULL");
         return;
     }
-    if (index >= col->size || col->data[index] == NULL) {
+    void *cell = index < col->size ? get_value_at(col, (unsigned int)index) : NULL;
+    if (cell == NULL) {
         snprintf(str, size, "NULL");
         return;
     }
 
-    // Convert value based on its type
+    col->ops->format(cell, str, size);
+}
+
+// Function to print the contents of a column
+void print_col(COLUMN *col) {
+    STAT_SCOPE(PRINT_COL, col != NULL ? col->size : 0);
+    if (col == NULL) {
+        printf("Attempt to print a null column.\n");
+        return;
+    }
+
+    // Buffered output, flushed after what printf has buffered
+    fflush(stdout);
+    TEXT_WRITER writer;
+    writer_init(&writer, fileno(stdout));
+    writer_put_string(&writer, "Column '");
+    writer_put_string(&writer, col->title);
+    writer_put_string(&writer, "':\n");
+    write_column_rows(col, 0, col->size, &writer);
+    writer_close(&writer);
+}
+
+// Function to write the value of a cell to a writer
+void write_value(COLUMN *col, unsigned int index, TEXT_WRITER *writer) {
+    void *cell = get_value_at(col, index);
+    if (cell == NULL) {
+        writer_put_string(writer, "NULL");
+    } else {
+        col->ops->write(writer, cell);
+    }
+}
+
+// Function to write rows of a column to a writer, one "[row] value" line each
+void write_column_rows(COLUMN *col, unsigned int start, unsigned int end, TEXT_WRITER *writer) {
+    STAT_SCOPE(WRITE_COLUMN_ROWS, end > start ? end - start : 0);
+    for (unsigned int i = start; i < end && i < col->size; i++) {
+        if (is_deleted_at(col, i)) continue;
+        writer_put_char(writer, '[');
+        writer_put_uint(writer, i);
+        writer_put_string(writer, "] ");
+        write_value(col, i, writer);
+        writer_put_char(writer, '\n');
+    }
+}
+
+
+// Scan of the segments of a column against a pivot
+typedef struct segment_scan_job {
+    const COLUMN *col;
+    const void *value;
+    COMPARE_COUNTS *partials;  // One per worker
+} SEGMENT_SCAN_JOB;
+
+// Scans one segment into the partial counts of the worker running it
+static void scan_segment(void *ctx, unsigned int task_index, unsigned int worker) {
+    SEGMENT_SCAN_JOB *job = (SEGMENT_SCAN_JOB *)ctx;
+    unsigned int start = task_index * SEGMENT_ROWS;
+    unsigned int end = job->col->size - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : job->col->size;
+    zone_map_scan(job->col, start, end, job->value, &job->partials[worker]);
+}
+
+// Function to count, in a single pass, the non-null values less than, equal to and greater than a value
+void count_compare(COLUMN *col, void *value, COMPARE_COUNTS *counts) {
+    STAT_SCOPE(COUNT_COMPARE, col != NULL ? col->size : 0);
+    if (counts == NULL) return;
+    counts->less = counts->equal = counts->greater = 0;
+    if (col == NULL || value == NULL) return;
+
+    // A sorted index answers with two binary searches
+    if (count_compare_with_index(col, value, counts)) return;
+
+    // Segments are scanned in parallel, each worker adding to its own partial counts
+    THREAD_POOL *pool = get_default_thread_pool();
+    unsigned int segments = (col->size + SEGMENT_ROWS - 1) / SEGMENT_ROWS;
+    unsigned int workers = thread_pool_size(pool);
+    COMPARE_COUNTS *partials = segments > 1 && workers > 1 ? (COMPARE_COUNTS *)calloc(workers, sizeof(COMPARE_COUNTS))
+                                                           : NULL;
+    if (partials == NULL) {
+        zone_map_scan(col, 0, col->size, value, counts);
+        return;
+    }
+    SEGMENT_SCAN_JOB job = {col, value, partials};
+    thread_pool_run(pool, segments, scan_segment, &job);
+    for (unsigned int w = 0; w < workers; w++) {
+        counts->less += partials[w].less;
+        counts->equal += partials[w].equal;
+        counts->greater += partials[w].greater;
+    }
+    free(partials);
+}
+
+// First position of the sorted index in [0, valid) whose comparison with value, in index order, is not below bound
+static unsigned int index_search(COLUMN *col, void *value, unsigned int valid, int bound) {
+    unsigned int lo = 0, hi = valid;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        int cmp = col->ops->compare(get_value_at(col, (unsigned int)col->index[mid]), value);
+        if (col->sort_dir == DESC) cmp = -cmp;
+        if (cmp < bound) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Function to count through the sorted index in O(log n); returns 0 (counts untouched) when the index cannot answer
+int count_compare_with_index(COLUMN *col, void *value, COMPARE_COUNTS *counts) {
+    STAT_SCOPE(COUNT_COMPARE_WITH_INDEX, col != NULL ? col->size : 0);
+    if (col == NULL || value == NULL || counts == NULL || !col->valid_index) return 0;
+    unsigned int valid = indexed_valid_count(col, col->size);
+
+    // Radix order puts NaNs at the ends, where they would break the binary search
+    if (is_nan_value(col->column_type, value)) return 0;
+    if (valid > 0 && (is_nan_value(col->column_type, get_value_at(col, (unsigned int)col->index[0])) ||
+                      is_nan_value(col->column_type, get_value_at(col, (unsigned int)col->index[valid - 1])))) {
+        return 0;
+    }
+
+    unsigned int first_not_before = index_search(col, value, valid, 0);
+    unsigned int first_after = index_search(col, value, valid, 1);
+    unsigned long long int before = first_not_before, equal = first_after - first_not_before, after = valid - first_after;
+    counts->less = col->sort_dir == ASC ? before : after;
+    counts->greater = col->sort_dir == ASC ? after : before;
+    counts->equal = equal;
+    return 1;
+}
+
+// Count the non-null values whose comparison with value has the given sign (-1, 0 or 1)
+static int count_matching(COLUMN *col, void *value, int sign) {
+    COMPARE_COUNTS counts;
+    count_compare(col, value, &counts);
+    return (int)(sign < 0 ? counts.less : sign > 0 ? counts.greater : counts.equal);
+}
+
+// Bucket every valid value of rows [start, end) of a typed buffer: bucket k holds the values with exactly k pivots
+// not greater than them
+#define HISTOGRAM_TYPED(ctype, col, start, end, pivots, num_pivots, counts)                   \
+    do {                                                                                       \
+        const ctype *vals_ = (const ctype *)(col)->values;                                     \
+        ctype *bounds_ = (ctype *)malloc((num_pivots) * sizeof(ctype));                        \
+        if (bounds_ == NULL) return 0;                                                         \
+        for (unsigned int k_ = 0; k_ < (num_pivots); k_++) bounds_[k_] = *(const ctype *)(pivots)[k_]; \
+        FOR_EACH_SET_BIT((col)->validity, (start), (end), r_,                                  \
+            unsigned int lo_ = 0, hi_ = (num_pivots);                                          \
+            while (lo_ < hi_) {                                                                \
+                unsigned int mid_ = (lo_ + hi_) / 2;                                           \
+                if (vals_[r_] < bounds_[mid_]) hi_ = mid_; else lo_ = mid_ + 1;                \
+            }                                                                                  \
+            (counts)[lo_]++;                                                                   \
+        )                                                                                      \
+        free(bounds_);                                                                         \
+    } while (0)
+
+// Function to add to counts the buckets of the valid values of rows [start, end), the unit of parallel histograms
+int column_histogram_range(COLUMN *col, unsigned int start, unsigned int end, void **pivots, unsigned int num_pivots,
+                           unsigned long long int *counts) {
+    if (col == NULL || counts == NULL || (pivots == NULL && num_pivots > 0)) return 0;
+    if (end > col->size) end = col->size;
+    if (start >= end) return 1;
+    if (num_pivots == 0) {
+        // Null and deleted rows have a cleared validity bit
+        unsigned long long int valid = 0;
+        FOR_EACH_SET_BIT(col->validity, start, end, i, (void)i; valid++;)
+        counts[0] += valid;
+        return 1;
+    }
+
     switch (col->column_type) {
         case UINT:
-            snprintf(str, size, "%u", *(unsigned int *)(col->data[index]));
-            break;
+            HISTOGRAM_TYPED(unsigned int, col, start, end, pivots, num_pivots, counts);
+            return 1;
         case INT:
-            snprintf(str, size, "%d", *(int *)(col->data[index]));
-            break;
+            HISTOGRAM_TYPED(int, col, start, end, pivots, num_pivots, counts);
+            return 1;
         case CHAR:
-            snprintf(str, size, "%c", *(char *)(col->data[index]));
-            break;
+            HISTOGRAM_TYPED(char, col, start, end, pivots, num_pivots, counts);
+            return 1;
         case FLOAT:
-            snprintf(str, size, "%.2f", *(float *)(col->data[index]));
-            break;
+            HISTOGRAM_TYPED(float, col, start, end, pivots, num_pivots, counts);
+            return 1;
         case DOUBLE:
-            snprintf(str, size, "%.2lf", *(double *)(col->data[index]));
-            break;
+            HISTOGRAM_TYPED(double, col, start, end, pivots, num_pivots, counts);
+            return 1;
         case STRING:
-            snprintf(str, size, "%s", (char *)(col->data[index]));
-            break;
         case STRUCTURE:
-            CustomStructureToString((CustomStructure *)(col->data[index]), str, size);
-            break;
+            for (unsigned int i = start; i < end; i++) {
+                void *cell = get_value_at(col, i);
+                if (cell == NULL) continue;
+                unsigned int lo = 0, hi = num_pivots;
+                while (lo < hi) {
+                    unsigned int mid = (lo + hi) / 2;
+                    if (col->ops->compare(cell, pivots[mid]) < 0) hi = mid; else lo = mid + 1;
+                }
+                counts[lo]++;
+            }
+            return 1;
         default:
-            snprintf(str, size, "Unsupported Type");
-            break;
+            return 1;
     }
 }
 
-// Function to print the contents of a column
-void print_col(COLUMN *col) {
-    if (col == NULL) {
-        printf("Attempt to print a null column.\n");
-        return;
-    }
+// Function to build, in a single pass, the histogram of a column over ascending pivot values
+// counts receives num_pivots + 1 buckets: values below pivots[0], then [pivots[k - 1], pivots[k]), then values from the last pivot up
+int column_histogram(COLUMN *col, void **pivots, unsigned int num_pivots, unsigned long long int *counts) {
+    STAT_SCOPE(COLUMN_HISTOGRAM, col != NULL ? col->size : 0);
+    if (col == NULL || counts == NULL || (pivots == NULL && num_pivots > 0)) return 0;
+    memset(counts, 0, ((size_t)num_pivots + 1) * sizeof(unsigned long long int));
+    return column_histogram_range(col, 0, col->size, pivots, num_pivots, counts);
+}
 
-    printf("Column '%s':\n", col->title);
-    char buffer[256]; // Buffer to hold the string representation of each value
+// Segments of a column reduced in parallel, each into its own partial reduction
+typedef struct segment_reduce_job {
+    const COLUMN *col;
+    REDUCTION *partials;  // One per segment
+} SEGMENT_REDUCE_JOB;
 
-    for (unsigned int i = 0; i < col->size; i++) {
-        convert_value(col, i, buffer, sizeof(buffer));
-        printf("[%u] %s\n", i, buffer);
+static void reduce_segment(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    SEGMENT_REDUCE_JOB *job = (SEGMENT_REDUCE_JOB *)ctx;
+    unsigned int start = task_index * SEGMENT_ROWS;
+    unsigned int end = job->col->size - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : job->col->size;
+    reduce_kernel(job->col->values, job->col->validity, start, end, &job->partials[task_index]);
+}
+
+// Function to compute, in a single pass, the sum, mean, bounds and variance of the non-null values of a numeric column
+// Each segment is reduced on its own and the segments are merged in row order, so that the result does not depend
+// on the number of threads; returns 0 for a column that is not UINT, INT, CHAR, FLOAT or DOUBLE
+int column_aggregate(COLUMN *col, SUM_MODE mode, COLUMN_AGGREGATES *aggregates) {
+    STAT_SCOPE(COLUMN_AGGREGATE, col != NULL ? col->size : 0);
+    if (col == NULL || aggregates == NULL || !has_reduce_kernel(col->column_type)) return 0;
+
+    REDUCTION total;
+    reduction_init(&total, col->column_type, mode);
+    THREAD_POOL *pool = get_default_thread_pool();
+    unsigned int segments = (col->size + SEGMENT_ROWS - 1) / SEGMENT_ROWS;
+    REDUCTION *partials = segments > 1 && thread_pool_size(pool) > 1
+                              ? (REDUCTION *)malloc(segments * sizeof(REDUCTION)) : NULL;
+    if (partials != NULL) {
+        for (unsigned int k = 0; k < segments; k++) reduction_init(&partials[k], col->column_type, mode);
+        SEGMENT_REDUCE_JOB job = {col, partials};
+        thread_pool_run(pool, segments, reduce_segment, &job);
+        for (unsigned int k = 0; k < segments; k++) reduction_merge(&total, &partials[k]);
+        free(partials);
+    } else {
+        // Same segments one after the other
+        for (unsigned int start = 0; start < col->size; start += SEGMENT_ROWS) {
+            REDUCTION partial;
+            reduction_init(&partial, col->column_type, mode);
+            unsigned int end = col->size - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : col->size;
+            reduce_kernel(col->values, col->validity, start, end, &partial);
+            reduction_merge(&total, &partial);
+        }
     }
+    reduction_finish(&total, aggregates);
+    return 1;
 }
 
+// Function to count the null cells of a column
+int count_nulls(COLUMN *col) {
+    STAT_SCOPE(COUNT_NULLS, col != NULL ? col->size : 0);
+    if (col == NULL || col->validity == NULL) return 0;
+    int count = 0;
+    for (unsigned long long int w = 0; w < bitmap_words(col->size); w++) {
+        count += popcount64(~col->validity[w] & bitmap_tail_mask(w, col->size));
+    }
+    // Deleted rows are not nulls
+    return count - (int)col->deleted_count;
+}
 
 // Function to count the number of occurrences of a value
 int count_occurrences(COLUMN *col, void *value) {
+    STAT_SCOPE(COUNT_OCCURRENCES, col != NULL ? col->size : 0);
     if (col == NULL || value == NULL) return 0;
-
-    int count = 0;
-    for (unsigned int i = 0; i < col->size; i++) {
-        if (compare_values(col->column_type, col->data[i], value) == 0) {
-            count++;
-        }
-    }
-    return count;
+    // A hash index answers with one lookup
+    unsigned long long int count;
+    if (hash_index_count(col, value, &count)) return (int)count;
+    return count_matching(col, value, 0);
 }
 
-// Function to get the value at a given position
+// Function to get the value at a given position, NULL for a null cell
+// The returned pointer refers to the column storage and is invalidated when the column grows or a
+// set_value_at repacks the string arena
 void *get_value_at(COLUMN *col, unsigned int index) {
-    if (col == NULL || index >= col->size) return NULL;
-    return col->data[index];
+    if (col == NULL || index >= col->size || is_null_at(col, index)) return NULL;
+    if (col->column_type == STRING) {
+        return col->strings + ((unsigned long long int *)col->values)[index];
+    }
+    return (char *)col->values + (size_t)index * col->elem_size;
 }
 
 // Function to count the number of values greater than a given value
 int count_greater_than(COLUMN *col, void *value) {
     if (col == NULL || value == NULL) return 0;
-
-    int count = 0;
-    for (unsigned int i = 0; i < col->size; i++) {
-        if (compare_values(col->column_type, col->data[i], value) > 0) {
-            count++;
-        }
-    }
-    return count;
+    return count_matching(col, value, 1);
 }
 
 // Function to count the number of values less than a given value
 int count_less_than(COLUMN *col, void *value) {
     if (col == NULL || value == NULL) return 0;
-
-    int count = 0;
-    for (unsigned int i = 0; i < col->size; i++) {
-        if (compare_values(col->column_type, col->data[i], value) < 0) {
-            count++;
-        }
-    }
-    return count;
+    return count_matching(col, value, -1);
 }
 
 // Function to count the number of values equal to a given value
@@ -239,25 +1054,5 @@ int count_equal_to(COLUMN *col, void *value) {
 // Helper function to compare two values based on the column type
 int compare_values(ENUM_TYPE type, void *data1, void *data2) {
     if (data1 == NULL || data2 == NULL) return -1; // Indicating invalid comparison
-
-    switch (type) {
-        case INT:
-            return (*(int *)data1 > *(int *)data2) - (*(int *)data1 < *(int *)data2);
-        case FLOAT:
-            return (*(float *)data1 > *(float *)data2) - (*(float *)data1 < *(float *)data2);
-        case DOUBLE:
-            return (*(double *)data1 > *(double *)data2) - (*(double *)data1 < *(double *)data2);
-        case CHAR:
-            return (*(char *)data1 > *(char *)data2) - (*(char *)data1 < *(char *)data2);
-        case STRING:
-            return strcmp((char *)data1, (char *)data2);
-        case STRUCTURE:
-            return ((CustomStructure *)data1)->value > ((CustomStructure *)data2)->value ? 1 :
-                   ((CustomStructure *)data1)->value < ((CustomStructure *)data2)->value ? -1 : 0;
-        default:
-            fprintf(stderr, "Unsupported type for comparison.\n");
-            return -1; // Unsupported type
-    }
+    return get_column_ops(type)->compare(data1, data2);
 }
-
-
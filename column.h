@@ -2,6 +2,8 @@
 #define COLUMN_H
 
 #include <stdlib.h>
+#include "memory.h"
+#include "arena.h"
 
 // In column.h or a similar header file
 typedef struct CustomStructure {
@@ -29,41 +31,198 @@ union column_type {
 };
 typedef union column_type COL_TYPE;
 
+typedef struct column COLUMN;
+typedef struct hash_index HASH_INDEX;
+typedef struct zone ZONE;
+typedef struct text_writer TEXT_WRITER;
+
+// Rows of a segment, the unit of column growth and of parallel scans
+// A column past one segment grows by whole segments, and every scan task covers one segment
+// (a whole number of zone map blocks)
+// Segments are not allocated separately: the values stay one contiguous buffer that kernels, indexes and
+// the mapped file format address directly. Growth avoids copying only for buffers of MAPPED_BUFFER_SIZE
+// and more on Linux (mremap), arena columns included once their buffers own a dedicated arena block;
+// smaller buffers and other systems copy the rows when the capacity grows
+#define SEGMENT_ROWS (64 * 1024)
+
+// Order of a sorted index
+enum sort_order {
+    ASC = 0, DESC
+};
+typedef enum sort_order SORT_ORDER;
+
+// Number of values less than, equal to and greater than a pivot
+// Values that are neither less nor greater (NaN included) are counted as equal, like compare_values
+typedef struct compare_counts {
+    unsigned long long int less;
+    unsigned long long int equal;
+    unsigned long long int greater;
+} COMPARE_COUNTS;
+
+// Comparison of a row filter with its pivot, FILTER_BETWEEN keeps pivot <= value <= high
+// Unlike COMPARE_COUNTS the comparisons follow IEEE 754: a NaN value or bound only passes FILTER_NE
+enum filter_op {
+    FILTER_LT = 0, FILTER_LE, FILTER_EQ, FILTER_NE, FILTER_GE, FILTER_GT, FILTER_BETWEEN
+};
+typedef enum filter_op FILTER_OP;
+
+// How column_aggregate adds up FLOAT and DOUBLE values (integer sums are exact whatever the mode)
+// The values of each 64-row block are summed in several vector lanes, the modes differ in how the block sums add up
+enum sum_mode {
+    SUM_PLAIN = 0,  // One running total, the fastest
+    SUM_KAHAN,  // Running total with compensation of the rounding error (Neumaier's variant of Kahan summation)
+    SUM_PAIRWISE  // Block sums added pairwise in a tree, error growing with the log of the row count
+};
+typedef enum sum_mode SUM_MODE;
+
+// Reductions of the non-null values of a numeric column
+// With no value the sum is 0 and the other fields are NaN
+typedef struct column_aggregates {
+    unsigned long long int count;  // Non-null values
+    double sum;
+    double mean;
+    double min;
+    double max;
+    double variance;  // Population variance, the mean of the squared deviations from the mean
+} COLUMN_AGGREGATES;
+
+// Per-type operations, one shared table per ENUM_TYPE attached to each column by create_column
+typedef struct column_ops {
+    // Three-way comparison of two values of the type
+    int (*compare)(const void *data1, const void *data2);
+    // Hash of a value, equal values hash equally
+    unsigned long long int (*hash)(const void *value);
+    // Write a value as text, returns the length it needs like snprintf
+    int (*format)(const void *value, char *str, size_t size);
+    // Store a copy of a value in the storage of a row (the validity bit is left to the caller)
+    int (*copy)(COLUMN *col, unsigned int index, const void *value);
+    // Add the three-way comparison with the pivot of the non-null rows [start, end)
+    void (*scan)(const COLUMN *col, unsigned int start, unsigned int end, const void *pivot, COMPARE_COUNTS *counts);
+    // Set the bits of the non-null rows [start, end) passing a filter (start a multiple of 64), returns their count
+    unsigned int (*select)(const COLUMN *col, unsigned int start, unsigned int end, FILTER_OP op, const void *pivot,
+                           const void *high, unsigned long long int *selected);
+    // Append the same text as format to a buffered writer, without going through printf
+    void (*write)(TEXT_WRITER *writer, const void *value);
+} COLUMN_OPS;
+
 // Structure for a column
 struct column {
     char *title;
     unsigned int size;  // Logical size
     unsigned int max_size;  // Physical size
     ENUM_TYPE column_type;
-    COL_TYPE **data;  // Array of pointers to stored data
-    unsigned long long int *index;  // Array of integers
+    const COLUMN_OPS *ops;  // Operations of column_type
+    void *values;  // Contiguous aligned buffer of the stored values, string offsets for STRING
+    size_t elem_size;  // Width in bytes of one element of values, 0 for NULLVAL
+    char *strings;  // Arena of the NUL-terminated strings of a STRING column
+    size_t strings_size;  // Bytes used in the arena
+    size_t strings_capacity;  // Bytes allocated for the arena
+    size_t strings_dead;  // Bytes of the arena no row refers to any more (overwritten, nulled or deleted strings)
+    unsigned long long int *validity;  // One bit per row, 0 for a null cell; NULL while the column has no null
+    unsigned long long int *deleted;  // One bit per row set for a deleted row until column_compact; NULL while none
+    unsigned int deleted_count;  // Deleted rows, their validity bits are cleared too so that every scan skips them
+    unsigned long long int *index;  // Array of integers, max_size entries once allocated
+    int valid_index;  // 1 while index is the sorted permutation of the current values (nulls last)
+    SORT_ORDER sort_dir;  // Order of index
+    ZONE *zones;  // Value bounds per block of ZONE_ROWS rows for numeric columns, NULL otherwise
+    HASH_INDEX *hash_index;  // Distinct values and their counts, NULL until build_hash_index
+    int read_only;  // 1 when values, strings, validity and zones live in a file mapping owned by a dataframe
+    ARENA *arena;  // Allocation arena of the struct, title and buffers, NULL for the heap
 };
-typedef struct column COLUMN;
 
 // Function prototypes for managing columns
 
+// Width in bytes of a fixed-width type, 0 for STRING and NULLVAL
+size_t type_size(ENUM_TYPE type);
+
+// Operations table of a type, never NULL (unknown types get a table that stores nothing)
+const COLUMN_OPS *get_column_ops(ENUM_TYPE type);
+
 // Create a new column with specified type and title
 COLUMN *create_column(ENUM_TYPE type, char *title);
 
-// Insert a value into the column
+// Same with the struct, title and buffers allocated from an arena that must outlive the column
+// delete_column then only releases the zone map and hash index, the rest goes with the arena
+COLUMN *create_arena_column(ARENA *arena, ENUM_TYPE type, char *title);
+
+// Resize or release a buffer of a column (values, strings, bitmaps, index) with the allocator of the column
+void *column_buffer_realloc(COLUMN *col, void *ptr, size_t old_size, size_t new_size);
+void column_buffer_free(COLUMN *col, void *ptr);
+
+// Insert a value into the column, a NULL value inserts a null cell
+// The value may be a cell of the same column (from get_value_at): it is read again after the buffers grow
 int insert_value(COLUMN *col, void *value);
 
+// Reserve room for at least capacity values so that later inserts do not reallocate
+int column_reserve(COLUMN *col, unsigned int capacity);
+
+// Append n values stored in a typed array (char * array for STRING) in one call
+int column_append_n(COLUMN *col, const void *values, unsigned int n);
+
+// Same with the rows null_rows[0..null_count) of the batch (ascending) appended as nulls, whatever values holds there
+int column_append_n_nulls(COLUMN *col, const void *values, unsigned int n, const unsigned int *null_rows,
+                          unsigned int null_count);
+
+// Append the cells rows[0..n) of another column of the same type in one call
+// Rows may repeat; a row past the end of src (UINT_MAX for instance) appends a null cell
+int column_append_gather(COLUMN *col, COLUMN *src, const unsigned int *rows, unsigned int n);
+
+// Make room for extra bytes in the string arena, then copy a string there and get its offset
+int column_reserve_strings(COLUMN *col, size_t extra);
+unsigned long long int column_append_string(COLUMN *col, const char *str, size_t length);
+
+// Rebuild the string arena with the strings of the valid rows only, dropping the dead bytes
+// set_value_at runs it once half of the arena is dead; the offsets of the rows change
+int column_repack_strings(COLUMN *col);
+
+// Remove the last row of the column, returns 0 for an empty or read-only column
+int remove_last_value(COLUMN *col);
+
+// Mark a row deleted: it reads as null and every scan skips it until column_compact removes it
+// Row numbers stay the same until then; returns 0 for a read-only column or a row out of range
+int column_delete_row(COLUMN *col, unsigned int index);
+int is_deleted_at(const COLUMN *col, unsigned int index);
+
+// Remove the deleted rows, renumbering the others, and shrink the buffers to the remaining rows
+// The dead bytes of the string arena go too, even when no row is deleted
+int column_compact(COLUMN *col);
+
 // Free the memory allocated for a column
 void delete_column(COLUMN **col);
 
+// Fill usage with the bytes held by a column; buffers of a read-only column count as mapped
+void column_memory_usage(const COLUMN *col, MEMORY_USAGE *usage);
+
 // Convert a value at a specified index in a column to a string
 void convert_value(COLUMN *col, unsigned long long int index, char *str, int size);
 
 // Print the contents of a column
 void print_col(COLUMN *col);
 
+// Write the value of a cell to a writer, NULL for a null cell
+void write_value(COLUMN *col, unsigned int index, TEXT_WRITER *writer);
+
+// Write the rows [start, end) of a column to a writer, one "[row] value" line each like print_col
+void write_column_rows(COLUMN *col, unsigned int start, unsigned int end, TEXT_WRITER *writer);
+
 
 // Function prototypes for accessing and analyzing column data
 int count_occurrences(COLUMN *col, void *value);
 void *get_value_at(COLUMN *col, unsigned int index);
+// Overwrite the value of a row, a NULL value turns the cell into a null cell
+int set_value_at(COLUMN *col, unsigned int index, void *value);
+int is_null_at(COLUMN *col, unsigned int index);
+int count_nulls(COLUMN *col);
 int count_greater_than(COLUMN *col, void *value);
 int count_less_than(COLUMN *col, void *value);
 int count_equal_to(COLUMN *col, void *value);
+void count_compare(COLUMN *col, void *value, COMPARE_COUNTS *counts);
+int count_compare_with_index(COLUMN *col, void *value, COMPARE_COUNTS *counts);
+int column_histogram(COLUMN *col, void **pivots, unsigned int num_pivots, unsigned long long int *counts);
+// Add the buckets of rows [start, end) to counts, the unit of work of count_cells_histogram
+int column_histogram_range(COLUMN *col, unsigned int start, unsigned int end, void **pivots, unsigned int num_pivots,
+                           unsigned long long int *counts);
+int column_aggregate(COLUMN *col, SUM_MODE mode, COLUMN_AGGREGATES *aggregates);
 int compare_values(ENUM_TYPE type, void *data1, void *data2);
 
 
@@ -0,0 +1,325 @@
+#include "column.h"
+#include "bitmap.h"
+#include "kernels.h"
+#include "writer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Finalizer of splitmix64, spreads the bits of an integer key over the whole hash
+static unsigned long long int mix64(unsigned long long int x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash of a double, +0.0 and -0.0 compare equal so they must hash equally
+static unsigned long long int hash_double(double value) {
+    if (value == 0.0) value = 0.0;
+    unsigned long long int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return mix64(bits);
+}
+
+// Store a fixed-width value in the contiguous buffer, the value may be a cell of the same column
+static int fixed_copy(COLUMN *col, unsigned int index, const void *value) {
+    memmove((char *)col->values + (size_t)index * col->elem_size, value, col->elem_size);
+    return 1;
+}
+
+// Whether a value passes a filter, from its comparison with the pivot and, for FILTER_BETWEEN, with high
+static int filter_passes(FILTER_OP op, int cmp, int cmp_high) {
+    switch (op) {
+        case FILTER_LT: return cmp < 0;
+        case FILTER_LE: return cmp <= 0;
+        case FILTER_EQ: return cmp == 0;
+        case FILTER_NE: return cmp != 0;
+        case FILTER_GE: return cmp >= 0;
+        case FILTER_GT: return cmp > 0;
+        default: return cmp >= 0 && cmp_high <= 0;
+    }
+}
+
+// Numeric types: typed comparison, hash and format, vectorized scan and filter
+#define NUMERIC_OPS(name, type, ctype, format_string, hash_expr, write_expr)                   \
+    static int name##_compare(const void *data1, const void *data2) {                          \
+        ctype a = *(const ctype *)data1, b = *(const ctype *)data2;                            \
+        return (a > b) - (a < b);                                                              \
+    }                                                                                          \
+    static unsigned long long int name##_hash(const void *value) {                             \
+        ctype v = *(const ctype *)value;                                                       \
+        return hash_expr;                                                                      \
+    }                                                                                          \
+    static int name##_format(const void *value, char *str, size_t size) {                      \
+        return snprintf(str, size, format_string, *(const ctype *)value);                      \
+    }                                                                                          \
+    static void name##_scan(const COLUMN *col, unsigned int start, unsigned int end,           \
+                            const void *pivot, COMPARE_COUNTS *counts) {                        \
+        count_compare_kernel(type, col->values, col->validity, start, end, pivot, counts);      \
+    }                                                                                          \
+    static unsigned int name##_select(const COLUMN *col, unsigned int start, unsigned int end, \
+                                      FILTER_OP op, const void *pivot, const void *high,       \
+                                      unsigned long long int *selected) {                      \
+        return filter_kernel(type, col->values, col->validity, start, end, op, pivot, high,    \
+                             selected);                                                        \
+    }                                                                                          \
+    static void name##_write(TEXT_WRITER *writer, const void *value) {                         \
+        ctype v = *(const ctype *)value;                                                       \
+        write_expr;                                                                            \
+    }                                                                                          \
+    static const COLUMN_OPS name##_ops = {name##_compare, name##_hash, name##_format, fixed_copy, name##_scan, \
+                                          name##_select, name##_write};
+
+NUMERIC_OPS(uint, UINT, unsigned int, "%u", mix64(v), writer_put_uint(writer, v))
+NUMERIC_OPS(int, INT, int, "%d", mix64((unsigned long long int)(unsigned int)v), writer_put_int(writer, v))
+NUMERIC_OPS(char, CHAR, char, "%c", mix64((unsigned long long int)(unsigned char)v), writer_put_char(writer, v))
+NUMERIC_OPS(float, FLOAT, float, "%.2f", hash_double(v), writer_put_fixed(writer, v, 2))
+NUMERIC_OPS(double, DOUBLE, double, "%.2lf", hash_double(v), writer_put_fixed(writer, v, 2))
+
+// STRING: values live in the column arena, the buffer holds their offsets
+
+static int string_compare(const void *data1, const void *data2) {
+    return strcmp((const char *)data1, (const char *)data2);
+}
+
+// FNV-1a over the bytes of the string
+static unsigned long long int string_hash(const void *value) {
+    unsigned long long int h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)value; *p; p++) {
+        h = (h ^ *p) * 0x100000001b3ULL;
+    }
+    return mix64(h);
+}
+
+static int string_format(const void *value, char *str, size_t size) {
+    return snprintf(str, size, "%s", (const char *)value);
+}
+
+// A string of the arena itself (from get_value_at) is found again by its offset once the arena has moved
+// A row overwritten with a string no longer than its own keeps its bytes, a longer one leaves them dead
+static int string_copy(COLUMN *col, unsigned int index, const void *value) {
+    const char *str = (const char *)value;
+    size_t length = strlen(str);
+    size_t released = 0;
+    if (!is_null_at(col, index)) {
+        char *old = col->strings + ((unsigned long long int *)col->values)[index];
+        size_t old_length = strlen(old);
+        if (length <= old_length) {
+            memmove(old, str, length + 1);
+            col->strings_dead += old_length - length;
+            return 1;
+        }
+        released = old_length + 1;
+    }
+    size_t offset = (uintptr_t)str - (uintptr_t)col->strings;
+    int in_arena = col->strings != NULL && offset < col->strings_size;
+    if (!column_reserve_strings(col, length + 1)) return 0;
+    if (in_arena) str = col->strings + offset;
+    ((unsigned long long int *)col->values)[index] = column_append_string(col, str, length);
+    col->strings_dead += released;
+    return 1;
+}
+
+// Strings are compared in arena order, without any pointer chasing
+static void string_scan(const COLUMN *col, unsigned int start, unsigned int end,
+                        const void *pivot, COMPARE_COUNTS *counts) {
+    const unsigned long long int *offsets = (const unsigned long long int *)col->values;
+    unsigned long long int less = 0, equal = 0, greater = 0;
+    FOR_EACH_SET_BIT(col->validity, start, end, i,
+        int cmp = strcmp(col->strings + offsets[i], (const char *)pivot);
+        less += cmp < 0;
+        equal += cmp == 0;
+        greater += cmp > 0;
+    )
+    counts->less += less;
+    counts->equal += equal;
+    counts->greater += greater;
+}
+
+static unsigned int string_select(const COLUMN *col, unsigned int start, unsigned int end, FILTER_OP op,
+                                  const void *pivot, const void *high, unsigned long long int *selected) {
+    const unsigned long long int *offsets = (const unsigned long long int *)col->values;
+    unsigned int count = 0;
+    FOR_EACH_SET_BIT(col->validity, start, end, i,
+        const char *str = col->strings + offsets[i];
+        int cmp_high = op == FILTER_BETWEEN ? strcmp(str, (const char *)high) : 0;
+        if (filter_passes(op, strcmp(str, (const char *)pivot), cmp_high)) {
+            bitmap_set(selected, i);
+            count++;
+        }
+    )
+    return count;
+}
+
+static void string_write(TEXT_WRITER *writer, const void *value) {
+    writer_put_string(writer, (const char *)value);
+}
+
+static const COLUMN_OPS string_ops = {string_compare, string_hash, string_format, string_copy, string_scan,
+                                      string_select, string_write};
+
+// STRUCTURE: ordered and hashed by the value field
+
+static int structure_compare(const void *data1, const void *data2) {
+    return ((const CustomStructure *)data1)->value > ((const CustomStructure *)data2)->value ? 1 :
+           ((const CustomStructure *)data1)->value < ((const CustomStructure *)data2)->value ? -1 : 0;
+}
+
+static unsigned long long int structure_hash(const void *value) {
+    return hash_double(((const CustomStructure *)value)->value);
+}
+
+static int structure_format(const void *value, char *str, size_t size) {
+    const CustomStructure *cs = (const CustomStructure *)value;
+    // Create a formatted string with structure's fields
+    return snprintf(str, size, "ID: %d, Value: %.2f, Description: %s", cs->id, cs->value, cs->description);
+}
+
+static void structure_scan(const COLUMN *col, unsigned int start, unsigned int end,
+                           const void *pivot, COMPARE_COUNTS *counts) {
+    const CustomStructure *structs = (const CustomStructure *)col->values;
+    unsigned long long int less = 0, equal = 0, greater = 0;
+    FOR_EACH_SET_BIT(col->validity, start, end, i,
+        int cmp = structure_compare(&structs[i], pivot);
+        less += cmp < 0;
+        equal += cmp == 0;
+        greater += cmp > 0;
+    )
+    counts->less += less;
+    counts->equal += equal;
+    counts->greater += greater;
+}
+
+static unsigned int structure_select(const COLUMN *col, unsigned int start, unsigned int end, FILTER_OP op,
+                                     const void *pivot, const void *high, unsigned long long int *selected) {
+    const CustomStructure *structs = (const CustomStructure *)col->values;
+    unsigned int count = 0;
+    // A NaN value or bound is ordered with nothing and only passes FILTER_NE
+    double p = ((const CustomStructure *)pivot)->value;
+    double h = op == FILTER_BETWEEN ? ((const CustomStructure *)high)->value : p;
+    FOR_EACH_SET_BIT(col->validity, start, end, i,
+        double v = structs[i].value;
+        int unordered = v != v || p != p || h != h;
+        int cmp_high = op == FILTER_BETWEEN ? structure_compare(&structs[i], high) : 0;
+        if (unordered ? op == FILTER_NE : filter_passes(op, structure_compare(&structs[i], pivot), cmp_high)) {
+            bitmap_set(selected, i);
+            count++;
+        }
+    )
+    return count;
+}
+
+static void structure_write(TEXT_WRITER *writer, const void *value) {
+    const CustomStructure *cs = (const CustomStructure *)value;
+    writer_put_string(writer, "ID: ");
+    writer_put_int(writer, cs->id);
+    writer_put_string(writer, ", Value: ");
+    writer_put_fixed(writer, cs->value, 2);
+    writer_put_string(writer, ", Description: ");
+    writer_put_string(writer, cs->description);
+}
+
+static const COLUMN_OPS structure_ops = {structure_compare, structure_hash, structure_format, fixed_copy,
+                                         structure_scan, structure_select, structure_write};
+
+// NULLVAL and unknown types store nothing and never match
+
+static int unsupported_compare(const void *data1, const void *data2) {
+    (void)data1;
+    (void)data2;
+    fprintf(stderr, "Unsupported type for comparison.\n");
+    return -1;
+}
+
+static unsigned long long int null_hash(const void *value) {
+    (void)value;
+    return 0;
+}
+
+static int null_format(const void *value, char *str, size_t size) {
+    (void)value;
+    return snprintf(str, size, "NULL");
+}
+
+static int unsupported_format(const void *value, char *str, size_t size) {
+    (void)value;
+    return snprintf(str, size, "Unsupported Type");
+}
+
+static int null_copy(COLUMN *col, unsigned int index, const void *value) {
+    (void)col;
+    (void)index;
+    (void)value;
+    return 1;
+}
+
+static int unsupported_copy(COLUMN *col, unsigned int index, const void *value) {
+    (void)col;
+    (void)index;
+    (void)value;
+    fprintf(stderr, "Unsupported type for insertion.\n");
+    return 0;
+}
+
+static void null_scan(const COLUMN *col, unsigned int start, unsigned int end,
+                      const void *pivot, COMPARE_COUNTS *counts) {
+    (void)col;
+    (void)start;
+    (void)end;
+    (void)pivot;
+    (void)counts;
+}
+
+static unsigned int null_select(const COLUMN *col, unsigned int start, unsigned int end, FILTER_OP op,
+                                const void *pivot, const void *high, unsigned long long int *selected) {
+    (void)col;
+    (void)start;
+    (void)end;
+    (void)op;
+    (void)pivot;
+    (void)high;
+    (void)selected;
+    return 0;
+}
+
+static void null_write(TEXT_WRITER *writer, const void *value) {
+    (void)value;
+    writer_put_string(writer, "NULL");
+}
+
+static void unsupported_write(TEXT_WRITER *writer, const void *value) {
+    (void)value;
+    writer_put_string(writer, "Unsupported Type");
+}
+
+static const COLUMN_OPS null_ops = {unsupported_compare, null_hash, null_format, null_copy, null_scan, null_select,
+                                    null_write};
+static const COLUMN_OPS unsupported_ops = {unsupported_compare, null_hash, unsupported_format, unsupported_copy,
+                                           null_scan, null_select, unsupported_write};
+
+// Function to get the operations table of a type
+const COLUMN_OPS *get_column_ops(ENUM_TYPE type) {
+    switch (type) {
+        case NULLVAL:
+            return &null_ops;
+        case UINT:
+            return &uint_ops;
+        case INT:
+            return &int_ops;
+        case CHAR:
+            return &char_ops;
+        case FLOAT:
+            return &float_ops;
+        case DOUBLE:
+            return &double_ops;
+        case STRING:
+            return &string_ops;
+        case STRUCTURE:
+            return &structure_ops;
+        default:
+            return &unsupported_ops;
+    }
+}
@@ -0,0 +1,759 @@
+#include "csv.h"
+#include "memory.h"
+#include "writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+// Bytes of input below which the file is not split further
+#define CSV_MIN_CHUNK (1 << 20)
+// Chunks per pool thread, so that uneven chunks balance out
+#define CSV_CHUNKS_PER_THREAD 4
+// Rows a chunk makes room for at first
+#define CSV_INITIAL_ROWS 1024
+// Rows rendered by one task of write_csv
+#define CSV_WRITE_ROWS 16384
+
+// A field of a line, without its quotes
+typedef struct csv_field {
+    const char *start;
+    size_t length;
+    int quoted;
+    int escaped;  // 1 when the field holds doubled quotes to collapse
+} CSV_FIELD;
+
+// Typed values parsed by one chunk for one column
+typedef struct chunk_column {
+    void *values;  // One value per row, arena offsets for STRING
+    char *strings;  // Arena of the NUL-terminated strings of a STRING column
+    size_t strings_size;
+    size_t strings_capacity;
+    unsigned int *nulls;  // Rows of the chunk holding a null
+    unsigned int null_count;
+    unsigned int null_capacity;
+} CHUNK_COLUMN;
+
+// A range of whole lines of the file and what was parsed from it
+typedef struct csv_chunk {
+    const char *begin;
+    const char *end;
+    unsigned int rows;
+    unsigned int capacity;
+    CHUNK_COLUMN *columns;
+    unsigned long long int bad_values;  // Fields that did not parse as their column type, stored as nulls
+    unsigned long long int ragged_rows;  // Rows with more fields than columns, the extra fields dropped
+    int failed;
+} CSV_CHUNK;
+
+typedef struct csv_job {
+    CSV_CHUNK *chunks;
+    const ENUM_TYPE *types;
+    unsigned int num_columns;
+    char delimiter;
+} CSV_JOB;
+
+// Fills options with the defaults
+void csv_default_options(CSV_OPTIONS *options) {
+    options->delimiter = ',';
+    options->has_header = 1;
+    options->types = NULL;
+    options->num_types = 0;
+    options->sample_rows = 1000;
+    options->use_arena = 0;
+}
+
+// Reads the field at p and returns the position of the delimiter, line break or end of input closing it
+static const char *next_field(const char *p, const char *end, char delimiter, CSV_FIELD *field) {
+    field->escaped = 0;
+    if (p < end && *p == '"') {
+        field->quoted = 1;
+        field->start = ++p;
+        while (p < end && *p != '\n') {
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    field->escaped = 1;
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            p++;
+        }
+        field->length = (size_t)(p - field->start);
+        // Whatever follows the closing quote up to the delimiter is dropped
+        while (p < end && *p != delimiter && *p != '\n') p++;
+        return p;
+    }
+
+    field->quoted = 0;
+    field->start = p;
+    while (p < end && *p != delimiter && *p != '\n') p++;
+    field->length = (size_t)(p - field->start);
+    // CRLF line endings
+    if ((p == end || *p == '\n') && field->length > 0 && field->start[field->length - 1] == '\r') field->length--;
+    return p;
+}
+
+// Splits the line at p into fields, keeping the first max_fields of them; returns the start of the next line
+static const char *split_line(const char *p, const char *end, char delimiter, CSV_FIELD *fields,
+                              unsigned int max_fields, unsigned int *num_fields) {
+    unsigned int n = 0;
+    for (;;) {
+        CSV_FIELD field;
+        p = next_field(p, end, delimiter, &field);
+        if (n < max_fields) fields[n] = field;
+        n++;
+        if (p < end && *p == delimiter) {
+            p++;
+            continue;
+        }
+        break;
+    }
+    *num_fields = n;
+    return p < end ? p + 1 : p;
+}
+
+static int is_blank_line(const CSV_FIELD *first, unsigned int num_fields) {
+    return num_fields == 1 && first->length == 0 && !first->quoted;
+}
+
+// Copies a field into dst (length + 1 bytes), collapsing doubled quotes, and returns the copied length
+static size_t copy_field(const CSV_FIELD *field, char *dst) {
+    if (!field->escaped) {
+        memcpy(dst, field->start, field->length);
+        dst[field->length] = '\0';
+        return field->length;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < field->length; i++) {
+        dst[n++] = field->start[i];
+        if (field->start[i] == '"') i++;
+    }
+    dst[n] = '\0';
+    return n;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static void trim_spaces(const char **s, size_t *n) {
+    while (*n > 0 && is_space(**s)) {
+        (*s)++;
+        (*n)--;
+    }
+    while (*n > 0 && is_space((*s)[*n - 1])) (*n)--;
+}
+
+// Parses an optionally signed decimal integer of at most 19 digits, returns 0 if the text is anything else
+static int parse_integer(const char *s, size_t n, int *negative, unsigned long long int *magnitude) {
+    trim_spaces(&s, &n);
+    *negative = 0;
+    if (n > 0 && (*s == '-' || *s == '+')) {
+        *negative = *s == '-';
+        s++;
+        n--;
+    }
+    if (n == 0 || n > 19) return 0;
+    unsigned long long int value = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned int digit = (unsigned int)(s[i] - '0');
+        if (digit > 9) return 0;
+        value = value * 10 + digit;
+    }
+    *magnitude = value;
+    return 1;
+}
+
+static int parse_int(const char *s, size_t n, int *out) {
+    int negative;
+    unsigned long long int magnitude;
+    if (!parse_integer(s, n, &negative, &magnitude)) return 0;
+    if (magnitude > (negative ? (unsigned long long int)INT_MAX + 1 : (unsigned long long int)INT_MAX)) return 0;
+    *out = negative ? (int)(0 - magnitude) : (int)magnitude;
+    return 1;
+}
+
+static int parse_uint(const char *s, size_t n, unsigned int *out) {
+    int negative;
+    unsigned long long int magnitude;
+    if (!parse_integer(s, n, &negative, &magnitude)) return 0;
+    if ((negative && magnitude != 0) || magnitude > UINT_MAX) return 0;
+    *out = (unsigned int)magnitude;
+    return 1;
+}
+
+// Powers of ten exactly representable as doubles
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses a decimal number; the common short forms are converted exactly by one multiplication or division
+// (both operands are exact doubles), anything else goes through strtod
+static int parse_double(const char *s, size_t n, double *out) {
+    trim_spaces(&s, &n);
+    if (n == 0) return 0;
+    const char *p = s, *end = s + n;
+    int negative = 0;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+
+    unsigned long long int mantissa = 0;
+    int significant = 0, digits = 0, exponent = 0, truncated = 0;
+    for (; p < end && (unsigned int)(*p - '0') <= 9; p++, digits++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (unsigned int)(*p - '0');
+            if (mantissa > 0) significant++;
+        } else {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned int)(*p - '0') <= 9; p++, digits++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (unsigned int)(*p - '0');
+                if (mantissa > 0) significant++;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (digits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int exp_negative = 0, exp_value = 0, exp_digits = 0;
+        if (q < end && (*q == '-' || *q == '+')) exp_negative = *q++ == '-';
+        for (; q < end && (unsigned int)(*q - '0') <= 9; q++, exp_digits++) {
+            if (exp_value < 10000) exp_value = exp_value * 10 + (*q - '0');
+        }
+        if (exp_digits > 0) {
+            exponent += exp_negative ? -exp_value : exp_value;
+            p = q;
+        }
+    }
+
+    if (digits > 0 && p == end && !truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / exact_powers_of_ten[-exponent] : value * exact_powers_of_ten[exponent];
+        *out = negative ? -value : value;
+        return 1;
+    }
+
+    // Long mantissas, large exponents, inf and nan
+    char buffer[128];
+    if (n >= sizeof(buffer)) return 0;
+    memcpy(buffer, s, n);
+    buffer[n] = '\0';
+    char *stop;
+    *out = strtod(buffer, &stop);
+    return stop == buffer + n;
+}
+
+// Makes room for one more row in every column of a chunk
+static int grow_chunk(CSV_CHUNK *chunk, const ENUM_TYPE *types, unsigned int num_columns) {
+    if (chunk->capacity == UINT_MAX) return 0;
+    unsigned int capacity = chunk->capacity == 0 ? CSV_INITIAL_ROWS :
+                            chunk->capacity > UINT_MAX / 2 ? UINT_MAX : chunk->capacity * 2;
+    for (unsigned int c = 0; c < num_columns; c++) {
+        size_t width = types[c] == STRING ? sizeof(unsigned long long int) : type_size(types[c]);
+        void *values = realloc(chunk->columns[c].values, (size_t)capacity * width);
+        if (!values) return 0;
+        chunk->columns[c].values = values;
+    }
+    chunk->capacity = capacity;
+    return 1;
+}
+
+static int add_null(CHUNK_COLUMN *column, unsigned int row) {
+    if (column->null_count == column->null_capacity) {
+        unsigned int capacity = column->null_capacity == 0 ? 64 : column->null_capacity * 2;
+        unsigned int *nulls = (unsigned int *)realloc(column->nulls, (size_t)capacity * sizeof(unsigned int));
+        if (!nulls) return 0;
+        column->nulls = nulls;
+        column->null_capacity = capacity;
+    }
+    column->nulls[column->null_count++] = row;
+    return 1;
+}
+
+// Stores a field as the value of a row of a chunk column, returns 0 on allocation failure
+static int store_field(CSV_CHUNK *chunk, CHUNK_COLUMN *column, ENUM_TYPE type, unsigned int row,
+                       const CSV_FIELD *field) {
+    // An empty unquoted field is a null, "" is an empty string
+    int ok = field->quoted || field->length > 0;
+    switch (type) {
+        case STRING:
+            if (ok) {
+                if (column->strings_size + field->length + 1 > column->strings_capacity) {
+                    size_t capacity = column->strings_capacity == 0 ? 4096 : column->strings_capacity * 2;
+                    while (capacity < column->strings_size + field->length + 1) capacity *= 2;
+                    char *strings = (char *)realloc(column->strings, capacity);
+                    if (!strings) return 0;
+                    column->strings = strings;
+                    column->strings_capacity = capacity;
+                }
+                ((unsigned long long int *)column->values)[row] = column->strings_size;
+                column->strings_size += copy_field(field, column->strings + column->strings_size) + 1;
+            } else {
+                ((unsigned long long int *)column->values)[row] = 0;
+            }
+            break;
+        case CHAR:
+            // A quote character is written doubled in a quoted field
+            ok = ok && (field->length == 1 || (field->escaped && field->length == 2));
+            ((char *)column->values)[row] = ok ? field->start[0] : 0;
+            break;
+        case INT:
+            ok = ok && !field->escaped && parse_int(field->start, field->length, (int *)column->values + row);
+            if (!ok) ((int *)column->values)[row] = 0;
+            break;
+        case UINT:
+            ok = ok && !field->escaped &&
+                 parse_uint(field->start, field->length, (unsigned int *)column->values + row);
+            if (!ok) ((unsigned int *)column->values)[row] = 0;
+            break;
+        case FLOAT:
+        case DOUBLE: {
+            double value = 0;
+            ok = ok && !field->escaped && parse_double(field->start, field->length, &value);
+            if (!ok) value = 0;
+            if (type == FLOAT) {
+                ((float *)column->values)[row] = (float)value;
+            } else {
+                ((double *)column->values)[row] = value;
+            }
+            break;
+        }
+        default:
+            ok = 0;
+            break;
+    }
+    if (!ok) {
+        if (field->quoted || field->length > 0) chunk->bad_values++;
+        return add_null(column, row);
+    }
+    return 1;
+}
+
+// Parses the lines of one chunk into its typed buffers
+static void parse_chunk(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    CSV_JOB *job = (CSV_JOB *)ctx;
+    CSV_CHUNK *chunk = &job->chunks[task_index];
+    CSV_FIELD *fields = (CSV_FIELD *)malloc(job->num_columns * sizeof(CSV_FIELD));
+    chunk->columns = (CHUNK_COLUMN *)calloc(job->num_columns, sizeof(CHUNK_COLUMN));
+    if (!fields || !chunk->columns) {
+        free(fields);
+        chunk->failed = 1;
+        return;
+    }
+
+    const char *p = chunk->begin;
+    while (p < chunk->end) {
+        unsigned int num_fields;
+        p = split_line(p, chunk->end, job->delimiter, fields, job->num_columns, &num_fields);
+        if (is_blank_line(&fields[0], num_fields)) continue;
+        if (num_fields > job->num_columns) chunk->ragged_rows++;
+        if (chunk->rows == chunk->capacity && !grow_chunk(chunk, job->types, job->num_columns)) {
+            chunk->failed = 1;
+            break;
+        }
+        for (unsigned int c = 0; c < job->num_columns; c++) {
+            // Missing trailing fields are nulls
+            CSV_FIELD missing = {p, 0, 0, 0};
+            if (!store_field(chunk, &chunk->columns[c], job->types[c], chunk->rows, c < num_fields ? &fields[c] : &missing)) {
+                chunk->failed = 1;
+                break;
+            }
+        }
+        if (chunk->failed) break;
+        chunk->rows++;
+    }
+    free(fields);
+}
+
+static void free_chunks(CSV_CHUNK *chunks, unsigned int num_chunks, unsigned int num_columns) {
+    for (unsigned int k = 0; k < num_chunks; k++) {
+        if (!chunks[k].columns) continue;
+        for (unsigned int c = 0; c < num_columns; c++) {
+            free(chunks[k].columns[c].values);
+            free(chunks[k].columns[c].strings);
+            free(chunks[k].columns[c].nulls);
+        }
+        free(chunks[k].columns);
+    }
+    free(chunks);
+}
+
+// Widest type needed by a sample field: INT, then DOUBLE, then STRING; NULLVAL for a null
+static ENUM_TYPE infer_field_type(const CSV_FIELD *field) {
+    if (!field->quoted && field->length == 0) return NULLVAL;
+    if (field->escaped) return STRING;
+    int i;
+    double d;
+    if (parse_int(field->start, field->length, &i)) return INT;
+    if (parse_double(field->start, field->length, &d)) return DOUBLE;
+    return STRING;
+}
+
+// Infers the columns without a given type from the first sample_rows lines of the data
+static void infer_types(const char *p, const char *end, const CSV_OPTIONS *options, ENUM_TYPE *types,
+                        const int *given, CSV_FIELD *fields, unsigned int num_columns) {
+    for (unsigned int c = 0; c < num_columns; c++) {
+        if (!given[c]) types[c] = NULLVAL;
+    }
+    for (unsigned int rows = 0; p < end && rows < options->sample_rows;) {
+        unsigned int num_fields;
+        p = split_line(p, end, options->delimiter, fields, num_columns, &num_fields);
+        if (is_blank_line(&fields[0], num_fields)) continue;
+        for (unsigned int c = 0; c < num_columns && c < num_fields; c++) {
+            if (given[c] || types[c] == STRING) continue;
+            ENUM_TYPE type = infer_field_type(&fields[c]);
+            if (type != NULLVAL && (types[c] == NULLVAL || type != INT)) types[c] = type;
+        }
+        rows++;
+    }
+    // Columns without a single value in the sample
+    for (unsigned int c = 0; c < num_columns; c++) {
+        if (!given[c] && types[c] == NULLVAL) types[c] = STRING;
+    }
+}
+
+// Appends the rows parsed by a chunk to a column
+// The null rows of the chunk go in with the batch, so the zone map and the hash index never see their placeholders
+static int append_chunk_column(COLUMN *col, const CSV_CHUNK *chunk, const CHUNK_COLUMN *column) {
+    if (col->column_type == STRING) {
+        char **strings = (char **)malloc(((size_t)chunk->rows + 1) * sizeof(char *));
+        if (!strings) return 0;
+        const unsigned long long int *offsets = (const unsigned long long int *)column->values;
+        for (unsigned int r = 0; r < chunk->rows; r++) strings[r] = column->strings + offsets[r];
+        int ok = column_append_n_nulls(col, strings, chunk->rows, column->nulls, column->null_count);
+        free(strings);
+        return ok;
+    }
+    return column_append_n_nulls(col, column->values, chunk->rows, column->nulls, column->null_count);
+}
+
+// Builds the dataframe from the parsed chunks, in file order
+static DATAFRAME *assemble_dataframe(CSV_CHUNK *chunks, unsigned int num_chunks, const ENUM_TYPE *types,
+                                     char **titles, unsigned int num_columns, int use_arena) {
+    unsigned long long int rows = 0, bad_values = 0, ragged_rows = 0;
+    for (unsigned int k = 0; k < num_chunks; k++) {
+        rows += chunks[k].rows;
+        bad_values += chunks[k].bad_values;
+        ragged_rows += chunks[k].ragged_rows;
+    }
+    if (rows > UINT_MAX) {
+        fprintf(stderr, "CSV file has too many rows (%llu).\n", rows);
+        return NULL;
+    }
+
+    // In an arena the buffers are reserved to their final size, so they are bump-allocated once
+    DATAFRAME *df = use_arena ? create_arena_dataframe(0) : create_dataframe();
+    if (!df) return NULL;
+    for (unsigned int c = 0; c < num_columns; c++) {
+        COLUMN *col = add_new_column_to_dataframe(df, types[c], titles[c]);
+        if (!col) {
+            free_dataframe(df);
+            return NULL;
+        }
+        int ok = column_reserve(col, (unsigned int)rows);
+        for (unsigned int k = 0; ok && k < num_chunks; k++) {
+            ok = append_chunk_column(col, &chunks[k], &chunks[k].columns[c]);
+        }
+        if (!ok) {
+            fprintf(stderr, "Memory allocation failed while loading column '%s'.\n", titles[c]);
+            free_dataframe(df);
+            return NULL;
+        }
+    }
+    if (bad_values > 0) {
+        fprintf(stderr, "%llu CSV values did not match their column type and were stored as nulls.\n", bad_values);
+    }
+    if (ragged_rows > 0) {
+        fprintf(stderr, "%llu CSV rows had more fields than the %u columns, the extra fields were dropped.\n",
+                ragged_rows, num_columns);
+    }
+    return df;
+}
+
+// Loads a CSV file into a new dataframe
+DATAFRAME *read_csv(const char *path, const CSV_OPTIONS *options) {
+    CSV_OPTIONS defaults;
+    if (options == NULL) {
+        csv_default_options(&defaults);
+        options = &defaults;
+    }
+    if (path == NULL || options->delimiter == '\n' || options->delimiter == '"') {
+        fprintf(stderr, "Invalid arguments for reading a CSV file.\n");
+        return NULL;
+    }
+
+    size_t size;
+    const char *data = map_file(path, &size);
+    if (data == NULL) {
+        fprintf(stderr, "Cannot open the CSV file '%s'.\n", path);
+        return NULL;
+    }
+    const char *end = data + size;
+    if (size == 0) {
+        unmap_file(data, size);
+        return create_dataframe();
+    }
+
+    // The first line gives the number of columns, and their titles when it is a header
+    unsigned int num_columns;
+    split_line(data, end, options->delimiter, NULL, 0, &num_columns);
+    CSV_FIELD *fields = (CSV_FIELD *)malloc(num_columns * sizeof(CSV_FIELD));
+    ENUM_TYPE *types = (ENUM_TYPE *)malloc(num_columns * sizeof(ENUM_TYPE));
+    int *given = (int *)calloc(num_columns, sizeof(int));
+    char **titles = (char **)calloc(num_columns, sizeof(char *));
+    DATAFRAME *df = NULL;
+    CSV_CHUNK *chunks = NULL;
+    unsigned int num_chunks = 0;
+    if (!fields || !types || !given || !titles) {
+        fprintf(stderr, "Memory allocation failed for reading a CSV file.\n");
+        goto cleanup;
+    }
+
+    const char *body = data;
+    if (options->has_header) {
+        unsigned int header_fields;
+        body = split_line(data, end, options->delimiter, fields, num_columns, &header_fields);
+    }
+    for (unsigned int c = 0; c < num_columns; c++) {
+        titles[c] = (char *)malloc(options->has_header ? fields[c].length + 1 : 32);
+        if (!titles[c]) {
+            fprintf(stderr, "Memory allocation failed for reading a CSV file.\n");
+            goto cleanup;
+        }
+        if (options->has_header) {
+            copy_field(&fields[c], titles[c]);
+        } else {
+            snprintf(titles[c], 32, "Column %u", c + 1);
+        }
+    }
+
+    for (unsigned int c = 0; c < num_columns && c < options->num_types && options->types; c++) {
+        if (options->types[c] == NULL) continue;
+        types[c] = parse_type(options->types[c]);
+        if (types[c] != UINT && types[c] != INT && types[c] != CHAR && types[c] != FLOAT &&
+            types[c] != DOUBLE && types[c] != STRING) {
+            fprintf(stderr, "Unsupported CSV column type '%s'.\n", options->types[c]);
+            goto cleanup;
+        }
+        given[c] = 1;
+    }
+    infer_types(body, end, options, types, given, fields, num_columns);
+
+    // Split the data at line boundaries, a few chunks per thread
+    THREAD_POOL *pool = get_default_thread_pool();
+    size_t body_size = (size_t)(end - body);
+    size_t max_chunks = (size_t)thread_pool_size(pool) * CSV_CHUNKS_PER_THREAD;
+    size_t wanted = body_size / CSV_MIN_CHUNK;
+    num_chunks = (unsigned int)(wanted < 1 ? 1 : wanted > max_chunks ? max_chunks : wanted);
+    chunks = (CSV_CHUNK *)calloc(num_chunks, sizeof(CSV_CHUNK));
+    if (!chunks) {
+        fprintf(stderr, "Memory allocation failed for reading a CSV file.\n");
+        goto cleanup;
+    }
+    const char *start = body;
+    for (unsigned int k = 0; k < num_chunks; k++) {
+        const char *stop = k + 1 == num_chunks ? end : body + body_size / num_chunks * (k + 1);
+        if (stop < start) stop = start;
+        const char *newline = stop < end ? memchr(stop, '\n', (size_t)(end - stop)) : NULL;
+        if (k + 1 < num_chunks) stop = newline ? newline + 1 : end;
+        chunks[k].begin = start;
+        chunks[k].end = stop;
+        start = stop;
+    }
+
+    CSV_JOB job = {chunks, types, num_columns, options->delimiter};
+    thread_pool_run(pool, num_chunks, parse_chunk, &job);
+    for (unsigned int k = 0; k < num_chunks; k++) {
+        if (chunks[k].failed) {
+            fprintf(stderr, "Memory allocation failed while parsing the CSV file.\n");
+            goto cleanup;
+        }
+    }
+    df = assemble_dataframe(chunks, num_chunks, types, titles, num_columns, options->use_arena);
+
+cleanup:
+    if (chunks) free_chunks(chunks, num_chunks, num_columns);
+    if (titles) {
+        for (unsigned int c = 0; c < num_columns; c++) free(titles[c]);
+    }
+    free(titles);
+    free(given);
+    free(types);
+    free(fields);
+    unmap_file(data, size);
+    return df;
+}
+
+typedef struct csv_write_job {
+    DATAFRAME *df;
+    char delimiter;
+    unsigned int first_row;  // First row of the wave
+    unsigned int num_rows;  // Rows of the dataframe
+    TEXT_WRITER *texts;  // One in-memory writer per task of the wave
+    atomic_int line_break;  // A text held a line break, which read_csv cannot read back
+} CSV_WRITE_JOB;
+
+// Writes text as a field, quoted when it holds a delimiter, a quote or a carriage return, or is empty
+// Returns 0 without writing anything for a text holding a line break, read_csv reading fields within one line
+static int write_text_field(TEXT_WRITER *writer, const char *text, char delimiter) {
+    size_t length = strcspn(text, (const char[]){delimiter, '"', '\n', '\r', '\0'});
+    if (length > 0 && text[length] == '\0') {
+        writer_put(writer, text, length);
+        return 1;
+    }
+    if (strchr(text + length, '\n') != NULL) return 0;
+    writer_put_char(writer, '"');
+    for (const char *quote; (quote = strchr(text, '"')) != NULL; text = quote + 1) {
+        // Doubled quote
+        writer_put(writer, text, (size_t)(quote - text + 1));
+        writer_put_char(writer, '"');
+    }
+    writer_put_string(writer, text);
+    writer_put_char(writer, '"');
+    return 1;
+}
+
+// Writes the cell of a row as a field, nothing for a null or missing cell; returns 0 for a text with a line break
+static int write_csv_field(TEXT_WRITER *writer, COLUMN *col, unsigned int row, char delimiter) {
+    void *cell = row < col->size ? get_value_at(col, row) : NULL;
+    if (cell == NULL) return 1;
+    switch (col->column_type) {
+        case UINT:
+            writer_put_uint(writer, *(unsigned int *)cell);
+            break;
+        case INT:
+            writer_put_int(writer, *(int *)cell);
+            break;
+        case FLOAT:
+            writer_put_float(writer, *(float *)cell);
+            break;
+        case DOUBLE:
+            writer_put_double(writer, *(double *)cell);
+            break;
+        case CHAR:
+            return write_text_field(writer, (const char[]){*(char *)cell, '\0'}, delimiter);
+        case STRING:
+            return write_text_field(writer, (const char *)cell, delimiter);
+        default: {
+            // Structures are written as their display text
+            int length = col->ops->format(cell, NULL, 0);
+            char *text = length >= 0 ? (char *)malloc((size_t)length + 1) : NULL;
+            int ok = 1;
+            if (text) {
+                col->ops->format(cell, text, (size_t)length + 1);
+                ok = write_text_field(writer, text, delimiter);
+                free(text);
+            }
+            return ok;
+        }
+    }
+    return 1;
+}
+
+// Renders the rows of one task of the wave
+static void render_csv_rows(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    CSV_WRITE_JOB *job = (CSV_WRITE_JOB *)ctx;
+    TEXT_WRITER *writer = &job->texts[task_index];
+    unsigned long long int start = job->first_row + (unsigned long long int)task_index * CSV_WRITE_ROWS;
+    unsigned long long int end = start + CSV_WRITE_ROWS < job->num_rows ? start + CSV_WRITE_ROWS : job->num_rows;
+    for (unsigned long long int row = start; row < end; row++) {
+        // Rows deleted from the dataframe are deleted from every column
+        unsigned int c = 0;
+        while (c < job->df->column_count && !is_deleted_at(job->df->columns[c], (unsigned int)row)) c++;
+        if (c < job->df->column_count) continue;
+        for (c = 0; c < job->df->column_count; c++) {
+            if (c > 0) writer_put_char(writer, job->delimiter);
+            if (!write_csv_field(writer, job->df->columns[c], (unsigned int)row, job->delimiter)) {
+                atomic_store_explicit(&job->line_break, 1, memory_order_relaxed);
+                return;
+            }
+        }
+        writer_put_char(writer, '\n');
+    }
+}
+
+// Writes a dataframe as CSV, rendering waves of row ranges in parallel and writing them in order
+int write_csv(DATAFRAME *df, const char *path, const CSV_OPTIONS *options) {
+    CSV_OPTIONS defaults;
+    if (options == NULL) {
+        csv_default_options(&defaults);
+        options = &defaults;
+    }
+    if (!df || !path || options->delimiter == '\n' || options->delimiter == '"') {
+        fprintf(stderr, "Invalid arguments for writing a CSV file.\n");
+        return -1;
+    }
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot create the CSV file '%s'.\n", path);
+        return -1;
+    }
+
+    TEXT_WRITER out;
+    writer_init(&out, fileno(file));
+    int line_break = 0;
+    if (options->has_header) {
+        for (unsigned int c = 0; c < df->column_count && !line_break; c++) {
+            if (c > 0) writer_put_char(&out, options->delimiter);
+            line_break = !write_text_field(&out, df->columns[c]->title, options->delimiter);
+        }
+        writer_put_char(&out, '\n');
+    }
+
+    unsigned int num_rows = 0;
+    for (unsigned int c = 0; c < df->column_count; c++) {
+        if (df->columns[c]->size > num_rows) num_rows = df->columns[c]->size;
+    }
+    THREAD_POOL *pool = df->pool ? df->pool : get_default_thread_pool();
+    unsigned int wave = thread_pool_size(pool) * 2;
+    TEXT_WRITER *texts = (TEXT_WRITER *)malloc(wave * sizeof(TEXT_WRITER));
+    int ok = texts != NULL;
+    for (unsigned int k = 0; ok && k < wave; k++) {
+        writer_init(&texts[k], -1);
+    }
+    CSV_WRITE_JOB job = {df, options->delimiter, 0, num_rows, texts, line_break};
+    for (unsigned long long int first = 0; ok && !atomic_load(&job.line_break) && first < num_rows;
+         first += (unsigned long long int)wave * CSV_WRITE_ROWS) {
+        unsigned long long int tasks = (num_rows - first + CSV_WRITE_ROWS - 1) / CSV_WRITE_ROWS;
+        unsigned int n = tasks < wave ? (unsigned int)tasks : wave;
+        job.first_row = (unsigned int)first;
+        thread_pool_run(pool, n, render_csv_rows, &job);
+        for (unsigned int k = 0; k < n; k++) {
+            ok = ok && !texts[k].failed;
+            writer_put(&out, texts[k].data, texts[k].length);
+            texts[k].length = 0;
+        }
+    }
+    if (texts) {
+        for (unsigned int k = 0; k < wave; k++) {
+            writer_close(&texts[k]);
+        }
+    }
+    free(texts);
+    ok = writer_close(&out) && ok;
+    ok = fclose(file) == 0 && ok;
+    if (atomic_load(&job.line_break)) {
+        fprintf(stderr, "Cannot write '%s': a CSV field would hold a line break, which read_csv cannot read back.\n",
+                path);
+        return -1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to write the CSV file '%s'.\n", path);
+        return -1;
+    }
+    return 0;
+}
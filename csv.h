@@ -0,0 +1,34 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include "cdataframe.h"
+
+// Options of read_csv
+typedef struct csv_options {
+    char delimiter;  // Field separator, ',' by default
+    int has_header;  // 1 when the first line holds the column titles, 1 by default
+    const char **types;  // parse_type names ("INT", "UINT", "CHAR", "FLOAT", "DOUBLE", "STRING") per column, NULL to infer
+    unsigned int num_types;  // Entries of types; the columns past them are inferred
+    unsigned int sample_rows;  // Rows read to infer the types, 1000 by default
+    int use_arena;  // 1 to allocate the columns from an arena of the dataframe (create_arena_dataframe), 0 by default
+} CSV_OPTIONS;
+
+// Function prototypes for loading CSV files
+
+// Fill options with the defaults
+void csv_default_options(CSV_OPTIONS *options);
+
+// Load a CSV file into a new dataframe, NULL options for the defaults; returns NULL on failure
+// The file is mapped and split into chunks at line boundaries that are parsed in parallel
+// Empty fields are nulls; quoted fields may hold delimiters and doubled quotes but no line break
+// Missing trailing fields are nulls; fields past the number of columns are dropped, and the rows holding some
+// are counted and reported on stderr like the values that do not parse as their column type
+DATAFRAME *read_csv(const char *path, const CSV_OPTIONS *options);
+
+// Write a dataframe as CSV with the delimiter and header setting of options (NULL for the defaults)
+// Nulls and the missing cells of shorter columns are empty fields; doubles and floats are written so that
+// read_csv gives them back exactly; returns 0 on success and -1 on failure, a title or text holding a line
+// break included (read_csv could not read it back)
+int write_csv(DATAFRAME *df, const char *path, const CSV_OPTIONS *options);
+
+#endif // CSV_H
@@ -0,0 +1,178 @@
+#include "filter.h"
+#include "bitmap.h"
+#include "stats.h"
+#include "zonemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Filter of the segments of a column into one selection
+typedef struct filter_job {
+    const COLUMN *col;
+    FILTER_OP op;
+    const void *pivot;
+    const void *high;
+    unsigned long long int *bits;
+    unsigned int *counts;  // Selected rows of each segment
+} FILTER_JOB;
+
+// Selected rows of a dataframe copied column by column
+typedef struct filter_gather_job {
+    COLUMN **targets;
+    COLUMN **sources;
+    const unsigned int *rows;
+    unsigned int count;
+    char *failed;  // One flag per column
+} FILTER_GATHER_JOB;
+
+// Filters one segment block by block, skipping the zone map blocks whose bounds rule out every value
+// Segments are whole numbers of bitmap words, so the segments of a column write to distinct words
+static void filter_segment(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    FILTER_JOB *job = (FILTER_JOB *)ctx;
+    const COLUMN *col = job->col;
+    unsigned int start = task_index * SEGMENT_ROWS;
+    unsigned int end = col->size - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : col->size;
+    unsigned int count = 0;
+    for (unsigned int row = start; row < end;) {
+        unsigned int stop = end - row > ZONE_ROWS ? row + ZONE_ROWS : end;
+        if (!zone_map_rules_out(col, row, job->op, job->pivot, job->high)) {
+            count += col->ops->select(col, row, stop, job->op, job->pivot, job->high, job->bits);
+        }
+        row = stop;
+    }
+    job->counts[task_index] = count;
+}
+
+// Function to select the rows of a column passing a filter
+SELECTION *column_filter(COLUMN *col, FILTER_OP op, void *pivot, void *high) {
+    STAT_SCOPE(COLUMN_FILTER, col != NULL ? col->size : 0);
+    if (col == NULL || pivot == NULL || op < FILTER_LT || op > FILTER_BETWEEN ||
+        (op == FILTER_BETWEEN && high == NULL)) {
+        fprintf(stderr, "Invalid filter arguments.\n");
+        return NULL;
+    }
+    unsigned int segments = (col->size + SEGMENT_ROWS - 1) / SEGMENT_ROWS;
+    SELECTION *sel = (SELECTION *)malloc(sizeof(SELECTION));
+    unsigned long long int *bits = (unsigned long long int *)calloc(bitmap_words(col->size) + 1,
+                                                                    sizeof(unsigned long long int));
+    unsigned int *counts = (unsigned int *)calloc((size_t)segments + 1, sizeof(unsigned int));
+    if (sel == NULL || bits == NULL || counts == NULL) {
+        fprintf(stderr, "Memory allocation failed for the selection.\n");
+        free(sel);
+        free(bits);
+        free(counts);
+        return NULL;
+    }
+
+    // Segments are filtered in parallel, each into its own words of the bitmap
+    FILTER_JOB job = {col, op, pivot, high, bits, counts};
+    thread_pool_run(get_default_thread_pool(), segments, filter_segment, &job);
+    sel->bits = bits;
+    sel->rows = col->size;
+    sel->count = 0;
+    for (unsigned int s = 0; s < segments; s++) sel->count += counts[s];
+    free(counts);
+    return sel;
+}
+
+static unsigned int count_selected(const SELECTION *sel) {
+    unsigned int count = 0;
+    for (unsigned long long int w = 0; w < bitmap_words(sel->rows); w++) {
+        count += (unsigned int)popcount64(sel->bits[w]);
+    }
+    return count;
+}
+
+// Function to intersect two selections
+int selection_and(SELECTION *sel, const SELECTION *other) {
+    if (sel == NULL || other == NULL || sel->rows != other->rows) {
+        fprintf(stderr, "Selections of different rows cannot be combined.\n");
+        return 0;
+    }
+    for (unsigned long long int w = 0; w < bitmap_words(sel->rows); w++) sel->bits[w] &= other->bits[w];
+    sel->count = count_selected(sel);
+    return 1;
+}
+
+// Function to unite two selections
+int selection_or(SELECTION *sel, const SELECTION *other) {
+    if (sel == NULL || other == NULL || sel->rows != other->rows) {
+        fprintf(stderr, "Selections of different rows cannot be combined.\n");
+        return 0;
+    }
+    for (unsigned long long int w = 0; w < bitmap_words(sel->rows); w++) sel->bits[w] |= other->bits[w];
+    sel->count = count_selected(sel);
+    return 1;
+}
+
+// Function to list the selected rows
+unsigned int selection_to_rows(const SELECTION *sel, unsigned int *rows) {
+    if (sel == NULL || rows == NULL) return 0;
+    unsigned int n = 0;
+    FOR_EACH_SET_BIT(sel->bits, 0, sel->rows, row,
+        rows[n++] = row;
+    )
+    return n;
+}
+
+// Function to free a selection
+void free_selection(SELECTION **sel) {
+    if (sel == NULL || *sel == NULL) return;
+    free((*sel)->bits);
+    free(*sel);
+    *sel = NULL;
+}
+
+static void gather_selected(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    FILTER_GATHER_JOB *job = (FILTER_GATHER_JOB *)ctx;
+    job->failed[task_index] = !column_append_gather(job->targets[task_index], job->sources[task_index], job->rows,
+                                                    job->count);
+}
+
+// Function to copy the selected rows of a dataframe into a new one
+DATAFRAME *dataframe_filter(DATAFRAME *df, const SELECTION *sel) {
+    STAT_SCOPE(DATAFRAME_FILTER, sel != NULL ? sel->rows : 0);
+    if (df == NULL || sel == NULL) {
+        fprintf(stderr, "Invalid filter arguments.\n");
+        return NULL;
+    }
+    DATAFRAME *result = create_dataframe();
+    unsigned int columns = df->column_count;
+    FILTER_GATHER_JOB job = {NULL, NULL, NULL, sel->count, NULL};
+    unsigned int *rows = (unsigned int *)malloc(((size_t)sel->count + 1) * sizeof(unsigned int));
+    job.targets = (COLUMN **)malloc((columns + 1) * sizeof(COLUMN *));
+    job.sources = df->columns;
+    job.failed = (char *)calloc(columns + 1, 1);
+    int ok = result != NULL && rows != NULL && job.targets != NULL && job.failed != NULL;
+
+    for (unsigned int i = 0; i < columns && ok; i++) {
+        COLUMN *col = create_column(df->columns[i]->column_type, df->columns[i]->title);
+        if (col == NULL || add_column_to_dataframe(result, col) != 0) {
+            if (col != NULL) delete_column(&col);
+            ok = 0;
+            break;
+        }
+        if (!column_reserve(col, sel->count)) ok = 0;
+        job.targets[i] = col;
+    }
+    if (ok) {
+        selection_to_rows(sel, rows);
+        job.rows = rows;
+        thread_pool_run(df->pool ? df->pool : get_default_thread_pool(), columns, gather_selected, &job);
+        for (unsigned int i = 0; i < columns; i++) {
+            if (job.failed[i]) ok = 0;
+        }
+    }
+
+    free(rows);
+    free(job.targets);
+    free(job.failed);
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed for the filtered dataframe.\n");
+        free_dataframe(result);
+        return NULL;
+    }
+    return result;
+}
@@ -0,0 +1,35 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "cdataframe.h"
+
+// Rows selected by filters, one bit per row of [0, rows)
+typedef struct selection {
+    unsigned long long int *bits;
+    unsigned int rows;  // Rows covered, those of the filtered column
+    unsigned int count;  // Selected rows
+} SELECTION;
+
+// Function prototypes for filtering
+
+// Select the non-null rows of a column whose value compares with the pivot as op asks (high is the upper bound of
+// FILTER_BETWEEN and is ignored otherwise); deleted rows are never selected
+// Returns a new selection to free with free_selection, NULL on error
+SELECTION *column_filter(COLUMN *col, FILTER_OP op, void *pivot, void *high);
+
+// Keep in a selection only the rows also selected by another one, or add the rows of the other one
+// Both must cover the same rows; returns 1 on success, 0 otherwise
+int selection_and(SELECTION *sel, const SELECTION *other);
+int selection_or(SELECTION *sel, const SELECTION *other);
+
+// Write the selected rows in increasing order to rows, which has room for sel->count entries
+// This is the compact selection vector of column_append_gather; returns the number of rows written
+unsigned int selection_to_rows(const SELECTION *sel, unsigned int *rows);
+
+void free_selection(SELECTION **sel);
+
+// Copy the selected rows of every column of a dataframe into a new dataframe with the same columns
+// Each column is gathered in one pass, one column per task of the thread pool; returns NULL on error
+DATAFRAME *dataframe_filter(DATAFRAME *df, const SELECTION *sel);
+
+#endif // FILTER_H
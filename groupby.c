@@ -0,0 +1,568 @@
+#include "groupby.h"
+#include "bitmap.h"
+#include "stats.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_GROUP UINT_MAX
+#define NULL_KEY LLONG_MIN  // Key of the null group of an integer key column, below every value
+#define CHAR_SLOTS 257  // Direct table of a CHAR key: one slot per value and one for null
+#define INITIAL_SLOTS 1024
+#define GROUP_PREFETCH 16  // Rows between the prefetch of a slot and its probe
+
+static const char *const aggregate_names[] = {"count", "sum", "min", "max", "mean"};
+
+// Running aggregates of one column over one group
+typedef struct agg_state {
+    unsigned long long int count;  // Non-null values
+    double sum;
+    double min;
+    double max;
+} AGG_STATE;
+
+// Slot of a group table, the key sits next to the group number so that a probe reads a single cache line
+typedef struct group_slot {
+    long long int key;  // Value of an integer key column, hash of the key values otherwise
+    unsigned int group;  // NO_GROUP for an empty slot
+} GROUP_SLOT;
+
+// Groups found by one worker: open-addressing table with linear probing, and the groups in order of creation
+typedef struct group_table {
+    GROUP_SLOT *slots;  // NULL until the worker runs its first task
+    size_t capacity;  // Power of two, or CHAR_SLOTS for a direct table
+    unsigned int count;
+    unsigned int group_capacity;
+    unsigned int *first_rows;  // Earliest row seen of each group, the key values are read back from it
+    AGG_STATE *states;  // num_states running aggregates per group
+    int failed;  // An allocation failed, the table is incomplete
+} GROUP_TABLE;
+
+// How the rows are matched to their group
+enum key_kind {
+    KEY_GENERIC = 0,  // Hash of the key values through the column operations, rows compared on a hash match
+    KEY_INTEGER,  // Single UINT or INT key, its value is the key of the table
+    KEY_CHAR  // Single CHAR key, the table is indexed by the value without hashing
+};
+
+// Shared state of a parallel group-by
+typedef struct group_job {
+    COLUMN **keys;
+    unsigned int num_keys;
+    enum key_kind kind;
+    int has_deleted;  // A key column has deleted rows to skip
+    COLUMN **values;  // Aggregated columns, each listed once and given one running state per group
+    unsigned int num_states;
+    unsigned int rows;
+    GROUP_TABLE *tables;  // One per worker, merged at the end
+    unsigned int *row_groups;  // SEGMENT_ROWS group numbers per worker, those of the segment being aggregated
+} GROUP_JOB;
+
+// Finalizer of splitmix64, spreads the bits of a key over the whole hash
+static unsigned long long int mix_key(unsigned long long int x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static int is_numeric(ENUM_TYPE type) {
+    return type == UINT || type == INT || type == CHAR || type == FLOAT || type == DOUBLE;
+}
+
+static int table_init(const GROUP_JOB *job, GROUP_TABLE *table) {
+    table->capacity = job->kind == KEY_CHAR ? CHAR_SLOTS : INITIAL_SLOTS;
+    table->slots = (GROUP_SLOT *)malloc(table->capacity * sizeof(GROUP_SLOT));
+    if (table->slots == NULL) return -1;
+    for (size_t i = 0; i < table->capacity; i++) table->slots[i].group = NO_GROUP;
+    return 0;
+}
+
+static void table_free(GROUP_TABLE *table) {
+    free(table->slots);
+    free(table->first_rows);
+    free(table->states);
+    memset(table, 0, sizeof(GROUP_TABLE));
+}
+
+// Double the slots of a hashed table and put the groups back in place
+static int grow_slots(GROUP_TABLE *table) {
+    size_t capacity = table->capacity * 2;
+    GROUP_SLOT *slots = (GROUP_SLOT *)malloc(capacity * sizeof(GROUP_SLOT));
+    if (slots == NULL) return -1;
+    for (size_t i = 0; i < capacity; i++) slots[i].group = NO_GROUP;
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->slots[i].group == NO_GROUP) continue;
+        size_t j = mix_key((unsigned long long int)table->slots[i].key) & (capacity - 1);
+        while (slots[j].group != NO_GROUP) j = (j + 1) & (capacity - 1);
+        slots[j] = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return 0;
+}
+
+// Create a group in an empty slot, with row as its first row; NO_GROUP when memory runs out
+static unsigned int add_group(const GROUP_JOB *job, GROUP_TABLE *table, size_t slot, long long int key,
+                              unsigned int row) {
+    if (table->count == table->group_capacity) {
+        unsigned int capacity = table->group_capacity == 0 ? 256 : table->group_capacity * 2;
+        unsigned int *first_rows = (unsigned int *)realloc(table->first_rows, capacity * sizeof(unsigned int));
+        if (first_rows == NULL) return NO_GROUP;
+        table->first_rows = first_rows;
+        AGG_STATE *states = (AGG_STATE *)realloc(table->states,
+                                                 ((size_t)capacity * job->num_states + 1) * sizeof(AGG_STATE));
+        if (states == NULL) return NO_GROUP;
+        table->states = states;
+        table->group_capacity = capacity;
+    }
+    unsigned int group = table->count++;
+    table->first_rows[group] = row;
+    AGG_STATE *states = &table->states[(size_t)group * job->num_states];
+    for (unsigned int s = 0; s < job->num_states; s++) {
+        states[s] = (AGG_STATE){0, 0.0, INFINITY, -INFINITY};
+    }
+    table->slots[slot].key = key;
+    table->slots[slot].group = group;
+
+    // A quarter full at most, so that most probes end on the home slot
+    if (job->kind != KEY_CHAR && (size_t)table->count * 4 > table->capacity && grow_slots(table) != 0) {
+        return NO_GROUP;
+    }
+    return group;
+}
+
+// Whether two rows have the same values in every key column, nulls matching each other
+static int same_keys(const GROUP_JOB *job, unsigned int row1, unsigned int row2) {
+    for (unsigned int k = 0; k < job->num_keys; k++) {
+        COLUMN *col = job->keys[k];
+        void *value1 = get_value_at(col, row1);
+        void *value2 = get_value_at(col, row2);
+        if (value1 == NULL || value2 == NULL) {
+            if (value1 != value2) return 0;
+        } else if (col->ops->compare(value1, value2) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Group of a key, created with row as its first row when it is new; NO_GROUP when memory runs out
+static unsigned int find_group(const GROUP_JOB *job, GROUP_TABLE *table, long long int key, unsigned int row) {
+    size_t slot;
+    if (job->kind == KEY_CHAR) {
+        slot = key == NULL_KEY ? CHAR_SLOTS - 1 : (unsigned char)key;
+        if (table->slots[slot].group != NO_GROUP) return table->slots[slot].group;
+    } else {
+        size_t mask = table->capacity - 1;
+        for (slot = mix_key((unsigned long long int)key) & mask; table->slots[slot].group != NO_GROUP;
+             slot = (slot + 1) & mask) {
+            unsigned int group = table->slots[slot].group;
+            if (table->slots[slot].key == key &&
+                (job->kind == KEY_INTEGER || same_keys(job, table->first_rows[group], row))) {
+                return group;
+            }
+        }
+    }
+    return add_group(job, table, slot, key, row);
+}
+
+// Value of an integer key cell, NULL_KEY for a null cell
+static long long int integer_key(const COLUMN *col, unsigned int row) {
+    if (row >= col->size || (col->validity != NULL && !bitmap_get(col->validity, row))) return NULL_KEY;
+    switch (col->column_type) {
+        case UINT:
+            return ((const unsigned int *)col->values)[row];
+        case CHAR:
+            return ((const char *)col->values)[row];
+        default:
+            return ((const int *)col->values)[row];
+    }
+}
+
+// Combined hash of the key values of a row
+static long long int row_hash(const GROUP_JOB *job, unsigned int row) {
+    unsigned long long int hash = 0;
+    for (unsigned int k = 0; k < job->num_keys; k++) {
+        COLUMN *col = job->keys[k];
+        void *value = get_value_at(col, row);
+        hash = mix_key(hash ^ (value != NULL ? col->ops->hash(value) : 0x9e3779b97f4a7c15ULL));
+    }
+    return (long long int)hash;
+}
+
+static int is_deleted_row(const GROUP_JOB *job, unsigned int row) {
+    for (unsigned int k = 0; k < job->num_keys; k++) {
+        if (is_deleted_at(job->keys[k], row)) return 1;
+    }
+    return 0;
+}
+
+// Fill groups with the group of every row of [start, end), NO_GROUP for a deleted row
+static int assign_groups(const GROUP_JOB *job, GROUP_TABLE *table, unsigned int start, unsigned int end,
+                         unsigned int *groups) {
+    const COLUMN *col = job->keys[0];
+    if (job->kind == KEY_INTEGER && col->column_type == INT && col->validity == NULL && !job->has_deleted &&
+        end <= col->size) {
+        // Dense INT key: the home slot is checked inline and prefetched a few rows ahead,
+        // find_group only runs on a collision or a new key
+        const int *keys = (const int *)col->values;
+        for (unsigned int row = start; row < end; row++) {
+            size_t mask = table->capacity - 1;
+            if (row + GROUP_PREFETCH < end) {
+                __builtin_prefetch(&table->slots[mix_key((unsigned long long int)keys[row + GROUP_PREFETCH]) & mask]);
+            }
+            long long int key = keys[row];
+            const GROUP_SLOT *slot = &table->slots[mix_key((unsigned long long int)key) & mask];
+            unsigned int group = slot->group != NO_GROUP && slot->key == key ? slot->group
+                                                                              : find_group(job, table, key, row);
+            if (group == NO_GROUP) return -1;
+            groups[row - start] = group;
+        }
+        return 0;
+    }
+    for (unsigned int row = start; row < end; row++) {
+        unsigned int group = NO_GROUP;
+        if (!job->has_deleted || !is_deleted_row(job, row)) {
+            long long int key = job->kind == KEY_GENERIC ? row_hash(job, row) : integer_key(job->keys[0], row);
+            group = find_group(job, table, key, row);
+            if (group == NO_GROUP) return -1;
+        }
+        groups[row - start] = group;
+    }
+    return 0;
+}
+
+// Add the non-null values of rows [start, end) of an aggregated column to the state s of their groups
+// One typed loop per column, so that the value type is not switched on for every row
+#define ACCUMULATE_ROWS(ctype)                                                                     \
+    for (unsigned int row = start; row < stop; row++) {                                            \
+        unsigned int group = groups[row - start];                                                  \
+        if (group == NO_GROUP || (validity != NULL && !bitmap_get(validity, row))) continue;       \
+        double value = (double)((const ctype *)col->values)[row];                                  \
+        AGG_STATE *state = &table->states[(size_t)group * job->num_states + s];                    \
+        state->count++;                                                                            \
+        state->sum += value;                                                                       \
+        if (value < state->min) state->min = value;                                                \
+        if (value > state->max) state->max = value;                                                \
+    }
+
+static void accumulate(const GROUP_JOB *job, GROUP_TABLE *table, unsigned int s, unsigned int start,
+                       unsigned int end, const unsigned int *groups) {
+    const COLUMN *col = job->values[s];
+    const unsigned long long int *validity = col->validity;
+    unsigned int stop = end < col->size ? end : col->size;  // Missing cells of a shorter column are null
+    switch (col->column_type) {
+        case UINT:
+            ACCUMULATE_ROWS(unsigned int)
+            break;
+        case INT:
+            ACCUMULATE_ROWS(int)
+            break;
+        case CHAR:
+            ACCUMULATE_ROWS(char)
+            break;
+        case FLOAT:
+            ACCUMULATE_ROWS(float)
+            break;
+        case DOUBLE:
+            ACCUMULATE_ROWS(double)
+            break;
+        default:
+            // Only counted
+            for (unsigned int row = start; row < stop; row++) {
+                unsigned int group = groups[row - start];
+                if (group == NO_GROUP || (validity != NULL && !bitmap_get(validity, row))) continue;
+                table->states[(size_t)group * job->num_states + s].count++;
+            }
+            break;
+    }
+}
+
+// Pre-aggregate one segment into the table of the worker: group numbers of the rows first, then one pass per column
+static void group_segment(void *ctx, unsigned int task_index, unsigned int worker) {
+    GROUP_JOB *job = (GROUP_JOB *)ctx;
+    GROUP_TABLE *table = &job->tables[worker];
+    if (table->failed) return;
+    if (table->slots == NULL && table_init(job, table) != 0) {
+        table->failed = 1;
+        return;
+    }
+    unsigned int start = task_index * SEGMENT_ROWS;
+    unsigned int end = job->rows - start > SEGMENT_ROWS ? start + SEGMENT_ROWS : job->rows;
+    unsigned int *groups = job->row_groups + (size_t)worker * SEGMENT_ROWS;
+    if (assign_groups(job, table, start, end, groups) != 0) {
+        table->failed = 1;
+        return;
+    }
+    for (unsigned int s = 0; s < job->num_states; s++) {
+        accumulate(job, table, s, start, end, groups);
+    }
+}
+
+// Add the groups of a worker table to the merged table
+static int merge_table(const GROUP_JOB *job, GROUP_TABLE *into, const GROUP_TABLE *from) {
+    for (size_t i = 0; i < from->capacity; i++) {
+        unsigned int group = from->slots[i].group;
+        if (group == NO_GROUP) continue;
+        unsigned int merged = find_group(job, into, from->slots[i].key, from->first_rows[group]);
+        if (merged == NO_GROUP) return -1;
+        if (from->first_rows[group] < into->first_rows[merged]) into->first_rows[merged] = from->first_rows[group];
+        for (unsigned int s = 0; s < job->num_states; s++) {
+            const AGG_STATE *state = &from->states[(size_t)group * job->num_states + s];
+            AGG_STATE *total = &into->states[(size_t)merged * job->num_states + s];
+            total->count += state->count;
+            total->sum += state->sum;
+            if (state->min < total->min) total->min = state->min;
+            if (state->max > total->max) total->max = state->max;
+        }
+    }
+    return 0;
+}
+
+// Group of the output row, ordered by first row
+typedef struct group_order {
+    unsigned int first_row;
+    unsigned int group;
+} GROUP_ORDER;
+
+static int compare_group_order(const void *a, const void *b) {
+    const GROUP_ORDER *order1 = (const GROUP_ORDER *)a;
+    const GROUP_ORDER *order2 = (const GROUP_ORDER *)b;
+    return (order1->first_row > order2->first_row) - (order1->first_row < order2->first_row);
+}
+
+// Store a running minimum or maximum in a cell of a numeric type, exact since every such value fits a double
+static void *store_number(ENUM_TYPE type, double value, COL_TYPE *cell) {
+    switch (type) {
+        case UINT:
+            cell->uint_value = (unsigned int)value;
+            break;
+        case INT:
+            cell->int_value = (unsigned int)(int)value;
+            break;
+        case CHAR:
+            cell->char_value = (char)value;
+            break;
+        case FLOAT:
+            cell->float_value = (float)value;
+            break;
+        default:
+            cell->double_value = value;
+            break;
+    }
+    return cell;
+}
+
+// Add one column to the result and reserve its rows, returns NULL on failure
+static COLUMN *add_result_column(DATAFRAME *result, ENUM_TYPE type, char *title, unsigned int rows) {
+    COLUMN *col = create_column(type, title);
+    if (col == NULL) return NULL;
+    if (add_column_to_dataframe(result, col) != 0) {
+        delete_column(&col);
+        return NULL;
+    }
+    return column_reserve(col, rows) ? col : NULL;
+}
+
+// Build the result dataframe from the merged table, one row per group in order of first appearance
+static DATAFRAME *build_result(const GROUP_JOB *job, const GROUP_TABLE *table, DATAFRAME *df,
+                               const AGGREGATION *aggregations, unsigned int num_aggregations,
+                               const unsigned int *state_of) {
+    GROUP_ORDER *order = (GROUP_ORDER *)malloc(((size_t)table->count + 1) * sizeof(GROUP_ORDER));
+    DATAFRAME *result = create_dataframe();
+    if (order == NULL || result == NULL) {
+        free(order);
+        free_dataframe(result);
+        return NULL;
+    }
+    for (unsigned int g = 0; g < table->count; g++) {
+        order[g].first_row = table->first_rows[g];
+        order[g].group = g;
+    }
+    if (table->count > 1) qsort(order, table->count, sizeof(GROUP_ORDER), compare_group_order);
+
+    int ok = 1;
+    for (unsigned int k = 0; k < job->num_keys && ok; k++) {
+        COLUMN *src = job->keys[k];
+        COLUMN *col = add_result_column(result, src->column_type, src->title, table->count);
+        ok = col != NULL;
+        for (unsigned int i = 0; i < table->count && ok; i++) {
+            ok = insert_value(col, get_value_at(src, order[i].first_row));
+        }
+    }
+
+    for (unsigned int a = 0; a < num_aggregations && ok; a++) {
+        AGGREGATE_OP op = aggregations[a].op;
+        COLUMN *src = df->columns[aggregations[a].column];
+        size_t length = strlen(aggregate_names[op]) + strlen(src->title) + 3;
+        char *title = (char *)malloc(length);
+        if (title == NULL) {
+            ok = 0;
+            break;
+        }
+        snprintf(title, length, "%s(%s)", aggregate_names[op], src->title);
+        ENUM_TYPE type = op == AGG_COUNT ? UINT : op == AGG_SUM || op == AGG_MEAN ? DOUBLE : src->column_type;
+        COLUMN *col = add_result_column(result, type, title, table->count);
+        free(title);
+        ok = col != NULL;
+
+        for (unsigned int i = 0; i < table->count && ok; i++) {
+            const AGG_STATE *state = &table->states[(size_t)order[i].group * job->num_states + state_of[a]];
+            COL_TYPE cell;
+            void *value = &cell;
+            switch (op) {
+                case AGG_COUNT:
+                    cell.uint_value = (unsigned int)state->count;
+                    break;
+                case AGG_SUM:
+                    cell.double_value = state->sum;
+                    break;
+                case AGG_MIN:
+                    value = store_number(type, state->min, &cell);
+                    break;
+                case AGG_MAX:
+                    value = store_number(type, state->max, &cell);
+                    break;
+                case AGG_MEAN:
+                    cell.double_value = state->sum / (double)state->count;
+                    break;
+            }
+            if (op != AGG_COUNT && state->count == 0) value = NULL;
+            ok = insert_value(col, value);
+        }
+    }
+
+    free(order);
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed for the group-by result.\n");
+        free_dataframe(result);
+        return NULL;
+    }
+    return result;
+}
+
+// Check the arguments of dataframe_group_by, returns 0 when they are usable
+static int check_group_by(const DATAFRAME *df, const unsigned int *key_columns, unsigned int num_keys,
+                          const AGGREGATION *aggregations, unsigned int num_aggregations) {
+    if (df == NULL || key_columns == NULL || num_keys == 0 || (num_aggregations > 0 && aggregations == NULL)) {
+        fprintf(stderr, "Group-by needs a dataframe and at least one key column.\n");
+        return -1;
+    }
+    for (unsigned int k = 0; k < num_keys; k++) {
+        if (key_columns[k] >= df->column_count || df->columns[key_columns[k]]->column_type == NULLVAL) {
+            fprintf(stderr, "Invalid key column %u for the group-by.\n", key_columns[k]);
+            return -1;
+        }
+    }
+    for (unsigned int a = 0; a < num_aggregations; a++) {
+        const AGGREGATION *aggregation = &aggregations[a];
+        if (aggregation->column >= df->column_count || (unsigned int)aggregation->op > AGG_MEAN) {
+            fprintf(stderr, "Invalid aggregation %u for the group-by.\n", a);
+            return -1;
+        }
+        if (aggregation->op != AGG_COUNT && !is_numeric(df->columns[aggregation->column]->column_type)) {
+            fprintf(stderr, "Cannot compute %s of the non-numeric column %s.\n", aggregate_names[aggregation->op],
+                    df->columns[aggregation->column]->title);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Groups by a hash table per worker filled from whole segments, merged once every segment is done
+DATAFRAME *dataframe_group_by(DATAFRAME *df, const unsigned int *key_columns, unsigned int num_keys,
+                              const AGGREGATION *aggregations, unsigned int num_aggregations) {
+    if (check_group_by(df, key_columns, num_keys, aggregations, num_aggregations) != 0) return NULL;
+
+    GROUP_JOB job;
+    memset(&job, 0, sizeof(GROUP_JOB));
+    job.num_keys = num_keys;
+    for (unsigned int k = 0; k < num_keys; k++) {
+        COLUMN *col = df->columns[key_columns[k]];
+        if (col->size > job.rows) job.rows = col->size;  // Missing cells of a shorter key column are null
+        if (col->deleted_count > 0) job.has_deleted = 1;
+    }
+    STAT_SCOPE(DATAFRAME_GROUP_BY, job.rows);
+
+    ENUM_TYPE first_type = df->columns[key_columns[0]]->column_type;
+    if (num_keys == 1 && first_type == CHAR) {
+        job.kind = KEY_CHAR;
+    } else if (num_keys == 1 && (first_type == INT || first_type == UINT)) {
+        job.kind = KEY_INTEGER;
+    } else {
+        job.kind = KEY_GENERIC;
+    }
+
+    THREAD_POOL *pool = df->pool ? df->pool : get_default_thread_pool();
+    unsigned int workers = thread_pool_size(pool);
+    job.keys = (COLUMN **)malloc(num_keys * sizeof(COLUMN *));
+    job.values = (COLUMN **)malloc((num_aggregations + 1) * sizeof(COLUMN *));
+    unsigned int *state_of = (unsigned int *)malloc((num_aggregations + 1) * sizeof(unsigned int));
+    job.tables = (GROUP_TABLE *)calloc(workers, sizeof(GROUP_TABLE));
+    job.row_groups = (unsigned int *)malloc((size_t)workers * SEGMENT_ROWS * sizeof(unsigned int));
+    GROUP_TABLE merged;
+    memset(&merged, 0, sizeof(GROUP_TABLE));
+    DATAFRAME *result = NULL;
+    if (!job.keys || !job.values || !state_of || !job.tables || !job.row_groups) {
+        fprintf(stderr, "Memory allocation failed for the group-by.\n");
+        goto done;
+    }
+
+    for (unsigned int k = 0; k < num_keys; k++) job.keys[k] = df->columns[key_columns[k]];
+    // Aggregations of the same column share its running state
+    for (unsigned int a = 0; a < num_aggregations; a++) {
+        COLUMN *col = df->columns[aggregations[a].column];
+        unsigned int s = 0;
+        while (s < job.num_states && job.values[s] != col) s++;
+        if (s == job.num_states) job.values[job.num_states++] = col;
+        state_of[a] = s;
+    }
+
+    thread_pool_run(pool, (unsigned int)(((unsigned long long int)job.rows + SEGMENT_ROWS - 1) / SEGMENT_ROWS),
+                    group_segment, &job);
+
+    // A single worker table is the result as it is, several are merged into a new one
+    GROUP_TABLE *final = NULL;
+    unsigned int used = 0;
+    int failed = 0;
+    for (unsigned int w = 0; w < workers; w++) {
+        if (job.tables[w].failed) failed = 1;
+        if (job.tables[w].slots == NULL) continue;
+        final = &job.tables[w];
+        used++;
+    }
+    if (!failed && used > 1) {
+        final = &merged;
+        failed = table_init(&job, &merged) != 0;
+        for (unsigned int w = 0; w < workers && !failed; w++) {
+            if (job.tables[w].slots != NULL) failed = merge_table(&job, &merged, &job.tables[w]) != 0;
+        }
+    }
+    if (failed) {
+        fprintf(stderr, "Memory allocation failed for the group-by.\n");
+        goto done;
+    }
+    if (final == NULL) {
+        // No row: the result has the columns and no group
+        final = &merged;
+    }
+    result = build_result(&job, final, df, aggregations, num_aggregations, state_of);
+
+done:
+    if (job.tables != NULL) {
+        for (unsigned int w = 0; w < workers; w++) table_free(&job.tables[w]);
+    }
+    table_free(&merged);
+    free(job.tables);
+    free(job.row_groups);
+    free(job.keys);
+    free(job.values);
+    free(state_of);
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef GROUPBY_H
+#define GROUPBY_H
+
+#include "cdataframe.h"
+
+// Aggregate functions of dataframe_group_by
+enum aggregate_op {
+    AGG_COUNT = 0, AGG_SUM, AGG_MIN, AGG_MAX, AGG_MEAN
+};
+typedef enum aggregate_op AGGREGATE_OP;
+
+// One output column of dataframe_group_by: an aggregate function of a column of the dataframe
+typedef struct aggregation {
+    unsigned int column;
+    AGGREGATE_OP op;
+} AGGREGATION;
+
+// Function prototypes for grouping
+
+// Group the rows of a dataframe by the values of its key columns and aggregate columns per group
+// The result has one row per group, in order of first appearance: the key columns, then one column per
+// aggregation titled like "sum(price)"
+// Null keys form a group of their own, null values are left out of the aggregates and deleted rows are skipped
+// AGG_COUNT counts the non-null values of a column of any type (UINT column); AGG_SUM and AGG_MEAN (DOUBLE columns),
+// AGG_MIN and AGG_MAX (type of the column) need a UINT, INT, CHAR, FLOAT or DOUBLE column and are null for a group
+// without value; returns NULL on error
+DATAFRAME *dataframe_group_by(DATAFRAME *df, const unsigned int *key_columns, unsigned int num_keys,
+                              const AGGREGATION *aggregations, unsigned int num_aggregations);
+
+#endif // GROUPBY_H
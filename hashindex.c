@@ -0,0 +1,225 @@
+#include "hashindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_INITIAL_CAPACITY 64
+// The table grows when more than 7/10 of the slots are in use
+#define HASH_MAX_LOAD_NUM 7
+#define HASH_MAX_LOAD_DEN 10
+
+// A slot of the table; a slot stays in use after its count drops to 0 so that probe chains stay intact
+typedef struct hash_entry {
+    unsigned long long int hash;
+    unsigned long long int key;  // Value bits for fixed-width keys, owned char * for STRING
+    unsigned int count;  // Occurrences of the key in the column
+    unsigned int used;
+} HASH_ENTRY;
+
+struct hash_index {
+    HASH_ENTRY *entries;
+    size_t capacity;  // Power of two
+    size_t used;  // Slots in use
+    ENUM_TYPE key_type;  // Type of the keys, DOUBLE for STRUCTURE columns (keyed by their value field)
+    const COLUMN_OPS *key_ops;
+    unsigned long long int nan_count;  // NaN cells compare equal to every value, so they are counted apart
+    size_t string_bytes;  // Bytes of the owned string keys
+};
+
+// Pointer to the key of a cell: the cell itself, or the value field of a structure
+static const void *cell_key(const COLUMN *col, const void *cell) {
+    return col->column_type == STRUCTURE ? (const void *)&((const CustomStructure *)cell)->value : cell;
+}
+
+static int is_nan_key(ENUM_TYPE key_type, const void *key) {
+    if (key_type == FLOAT) return *(const float *)key != *(const float *)key;
+    if (key_type == DOUBLE) return *(const double *)key != *(const double *)key;
+    return 0;
+}
+
+static const void *entry_key(const HASH_INDEX *index, const HASH_ENTRY *entry) {
+    return index->key_type == STRING ? (const void *)(const char *)(size_t)entry->key : (const void *)&entry->key;
+}
+
+// Slot holding key, or the free slot where it would go
+static HASH_ENTRY *find_slot(HASH_INDEX *index, const void *key, unsigned long long int hash) {
+    size_t mask = index->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        HASH_ENTRY *entry = &index->entries[i];
+        if (!entry->used) return entry;
+        if (entry->hash == hash && index->key_ops->compare(entry_key(index, entry), key) == 0) return entry;
+    }
+}
+
+// Double the table, dropping the keys no row holds anymore
+static int grow_table(HASH_INDEX *index) {
+    size_t old_capacity = index->capacity;
+    HASH_ENTRY *old_entries = index->entries;
+    size_t live = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        live += old_entries[i].used && old_entries[i].count > 0;
+    }
+    size_t capacity = HASH_INITIAL_CAPACITY;
+    while (capacity * HASH_MAX_LOAD_NUM <= (live + 1) * HASH_MAX_LOAD_DEN * 2) capacity *= 2;
+
+    HASH_ENTRY *entries = (HASH_ENTRY *)calloc(capacity, sizeof(HASH_ENTRY));
+    if (!entries) {
+        fprintf(stderr, "Memory allocation failed for the hash index.\n");
+        return 0;
+    }
+    index->entries = entries;
+    index->capacity = capacity;
+    index->used = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        HASH_ENTRY *old = &old_entries[i];
+        if (!old->used) continue;
+        if (old->count == 0) {
+            if (index->key_type == STRING) {
+                index->string_bytes -= strlen((const char *)(size_t)old->key) + 1;
+                free((char *)(size_t)old->key);
+            }
+            continue;
+        }
+        *find_slot(index, entry_key(index, old), old->hash) = *old;
+        index->used++;
+    }
+    free(old_entries);
+    return 1;
+}
+
+// Add one occurrence of a key
+static int add_key(HASH_INDEX *index, const void *key) {
+    if (is_nan_key(index->key_type, key)) {
+        index->nan_count++;
+        return 1;
+    }
+    if ((index->used + 1) * HASH_MAX_LOAD_DEN > index->capacity * HASH_MAX_LOAD_NUM && !grow_table(index)) {
+        return 0;
+    }
+    unsigned long long int hash = index->key_ops->hash(key);
+    HASH_ENTRY *entry = find_slot(index, key, hash);
+    if (!entry->used) {
+        if (index->key_type == STRING) {
+            char *copy = strdup((const char *)key);
+            if (!copy) {
+                fprintf(stderr, "Memory allocation failed for a hash index key.\n");
+                return 0;
+            }
+            index->string_bytes += strlen(copy) + 1;
+            entry->key = (unsigned long long int)(size_t)copy;
+        } else {
+            entry->key = 0;
+            memcpy(&entry->key, key, type_size(index->key_type));
+        }
+        entry->hash = hash;
+        entry->used = 1;
+        entry->count = 0;
+        index->used++;
+    }
+    entry->count++;
+    return 1;
+}
+
+// Remove one occurrence of a key
+static void remove_key(HASH_INDEX *index, const void *key) {
+    if (is_nan_key(index->key_type, key)) {
+        if (index->nan_count > 0) index->nan_count--;
+        return;
+    }
+    HASH_ENTRY *entry = find_slot(index, key, index->key_ops->hash(key));
+    if (entry->used && entry->count > 0) entry->count--;
+}
+
+static void free_hash_index(HASH_INDEX *index) {
+    if (index == NULL) return;
+    if (index->key_type == STRING) {
+        for (size_t i = 0; i < index->capacity; i++) {
+            if (index->entries[i].used) free((char *)(size_t)index->entries[i].key);
+        }
+    }
+    free(index->entries);
+    free(index);
+}
+
+// Function to build the hash index of a column
+int build_hash_index(COLUMN *col) {
+    if (col == NULL) return 0;
+    if (col->column_type != UINT && col->column_type != INT && col->column_type != CHAR &&
+        col->column_type != FLOAT && col->column_type != DOUBLE && col->column_type != STRING &&
+        col->column_type != STRUCTURE) {
+        fprintf(stderr, "Unsupported type for a hash index.\n");
+        return 0;
+    }
+
+    HASH_INDEX *index = (HASH_INDEX *)calloc(1, sizeof(HASH_INDEX));
+    if (!index) {
+        fprintf(stderr, "Memory allocation failed for the hash index.\n");
+        return 0;
+    }
+    index->capacity = HASH_INITIAL_CAPACITY;
+    index->entries = (HASH_ENTRY *)calloc(index->capacity, sizeof(HASH_ENTRY));
+    index->key_type = col->column_type == STRUCTURE ? DOUBLE : col->column_type;
+    index->key_ops = get_column_ops(index->key_type);
+    if (!index->entries) {
+        free(index);
+        fprintf(stderr, "Memory allocation failed for the hash index.\n");
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < col->size; i++) {
+        void *cell = get_value_at(col, i);
+        if (cell != NULL && !add_key(index, cell_key(col, cell))) {
+            free_hash_index(index);
+            return 0;
+        }
+    }
+    free_hash_index(col->hash_index);
+    col->hash_index = index;
+    return 1;
+}
+
+// Function to free the hash index of a column
+void drop_hash_index(COLUMN *col) {
+    if (col == NULL) return;
+    free_hash_index(col->hash_index);
+    col->hash_index = NULL;
+}
+
+// Function to get the memory footprint of the hash index of a column
+size_t hash_index_memory_usage(const COLUMN *col) {
+    if (col == NULL || col->hash_index == NULL) return 0;
+    const HASH_INDEX *index = col->hash_index;
+    return sizeof(HASH_INDEX) + index->capacity * sizeof(HASH_ENTRY) + index->string_bytes;
+}
+
+// Function to count the cells equal to a value through the hash index
+int hash_index_count(COLUMN *col, const void *value, unsigned long long int *count) {
+    if (col == NULL || col->hash_index == NULL || value == NULL || count == NULL) return 0;
+    HASH_INDEX *index = col->hash_index;
+    const void *key = cell_key(col, value);
+    // A NaN pivot equals every cell, the scan handles it
+    if (is_nan_key(index->key_type, key)) return 0;
+    HASH_ENTRY *entry = find_slot(index, key, index->key_ops->hash(key));
+    *count = (entry->used ? entry->count : 0) + index->nan_count;
+    return 1;
+}
+
+// Function to record the value of a row in the hash index
+int hash_index_add_row(COLUMN *col, unsigned int row) {
+    if (col == NULL || col->hash_index == NULL) return 1;
+    void *cell = get_value_at(col, row);
+    if (cell == NULL) return 1;
+    if (!add_key(col->hash_index, cell_key(col, cell))) {
+        // A partial index would give wrong answers, drop it instead
+        drop_hash_index(col);
+        return 0;
+    }
+    return 1;
+}
+
+// Function to forget the value of a row in the hash index, before it is overwritten or removed
+void hash_index_remove_row(COLUMN *col, unsigned int row) {
+    if (col == NULL || col->hash_index == NULL) return;
+    void *cell = get_value_at(col, row);
+    if (cell != NULL) remove_key(col->hash_index, cell_key(col, cell));
+}
@@ -0,0 +1,27 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include "column.h"
+
+// Optional per-column hash index: an open-addressing table of the distinct values with their occurrence counts
+// Once built it is maintained by insert_value, column_append_n, set_value_at and remove_last_value
+
+// Function prototypes for managing hash indexes
+
+// Build (or rebuild) the hash index of a column, returns 1 on success
+int build_hash_index(COLUMN *col);
+
+// Free the hash index of a column
+void drop_hash_index(COLUMN *col);
+
+// Bytes used by the hash index of a column (table and owned string keys), 0 without index
+size_t hash_index_memory_usage(const COLUMN *col);
+
+// Number of non-null cells equal to value, like count_occurrences; returns 0 when the column has no usable index
+int hash_index_count(COLUMN *col, const void *value, unsigned long long int *count);
+
+// Maintenance hooks, called by the column functions when a row gets or loses its value
+int hash_index_add_row(COLUMN *col, unsigned int row);
+void hash_index_remove_row(COLUMN *col, unsigned int row);
+
+#endif // HASHINDEX_H
@@ -0,0 +1,439 @@
+#include "join.h"
+#include "bitmap.h"
+#include "stats.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_ROW UINT_MAX
+#define JOIN_CACHE_BYTES (256 * 1024)  // Hash table of one partition, small enough for its probes to hit the L2 cache
+#define MAX_PARTITION_BITS 12
+#define RANGE_ROWS (1u << 16)  // Left rows sorted at once when ordering the output, their counters fit in the L2 cache
+#define PROBE_PREFETCH 8  // Probes between the prefetch of a bucket start and that of its first entry
+
+// Key row of one side with the hash of its key
+typedef struct join_entry {
+    unsigned long long int hash;
+    unsigned int row;
+} JOIN_ENTRY;
+
+// Matching left and right rows, NO_ROW on the right for an unmatched row of a left join
+typedef struct join_pair {
+    unsigned int left;
+    unsigned int right;
+} JOIN_PAIR;
+
+// Non-null key rows of one side, grouped by partition (top bits of the hash) and in row order inside a partition
+typedef struct join_side {
+    COLUMN *key;
+    JOIN_ENTRY *entries;
+    unsigned int count;
+    unsigned int *partitions;  // Start of each partition in entries, and the end of the last one
+} JOIN_SIDE;
+
+// Pairs found in one partition
+typedef struct pair_list {
+    JOIN_PAIR *pairs;
+    size_t count;
+    size_t capacity;
+    int failed;  // An allocation failed, the list is incomplete
+} PAIR_LIST;
+
+// Shared state of the partition joins
+typedef struct join_job {
+    JOIN_SIDE build;
+    JOIN_SIDE probe;
+    int build_is_left;
+    int integer_keys;  // The hash of an integer key is a bijection of its value, equal hashes mean equal keys
+    PAIR_LIST *outputs;  // One per partition
+} JOIN_JOB;
+
+// Output columns gathered in parallel, one task per column
+typedef struct gather_job {
+    COLUMN **targets;
+    COLUMN **sources;
+    const unsigned int **rows;  // Left or right row numbers of the output rows, for each target
+    unsigned int count;
+    char *failed;  // One flag per target
+} GATHER_JOB;
+
+// Finalizer of splitmix64, a bijection that spreads the bits of a key over the whole hash
+static unsigned long long int mix_key(unsigned long long int x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash of the non-null key of a row; integer keys are mixed directly, the others go through the column operations
+static unsigned long long int key_hash(COLUMN *col, unsigned int row) {
+    switch (col->column_type) {
+        case UINT:
+            return mix_key(((const unsigned int *)col->values)[row]);
+        case INT:
+            return mix_key((unsigned long long int)(long long int)((const int *)col->values)[row]);
+        case CHAR:
+            return mix_key((unsigned long long int)(long long int)((const char *)col->values)[row]);
+        default:
+            return col->ops->hash(get_value_at(col, row));
+    }
+}
+
+static unsigned int partition_of(unsigned long long int hash, unsigned int bits) {
+    return bits == 0 ? 0 : (unsigned int)(hash >> (64 - bits));
+}
+
+// Non-null key rows of a column, counted without a scan of the values
+static unsigned int valid_key_rows(const COLUMN *col) {
+    return col->size - (unsigned int)count_nulls((COLUMN *)col) - col->deleted_count;
+}
+
+// Hash the non-null key rows of a side and group them by partition, keeping row order inside each partition
+static int collect_side(JOIN_SIDE *side, unsigned int bits) {
+    COLUMN *col = side->key;
+    unsigned int partitions = 1u << bits;
+    side->partitions = (unsigned int *)calloc((size_t)partitions + 1, sizeof(unsigned int));
+    JOIN_ENTRY *rows = (JOIN_ENTRY *)malloc(((size_t)col->size + 1) * sizeof(JOIN_ENTRY));
+    if (side->partitions == NULL || rows == NULL) {
+        free(rows);
+        return -1;
+    }
+
+    // Null and deleted rows have their validity bit cleared
+    unsigned int count = 0;
+    FOR_EACH_SET_BIT(col->validity, 0, col->size, row,
+        rows[count].hash = key_hash(col, row);
+        rows[count].row = row;
+        side->partitions[partition_of(rows[count].hash, bits) + 1]++;
+        count++;
+    )
+    side->count = count;
+    for (unsigned int p = 0; p < partitions; p++) side->partitions[p + 1] += side->partitions[p];
+    if (bits == 0) {
+        side->entries = rows;
+        return 0;
+    }
+
+    side->entries = (JOIN_ENTRY *)malloc(((size_t)count + 1) * sizeof(JOIN_ENTRY));
+    unsigned int *cursors = (unsigned int *)malloc(partitions * sizeof(unsigned int));
+    if (side->entries == NULL || cursors == NULL) {
+        free(cursors);
+        free(rows);
+        return -1;
+    }
+    memcpy(cursors, side->partitions, partitions * sizeof(unsigned int));
+    for (unsigned int i = 0; i < count; i++) {
+        side->entries[cursors[partition_of(rows[i].hash, bits)]++] = rows[i];
+    }
+    free(cursors);
+    free(rows);
+    return 0;
+}
+
+static void free_side(JOIN_SIDE *side) {
+    free(side->entries);
+    free(side->partitions);
+}
+
+static int add_pair(PAIR_LIST *list, unsigned int left, unsigned int right) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+        JOIN_PAIR *pairs = (JOIN_PAIR *)realloc(list->pairs, capacity * sizeof(JOIN_PAIR));
+        if (pairs == NULL) return 0;
+        list->pairs = pairs;
+        list->capacity = capacity;
+    }
+    list->pairs[list->count++] = (JOIN_PAIR){left, right};
+    return 1;
+}
+
+// Join one partition: bucket its build rows by the low bits of the hash, then probe them in row order
+// The buckets are contiguous ranges of one array, so a probe reads a bucket start and then consecutive entries;
+// both are prefetched some probes ahead
+static void join_partition(void *ctx, unsigned int p, unsigned int worker) {
+    (void)worker;
+    JOIN_JOB *job = (JOIN_JOB *)ctx;
+    PAIR_LIST *out = &job->outputs[p];
+    const JOIN_ENTRY *build = job->build.entries + job->build.partitions[p];
+    unsigned int build_count = job->build.partitions[p + 1] - job->build.partitions[p];
+    const JOIN_ENTRY *probe = job->probe.entries + job->probe.partitions[p];
+    unsigned int probe_count = job->probe.partitions[p + 1] - job->probe.partitions[p];
+    if (build_count == 0 || probe_count == 0) return;
+
+    size_t buckets = 1;
+    while (buckets < build_count) buckets <<= 1;
+    size_t mask = buckets - 1;
+    unsigned int *starts = (unsigned int *)calloc(buckets + 1, sizeof(unsigned int));
+    JOIN_ENTRY *table = (JOIN_ENTRY *)malloc(build_count * sizeof(JOIN_ENTRY));
+    if (starts == NULL || table == NULL) {
+        out->failed = 1;
+        free(starts);
+        free(table);
+        return;
+    }
+
+    // Counts, then the end of each bucket, then a backward scatter that leaves the starts and keeps row order
+    for (unsigned int i = 0; i < build_count; i++) starts[build[i].hash & mask]++;
+    for (size_t b = 1; b < buckets; b++) starts[b] += starts[b - 1];
+    starts[buckets] = build_count;
+    for (unsigned int i = build_count; i-- > 0;) table[--starts[build[i].hash & mask]] = build[i];
+
+    for (unsigned int i = 0; i < probe_count && !out->failed; i++) {
+        if (i + 2 * PROBE_PREFETCH < probe_count) __builtin_prefetch(&starts[probe[i + 2 * PROBE_PREFETCH].hash & mask]);
+        if (i + PROBE_PREFETCH < probe_count) __builtin_prefetch(&table[starts[probe[i + PROBE_PREFETCH].hash & mask]]);
+        unsigned long long int hash = probe[i].hash;
+        size_t b = hash & mask;
+        for (unsigned int k = starts[b]; k < starts[b + 1]; k++) {
+            if (table[k].hash != hash) continue;
+            if (!job->integer_keys) {
+                void *build_value = get_value_at(job->build.key, table[k].row);
+                void *probe_value = get_value_at(job->probe.key, probe[i].row);
+                if (job->build.key->ops->compare(build_value, probe_value) != 0) continue;
+            }
+            unsigned int left = job->build_is_left ? table[k].row : probe[i].row;
+            unsigned int right = job->build_is_left ? probe[i].row : table[k].row;
+            if (!add_pair(out, left, right)) {
+                out->failed = 1;
+                break;
+            }
+        }
+    }
+    free(starts);
+    free(table);
+}
+
+static void gather_column(void *ctx, unsigned int task_index, unsigned int worker) {
+    (void)worker;
+    GATHER_JOB *job = (GATHER_JOB *)ctx;
+    job->failed[task_index] = !column_append_gather(job->targets[task_index], job->sources[task_index],
+                                                    job->rows[task_index], job->count);
+}
+
+// Build the result from the left and right row of every output row, gathering each column in one call
+static DATAFRAME *gather_result(DATAFRAME *left, DATAFRAME *right, unsigned int right_key, THREAD_POOL *pool,
+                                const unsigned int *left_rows, const unsigned int *right_rows, unsigned int count) {
+    DATAFRAME *result = create_dataframe();
+    unsigned int columns = left->column_count + right->column_count - 1;
+    GATHER_JOB job = {NULL, NULL, NULL, count, NULL};
+    job.targets = (COLUMN **)malloc(columns * sizeof(COLUMN *));
+    job.sources = (COLUMN **)malloc(columns * sizeof(COLUMN *));
+    job.rows = (const unsigned int **)malloc(columns * sizeof(unsigned int *));
+    job.failed = (char *)calloc(columns, 1);
+    int ok = result != NULL && job.targets != NULL && job.sources != NULL && job.rows != NULL && job.failed != NULL;
+
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < left->column_count + right->column_count && ok; i++) {
+        int from_left = i < left->column_count;
+        if (!from_left && i - left->column_count == right_key) continue;
+        COLUMN *src = from_left ? left->columns[i] : right->columns[i - left->column_count];
+        COLUMN *col = create_column(src->column_type, src->title);
+        if (col == NULL || add_column_to_dataframe(result, col) != 0) {
+            if (col != NULL) delete_column(&col);
+            ok = 0;
+            break;
+        }
+        if (!column_reserve(col, count)) {
+            ok = 0;
+            break;
+        }
+        job.targets[n] = col;
+        job.sources[n] = src;
+        job.rows[n] = from_left ? left_rows : right_rows;
+        n++;
+    }
+    if (ok) {
+        thread_pool_run(pool, n, gather_column, &job);
+        for (unsigned int i = 0; i < n; i++) {
+            if (job.failed[i]) ok = 0;
+        }
+    }
+
+    free(job.targets);
+    free(job.sources);
+    free(job.rows);
+    free(job.failed);
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed for the join result.\n");
+        free_dataframe(result);
+        return NULL;
+    }
+    return result;
+}
+
+// Pairs of the output grouped by range of RANGE_ROWS left rows, then sorted range by range
+typedef struct order_job {
+    const JOIN_PAIR *pairs;
+    const size_t *ranges;  // Start of each range in pairs, and the end of the last one
+    unsigned int *counters;  // RANGE_ROWS + 1 counters per worker
+    unsigned int *left_rows;
+    unsigned int *right_rows;
+} ORDER_JOB;
+
+// Stable counting sort of the pairs of one range on their left row, into the output rows of the range
+static void order_range(void *ctx, unsigned int range, unsigned int worker) {
+    ORDER_JOB *job = (ORDER_JOB *)ctx;
+    size_t start = job->ranges[range];
+    size_t end = job->ranges[range + 1];
+    if (start == end) return;
+    unsigned int base = range * RANGE_ROWS;
+    unsigned int *offsets = job->counters + (size_t)worker * (RANGE_ROWS + 1);
+    memset(offsets, 0, (RANGE_ROWS + 1) * sizeof(unsigned int));
+    for (size_t i = start; i < end; i++) offsets[job->pairs[i].left - base + 1]++;
+    for (unsigned int row = 0; row < RANGE_ROWS; row++) offsets[row + 1] += offsets[row];
+    for (size_t i = start; i < end; i++) {
+        JOIN_PAIR pair = job->pairs[i];
+        size_t position = start + offsets[pair.left - base]++;
+        job->left_rows[position] = pair.left;
+        job->right_rows[position] = pair.right;
+    }
+}
+
+// Put the pairs of every partition in left row order, then gather the result
+// A single counting sort over all the left rows would scatter every pair to a random place, so the pairs are first
+// scattered to ranges of RANGE_ROWS left rows and each range is then sorted in cache. Both passes are stable and the
+// pairs of one left row all come from one partition in right row order, so they keep that order
+// For a left join each unmatched left row gets one pair with NO_ROW on the right
+static DATAFRAME *order_and_gather(DATAFRAME *left, DATAFRAME *right, unsigned int left_key, unsigned int right_key,
+                                   JOIN_TYPE type, THREAD_POOL *pool, const PAIR_LIST *outputs,
+                                   unsigned int partitions) {
+    COLUMN *key = left->columns[left_key];
+    unsigned int rows = key->size;
+    unsigned int ranges = rows / RANGE_ROWS + 1;
+    unsigned long long int words = bitmap_words(rows);
+    DATAFRAME *result = NULL;
+    JOIN_PAIR *pairs = NULL;
+    size_t *cursors = NULL;
+    size_t *starts = (size_t *)calloc((size_t)ranges + 1, sizeof(size_t));
+    unsigned long long int *unmatched = (unsigned long long int *)calloc(words + 1, sizeof(unsigned long long int));
+    ORDER_JOB job = {NULL, starts, NULL, NULL, NULL};
+    job.counters = (unsigned int *)malloc((size_t)thread_pool_size(pool) * (RANGE_ROWS + 1) * sizeof(unsigned int));
+    if (starts == NULL || unmatched == NULL || job.counters == NULL) goto failed;
+
+    for (unsigned int p = 0; p < partitions; p++) {
+        for (size_t i = 0; i < outputs[p].count; i++) {
+            unsigned int row = outputs[p].pairs[i].left;
+            bitmap_set(unmatched, row);
+            starts[row / RANGE_ROWS + 1]++;
+        }
+    }
+    if (type == JOIN_LEFT) {
+        // Flip the matched bits into the left rows without a match that are not deleted, null keys included
+        for (unsigned long long int w = 0; w < words; w++) {
+            unmatched[w] = ~unmatched[w] & bitmap_range_mask(w, 0, rows);
+            if (key->deleted != NULL) unmatched[w] &= ~key->deleted[w];
+            starts[w * BITMAP_WORD_BITS / RANGE_ROWS + 1] += (size_t)popcount64(unmatched[w]);
+        }
+    }
+    for (unsigned int range = 0; range < ranges; range++) starts[range + 1] += starts[range];
+    size_t total = starts[ranges];
+    if (total >= UINT_MAX) {
+        fprintf(stderr, "The join result would have more than %u rows.\n", UINT_MAX - 1);
+        goto done;
+    }
+
+    pairs = (JOIN_PAIR *)malloc((total + 1) * sizeof(JOIN_PAIR));
+    cursors = (size_t *)malloc((size_t)ranges * sizeof(size_t));
+    job.left_rows = (unsigned int *)malloc((total + 1) * sizeof(unsigned int));
+    job.right_rows = (unsigned int *)malloc((total + 1) * sizeof(unsigned int));
+    if (pairs == NULL || cursors == NULL || job.left_rows == NULL || job.right_rows == NULL) goto failed;
+
+    memcpy(cursors, starts, (size_t)ranges * sizeof(size_t));
+    for (unsigned int p = 0; p < partitions; p++) {
+        for (size_t i = 0; i < outputs[p].count; i++) {
+            JOIN_PAIR pair = outputs[p].pairs[i];
+            pairs[cursors[pair.left / RANGE_ROWS]++] = pair;
+        }
+    }
+    if (type == JOIN_LEFT) {
+        FOR_EACH_SET_BIT(unmatched, 0, rows, row,
+            pairs[cursors[row / RANGE_ROWS]++] = (JOIN_PAIR){row, NO_ROW};
+        )
+    }
+    job.pairs = pairs;
+    thread_pool_run(pool, ranges, order_range, &job);
+    free(pairs);
+    pairs = NULL;
+    result = gather_result(left, right, right_key, pool, job.left_rows, job.right_rows, (unsigned int)total);
+    goto done;
+
+failed:
+    fprintf(stderr, "Memory allocation failed for the join.\n");
+done:
+    free(pairs);
+    free(cursors);
+    free(job.left_rows);
+    free(job.right_rows);
+    free(starts);
+    free(unmatched);
+    free(job.counters);
+    return result;
+}
+
+// Hash join: the side with fewer key rows is the build side. Both sides are radix-partitioned on the top bits of the
+// key hash when the build table would not fit in cache (or to give every worker partitions to join), and the
+// partitions are joined in parallel
+DATAFRAME *dataframe_join(DATAFRAME *left, DATAFRAME *right, unsigned int left_key, unsigned int right_key,
+                          JOIN_TYPE type) {
+    if (left == NULL || right == NULL || left_key >= left->column_count || right_key >= right->column_count ||
+        (type != JOIN_INNER && type != JOIN_LEFT)) {
+        fprintf(stderr, "Invalid join arguments.\n");
+        return NULL;
+    }
+    COLUMN *left_column = left->columns[left_key];
+    COLUMN *right_column = right->columns[right_key];
+    if (left_column->column_type != right_column->column_type || left_column->column_type == NULLVAL) {
+        fprintf(stderr, "Join keys '%s' and '%s' must have the same type.\n", left_column->title, right_column->title);
+        return NULL;
+    }
+    STAT_SCOPE(DATAFRAME_JOIN, (unsigned long long int)left_column->size + right_column->size);
+
+    JOIN_JOB job;
+    memset(&job, 0, sizeof(JOIN_JOB));
+    unsigned int left_valid = valid_key_rows(left_column);
+    unsigned int right_valid = valid_key_rows(right_column);
+    job.build_is_left = left_valid < right_valid;
+    job.build.key = job.build_is_left ? left_column : right_column;
+    job.probe.key = job.build_is_left ? right_column : left_column;
+    ENUM_TYPE key_type = left_column->column_type;
+    job.integer_keys = key_type == UINT || key_type == INT || key_type == CHAR;
+
+    THREAD_POOL *pool = left->pool ? left->pool : get_default_thread_pool();
+    unsigned int workers = thread_pool_size(pool);
+    unsigned int build_count = job.build_is_left ? left_valid : right_valid;
+    unsigned int probe_count = job.build_is_left ? right_valid : left_valid;
+    size_t table_bytes = (size_t)build_count * (sizeof(JOIN_ENTRY) + 2 * sizeof(unsigned int));
+    unsigned int bits = 0;
+    while (bits < MAX_PARTITION_BITS && (table_bytes >> bits) > JOIN_CACHE_BYTES) bits++;
+    if (workers > 1 && probe_count >= SEGMENT_ROWS) {
+        while (bits < MAX_PARTITION_BITS && (1u << bits) < workers * 4) bits++;
+    }
+    unsigned int partitions = 1u << bits;
+
+    DATAFRAME *result = NULL;
+    job.outputs = (PAIR_LIST *)calloc(partitions, sizeof(PAIR_LIST));
+    if (job.outputs == NULL || collect_side(&job.build, bits) != 0 || collect_side(&job.probe, bits) != 0) {
+        fprintf(stderr, "Memory allocation failed for the join.\n");
+    } else {
+        thread_pool_run(pool, partitions, join_partition, &job);
+        int failed = 0;
+        for (unsigned int p = 0; p < partitions; p++) {
+            if (job.outputs[p].failed) failed = 1;
+        }
+        if (failed) {
+            fprintf(stderr, "Memory allocation failed for the join.\n");
+        } else {
+            result = order_and_gather(left, right, left_key, right_key, type, pool, job.outputs, partitions);
+        }
+    }
+
+    if (job.outputs != NULL) {
+        for (unsigned int p = 0; p < partitions; p++) free(job.outputs[p].pairs);
+    }
+    free(job.outputs);
+    free_side(&job.build);
+    free_side(&job.probe);
+    return result;
+}
@@ -0,0 +1,22 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include "cdataframe.h"
+
+// Kinds of join of dataframe_join
+enum join_type {
+    JOIN_INNER = 0,  // Only the left rows with a matching right row
+    JOIN_LEFT  // Every left row, with null right cells when nothing matches
+};
+typedef enum join_type JOIN_TYPE;
+
+// Function prototypes for joining
+
+// Equi-join of two dataframes on one key column of the same type on each side
+// The result has the left columns, then the right columns but the right key, and one row per matching pair,
+// in left row order and then right row order; null keys match nothing and deleted rows are skipped
+// Returns a new dataframe, NULL on error
+DATAFRAME *dataframe_join(DATAFRAME *left, DATAFRAME *right, unsigned int left_key, unsigned int right_key,
+                          JOIN_TYPE type);
+
+#endif // JOIN_H
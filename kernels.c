@@ -0,0 +1,718 @@
+#include "kernels.h"
+#include "bitmap.h"
+#include <limits.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// A block kernel builds the less-than and greater-than masks of 64 consecutive values
+typedef void (*BLOCK_KERNEL)(const void *values, const void *pivot,
+                             unsigned long long int *lt, unsigned long long int *gt);
+
+// Scalar kernels, used for the partial last block and on processors without SIMD support
+#define SCALAR_KERNEL(name, ctype)                                                              \
+    static void name(const void *values, const void *pivot, unsigned int n,                     \
+                     unsigned long long int *lt, unsigned long long int *gt) {                   \
+        const ctype *v = (const ctype *)values;                                                 \
+        ctype p = *(const ctype *)pivot;                                                        \
+        unsigned long long int less = 0, greater = 0;                                           \
+        for (unsigned int i = 0; i < n; i++) {                                                  \
+            less |= (unsigned long long int)(v[i] < p) << i;                                    \
+            greater |= (unsigned long long int)(v[i] > p) << i;                                 \
+        }                                                                                       \
+        *lt = less;                                                                             \
+        *gt = greater;                                                                          \
+    }                                                                                           \
+    static void name##_block(const void *values, const void *pivot,                             \
+                             unsigned long long int *lt, unsigned long long int *gt) {           \
+        name(values, pivot, BITMAP_WORD_BITS, lt, gt);                                          \
+    }
+
+SCALAR_KERNEL(scalar_uint, unsigned int)
+SCALAR_KERNEL(scalar_int, int)
+SCALAR_KERNEL(scalar_char, char)
+SCALAR_KERNEL(scalar_float, float)
+SCALAR_KERNEL(scalar_double, double)
+
+#ifdef KERNELS_X86
+
+// SSE2 kernels: 16 chars, 4 ints or floats, 2 doubles per comparison
+
+__attribute__((target("sse2")))
+static void sse2_int(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const int *v = (const int *)values;
+    __m128i p = _mm_set1_epi32(*(const int *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 16; k++) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(v + 4 * k));
+        less |= (unsigned long long int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(x, p))) << (4 * k);
+        greater |= (unsigned long long int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, p))) << (4 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+// Unsigned values are biased by the sign bit so that the signed comparison orders them
+__attribute__((target("sse2")))
+static void sse2_uint(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const unsigned int *v = (const unsigned int *)values;
+    __m128i bias = _mm_set1_epi32(INT_MIN);
+    __m128i p = _mm_xor_si128(_mm_set1_epi32((int)*(const unsigned int *)pivot), bias);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 16; k++) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(v + 4 * k)), bias);
+        less |= (unsigned long long int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(x, p))) << (4 * k);
+        greater |= (unsigned long long int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, p))) << (4 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("sse2")))
+static void sse2_char(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const char *v = (const char *)values;
+#if CHAR_MIN < 0
+    __m128i bias = _mm_setzero_si128();
+#else
+    __m128i bias = _mm_set1_epi8((char)0x80);
+#endif
+    __m128i p = _mm_xor_si128(_mm_set1_epi8(*(const char *)pivot), bias);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(v + 16 * k)), bias);
+        less |= (unsigned long long int)(unsigned int)_mm_movemask_epi8(_mm_cmplt_epi8(x, p)) << (16 * k);
+        greater |= (unsigned long long int)(unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(x, p)) << (16 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("sse2")))
+static void sse2_float(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const float *v = (const float *)values;
+    __m128 p = _mm_set1_ps(*(const float *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 16; k++) {
+        __m128 x = _mm_loadu_ps(v + 4 * k);
+        less |= (unsigned long long int)_mm_movemask_ps(_mm_cmplt_ps(x, p)) << (4 * k);
+        greater |= (unsigned long long int)_mm_movemask_ps(_mm_cmpgt_ps(x, p)) << (4 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("sse2")))
+static void sse2_double(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const double *v = (const double *)values;
+    __m128d p = _mm_set1_pd(*(const double *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 32; k++) {
+        __m128d x = _mm_loadu_pd(v + 2 * k);
+        less |= (unsigned long long int)_mm_movemask_pd(_mm_cmplt_pd(x, p)) << (2 * k);
+        greater |= (unsigned long long int)_mm_movemask_pd(_mm_cmpgt_pd(x, p)) << (2 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+// AVX2 kernels: 32 chars, 8 ints or floats, 4 doubles per comparison
+
+__attribute__((target("avx2")))
+static void avx2_int(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const int *v = (const int *)values;
+    __m256i p = _mm256_set1_epi32(*(const int *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 8; k++) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(v + 8 * k));
+        less |= (unsigned long long int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, x))) << (8 * k);
+        greater |= (unsigned long long int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, p))) << (8 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("avx2")))
+static void avx2_uint(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const unsigned int *v = (const unsigned int *)values;
+    __m256i bias = _mm256_set1_epi32(INT_MIN);
+    __m256i p = _mm256_xor_si256(_mm256_set1_epi32((int)*(const unsigned int *)pivot), bias);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 8; k++) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(v + 8 * k)), bias);
+        less |= (unsigned long long int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, x))) << (8 * k);
+        greater |= (unsigned long long int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, p))) << (8 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("avx2")))
+static void avx2_char(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const char *v = (const char *)values;
+#if CHAR_MIN < 0
+    __m256i bias = _mm256_setzero_si256();
+#else
+    __m256i bias = _mm256_set1_epi8((char)0x80);
+#endif
+    __m256i p = _mm256_xor_si256(_mm256_set1_epi8(*(const char *)pivot), bias);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 2; k++) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(v + 32 * k)), bias);
+        less |= (unsigned long long int)(unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(p, x)) << (32 * k);
+        greater |= (unsigned long long int)(unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(x, p)) << (32 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("avx2")))
+static void avx2_float(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const float *v = (const float *)values;
+    __m256 p = _mm256_set1_ps(*(const float *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 8; k++) {
+        __m256 x = _mm256_loadu_ps(v + 8 * k);
+        less |= (unsigned long long int)_mm256_movemask_ps(_mm256_cmp_ps(x, p, _CMP_LT_OQ)) << (8 * k);
+        greater |= (unsigned long long int)_mm256_movemask_ps(_mm256_cmp_ps(x, p, _CMP_GT_OQ)) << (8 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+__attribute__((target("avx2")))
+static void avx2_double(const void *values, const void *pivot, unsigned long long int *lt, unsigned long long int *gt) {
+    const double *v = (const double *)values;
+    __m256d p = _mm256_set1_pd(*(const double *)pivot);
+    unsigned long long int less = 0, greater = 0;
+    for (int k = 0; k < 16; k++) {
+        __m256d x = _mm256_loadu_pd(v + 4 * k);
+        less |= (unsigned long long int)_mm256_movemask_pd(_mm256_cmp_pd(x, p, _CMP_LT_OQ)) << (4 * k);
+        greater |= (unsigned long long int)_mm256_movemask_pd(_mm256_cmp_pd(x, p, _CMP_GT_OQ)) << (4 * k);
+    }
+    *lt = less;
+    *gt = greater;
+}
+
+#endif // KERNELS_X86
+
+// Highest level supported by the processor, -1 until detected
+// Both levels are atomic: the first kernel calls usually come from several pool workers at once, which may all
+// detect the level and store the same value
+static _Atomic int detected_level = -1;
+// Level in use, -1 until the first kernel call
+static _Atomic int active_level = -1;
+
+static KERNEL_LEVEL detect_kernel_level(void) {
+    int level = detected_level;
+    if (level < 0) {
+        level = KERNEL_SCALAR;
+#ifdef KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            level = KERNEL_AVX2;
+        } else if (__builtin_cpu_supports("sse2")) {
+            level = KERNEL_SSE2;
+        }
+#endif
+        detected_level = level;
+    }
+    return (KERNEL_LEVEL)level;
+}
+
+// Function to get the instruction set used by the kernels
+KERNEL_LEVEL get_kernel_level(void) {
+    int level = active_level;
+    if (level < 0) {
+        // Only the first call stores the detected level, a concurrent set_kernel_level is not overwritten
+        int expected = -1;
+        level = detect_kernel_level();
+        if (!atomic_compare_exchange_strong(&active_level, &expected, level)) level = expected;
+    }
+    return (KERNEL_LEVEL)level;
+}
+
+// Function to force a kernel level, capped at what the processor supports
+KERNEL_LEVEL set_kernel_level(KERNEL_LEVEL level) {
+    KERNEL_LEVEL supported = detect_kernel_level();
+    KERNEL_LEVEL active = level < supported ? level : supported;
+    active_level = active;
+    return active;
+}
+
+// Function to tell whether a column type has a vectorized comparison kernel
+int has_compare_kernel(ENUM_TYPE type) {
+    return type == UINT || type == INT || type == CHAR || type == FLOAT || type == DOUBLE;
+}
+
+// Select the full-block kernel of a type for the active level
+static BLOCK_KERNEL select_block_kernel(ENUM_TYPE type) {
+    KERNEL_LEVEL level = get_kernel_level();
+#ifdef KERNELS_X86
+    if (level == KERNEL_AVX2) {
+        switch (type) {
+            case UINT: return avx2_uint;
+            case INT: return avx2_int;
+            case CHAR: return avx2_char;
+            case FLOAT: return avx2_float;
+            case DOUBLE: return avx2_double;
+            default: break;
+        }
+    } else if (level == KERNEL_SSE2) {
+        switch (type) {
+            case UINT: return sse2_uint;
+            case INT: return sse2_int;
+            case CHAR: return sse2_char;
+            case FLOAT: return sse2_float;
+            case DOUBLE: return sse2_double;
+            default: break;
+        }
+    }
+#else
+    (void)level;
+#endif
+    switch (type) {
+        case UINT: return scalar_uint_block;
+        case INT: return scalar_int_block;
+        case CHAR: return scalar_char_block;
+        case FLOAT: return scalar_float_block;
+        case DOUBLE: return scalar_double_block;
+        default: return NULL;
+    }
+}
+
+// Scalar kernel of a type, used for a partial block
+static void tail_kernel(ENUM_TYPE type, const void *values, const void *pivot, unsigned int n,
+                        unsigned long long int *lt, unsigned long long int *gt) {
+    switch (type) {
+        case UINT: scalar_uint(values, pivot, n, lt, gt); break;
+        case INT: scalar_int(values, pivot, n, lt, gt); break;
+        case CHAR: scalar_char(values, pivot, n, lt, gt); break;
+        case FLOAT: scalar_float(values, pivot, n, lt, gt); break;
+        case DOUBLE: scalar_double(values, pivot, n, lt, gt); break;
+        default: *lt = *gt = 0; break;
+    }
+}
+
+// Function to count the values of a range less than, equal to and greater than a pivot
+// Each 64-row block yields two comparison masks that are ANDed with the validity word and popcounted
+void count_compare_kernel(ENUM_TYPE type, const void *values, const unsigned long long int *validity,
+                          unsigned long long int start, unsigned long long int end,
+                          const void *pivot, COMPARE_COUNTS *counts) {
+    BLOCK_KERNEL block = select_block_kernel(type);
+    if (block == NULL || start >= end) return;
+    size_t elem_size = type_size(type);
+    const char *base = (const char *)values;
+
+    unsigned long long int less = 0, greater = 0, valid_total = 0;
+    for (unsigned long long int w = start / BITMAP_WORD_BITS; w < bitmap_words(end); w++) {
+        unsigned long long int valid = bitmap_range_mask(w, start, end);
+        if (validity != NULL) valid &= validity[w];
+        if (valid == 0) continue;
+
+        unsigned long long int lt, gt;
+        const char *block_values = base + w * BITMAP_WORD_BITS * elem_size;
+        if ((w + 1) * BITMAP_WORD_BITS <= end) {
+            block(block_values, pivot, &lt, &gt);
+        } else {
+            tail_kernel(type, block_values, pivot, (unsigned int)(end - w * BITMAP_WORD_BITS), &lt, &gt);
+        }
+        less += popcount64(lt & valid);
+        greater += popcount64(gt & valid);
+        valid_total += popcount64(valid);
+    }
+    counts->less += less;
+    counts->greater += greater;
+    counts->equal += valid_total - less - greater;
+}
+
+// Comparison masks of one block of n values, with the full-block kernel when the block is whole
+static void compare_block(ENUM_TYPE type, BLOCK_KERNEL block, const void *values, const void *pivot, unsigned int n,
+                          unsigned long long int *lt, unsigned long long int *gt) {
+    if (n == BITMAP_WORD_BITS) {
+        block(values, pivot, lt, gt);
+    } else {
+        tail_kernel(type, values, pivot, n, lt, gt);
+    }
+}
+
+// Whether a bound is NaN, which no value is ordered with
+static int is_nan_bound(ENUM_TYPE type, const void *bound) {
+    if (type == FLOAT) return *(const float *)bound != *(const float *)bound;
+    if (type == DOUBLE) return *(const double *)bound != *(const double *)bound;
+    return 0;
+}
+
+// Bits of the values of a block that are not NaN: those below +inf or above -inf
+static unsigned long long int ordered_block(ENUM_TYPE type, BLOCK_KERNEL block, const void *values, unsigned int n) {
+    static const float float_bounds[2] = {INFINITY, -INFINITY};
+    static const double double_bounds[2] = {INFINITY, -INFINITY};
+    if (type != FLOAT && type != DOUBLE) return ~0ULL;
+    const void *upper = type == FLOAT ? (const void *)&float_bounds[0] : (const void *)&double_bounds[0];
+    const void *lower = type == FLOAT ? (const void *)&float_bounds[1] : (const void *)&double_bounds[1];
+    unsigned long long int lt, gt, below_inf, above_minus_inf;
+    compare_block(type, block, values, upper, n, &below_inf, &gt);
+    compare_block(type, block, values, lower, n, &lt, &above_minus_inf);
+    return below_inf | above_minus_inf;
+}
+
+// Function to select the values of a range passing a filter
+// Each 64-row block yields the masks of the values less and greater than the pivot; the filter is a bitwise
+// combination of them (of both bounds for FILTER_BETWEEN), ANDed with the validity word and ORed into selected
+// Unlike COMPARE_COUNTS a NaN value or bound is not equal to anything: the filters that accept equality also need
+// the mask of the values that are not NaN, which FILTER_NE takes the complement of
+unsigned int filter_kernel(ENUM_TYPE type, const void *values, const unsigned long long int *validity,
+                           unsigned long long int start, unsigned long long int end, FILTER_OP op,
+                           const void *pivot, const void *high, unsigned long long int *selected) {
+    BLOCK_KERNEL block = select_block_kernel(type);
+    if (block == NULL || start >= end) return 0;
+    size_t elem_size = type_size(type);
+    const char *base = (const char *)values;
+    // Every value differs from a NaN bound and passes no other filter
+    int nan_bound = is_nan_bound(type, pivot) || (op == FILTER_BETWEEN && is_nan_bound(type, high));
+    if (nan_bound && op != FILTER_NE) return 0;
+
+    unsigned int total = 0;
+    for (unsigned long long int w = start / BITMAP_WORD_BITS; w < bitmap_words(end); w++) {
+        unsigned long long int valid = bitmap_range_mask(w, start, end);
+        if (validity != NULL) valid &= validity[w];
+        if (valid == 0) continue;
+
+        const char *block_values = base + w * BITMAP_WORD_BITS * elem_size;
+        unsigned int n = (w + 1) * BITMAP_WORD_BITS <= end ? BITMAP_WORD_BITS
+                                                            : (unsigned int)(end - w * BITMAP_WORD_BITS);
+        unsigned long long int lt, gt, match;
+        if (nan_bound) {
+            match = ~0ULL;
+        } else if (op == FILTER_LT || op == FILTER_GT) {
+            compare_block(type, block, block_values, pivot, n, &lt, &gt);
+            match = op == FILTER_LT ? lt : gt;
+        } else {
+            unsigned long long int ordered = ordered_block(type, block, block_values, n);
+            compare_block(type, block, block_values, pivot, n, &lt, &gt);
+            switch (op) {
+                case FILTER_LE: match = ~gt & ordered; break;
+                case FILTER_EQ: match = ~(lt | gt) & ordered; break;
+                case FILTER_NE: match = (lt | gt) | ~ordered; break;
+                case FILTER_GE: match = ~lt & ordered; break;
+                default:
+                    match = ~lt & ordered;
+                    compare_block(type, block, block_values, high, n, &lt, &gt);
+                    match &= ~gt;
+                    break;
+            }
+        }
+        match &= valid;
+        selected[w] |= match;
+        total += (unsigned int)popcount64(match);
+    }
+    return total;
+}
+
+// Reduction of the valid values of one 64-row block
+typedef struct block_summary {
+    double sum;
+    double min;
+    double max;
+    double m2;  // Sum of the squared deviations from the mean of the block
+} BLOCK_SUMMARY;
+
+// A block reduction kernel sums the values of a full block whose bit is set in valid, which is not 0
+typedef void (*REDUCE_BLOCK_KERNEL)(const void *values, unsigned long long int valid, BLOCK_SUMMARY *summary);
+
+// Scalar reduction kernels, for the partial last block and below AVX2
+// Four accumulators break the dependency chain of the additions
+#define SCALAR_REDUCE_KERNEL(name, ctype)                                                       \
+    static void name(const void *values, unsigned int n, unsigned long long int valid,          \
+                     BLOCK_SUMMARY *summary) {                                                  \
+        const ctype *v = (const ctype *)values;                                                 \
+        double sum[4] = {0, 0, 0, 0}, min = INFINITY, max = -INFINITY;                          \
+        for (unsigned int i = 0; i < n; i++) {                                                  \
+            if (!((valid >> i) & 1)) continue;                                                  \
+            double x = (double)v[i];                                                            \
+            sum[i & 3] += x;                                                                    \
+            if (x < min) min = x;                                                               \
+            if (x > max) max = x;                                                               \
+        }                                                                                       \
+        double total = (sum[0] + sum[1]) + (sum[2] + sum[3]);                                   \
+        double mean = total / popcount64(valid);                                                \
+        double m2[4] = {0, 0, 0, 0};                                                            \
+        for (unsigned int i = 0; i < n; i++) {                                                  \
+            if (!((valid >> i) & 1)) continue;                                                  \
+            double d = (double)v[i] - mean;                                                     \
+            m2[i & 3] += d * d;                                                                 \
+        }                                                                                       \
+        summary->sum = total;                                                                   \
+        summary->min = min;                                                                     \
+        summary->max = max;                                                                     \
+        summary->m2 = (m2[0] + m2[1]) + (m2[2] + m2[3]);                                        \
+    }                                                                                           \
+    static void name##_block(const void *values, unsigned long long int valid,                  \
+                             BLOCK_SUMMARY *summary) {                                          \
+        name(values, BITMAP_WORD_BITS, valid, summary);                                         \
+    }
+
+SCALAR_REDUCE_KERNEL(scalar_reduce_uint, unsigned int)
+SCALAR_REDUCE_KERNEL(scalar_reduce_int, int)
+SCALAR_REDUCE_KERNEL(scalar_reduce_char, char)
+SCALAR_REDUCE_KERNEL(scalar_reduce_float, float)
+SCALAR_REDUCE_KERNEL(scalar_reduce_double, double)
+
+#ifdef KERNELS_X86
+
+// All-ones lanes for the set bits of a 4-bit validity nibble
+#define LANE_MASK(b) {-(long long int)((b) & 1), -(long long int)(((b) >> 1) & 1), \
+                      -(long long int)(((b) >> 2) & 1), -(long long int)(((b) >> 3) & 1)}
+static const long long int lane_masks[16][4] __attribute__((aligned(32))) = {
+    LANE_MASK(0), LANE_MASK(1), LANE_MASK(2), LANE_MASK(3), LANE_MASK(4), LANE_MASK(5), LANE_MASK(6), LANE_MASK(7),
+    LANE_MASK(8), LANE_MASK(9), LANE_MASK(10), LANE_MASK(11), LANE_MASK(12), LANE_MASK(13), LANE_MASK(14),
+    LANE_MASK(15)};
+
+static inline int load_four_chars(const char *p) {
+    int bytes;
+    memcpy(&bytes, p, sizeof(int));
+    return bytes;
+}
+
+// Four values widened to doubles, exactly; unsigned values are biased into the signed range and back
+#define AVX2_LOAD_UINT(p)                                                                                   \
+    _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(_mm_loadu_si128((const __m128i *)(p)),                 \
+                                                   _mm_set1_epi32(INT_MIN))), _mm256_set1_pd(2147483648.0))
+#if CHAR_MIN < 0
+#define AVX2_LOAD_CHAR(p) _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(load_four_chars(p))))
+#else
+#define AVX2_LOAD_CHAR(p) _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(load_four_chars(p))))
+#endif
+#define AVX2_LOAD_INT(p) _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(p)))
+#define AVX2_LOAD_FLOAT(p) _mm256_cvtps_pd(_mm_loadu_ps((const float *)(p)))
+#define AVX2_LOAD_DOUBLE(p) _mm256_loadu_pd((const double *)(p))
+
+// The lanes of the bounds are never NaN, so plain comparisons do
+#define MIN_OF(a, b) ((a) < (b) ? (a) : (b))
+#define MAX_OF(a, b) ((a) > (b) ? (a) : (b))
+
+// AVX2 reduction kernels: invalid lanes add zero and are blended out of the bounds
+// Two accumulators of each kind, a second pass over the block (still in L1) adds the squared deviations
+#define AVX2_REDUCE_KERNEL(name, ctype, LOAD)                                                                 \
+    __attribute__((target("avx2")))                                                                          \
+    static void name(const void *values, unsigned long long int valid, BLOCK_SUMMARY *summary) {             \
+        const ctype *v = (const ctype *)values;                                                             \
+        __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();                                     \
+        __m256d min0 = _mm256_set1_pd(INFINITY), min1 = min0;                                                \
+        __m256d max0 = _mm256_set1_pd(-INFINITY), max1 = max0;                                               \
+        for (int k = 0; k < 16; k += 2) {                                                                    \
+            __m256d m0 = _mm256_load_pd((const double *)lane_masks[(valid >> (4 * k)) & 15]);                \
+            __m256d m1 = _mm256_load_pd((const double *)lane_masks[(valid >> (4 * k + 4)) & 15]);            \
+            __m256d x0 = LOAD(v + 4 * k), x1 = LOAD(v + 4 * k + 4);                                          \
+            sum0 = _mm256_add_pd(sum0, _mm256_and_pd(x0, m0));                                               \
+            sum1 = _mm256_add_pd(sum1, _mm256_and_pd(x1, m1));                                               \
+            min0 = _mm256_min_pd(_mm256_blendv_pd(min0, x0, m0), min0);                                      \
+            min1 = _mm256_min_pd(_mm256_blendv_pd(min1, x1, m1), min1);                                      \
+            max0 = _mm256_max_pd(_mm256_blendv_pd(max0, x0, m0), max0);                                      \
+            max1 = _mm256_max_pd(_mm256_blendv_pd(max1, x1, m1), max1);                                      \
+        }                                                                                                    \
+        double lanes[4] __attribute__((aligned(32)));                                                        \
+        _mm256_store_pd(lanes, _mm256_add_pd(sum0, sum1));                                                   \
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);                                        \
+        _mm256_store_pd(lanes, _mm256_min_pd(min0, min1));                                                   \
+        summary->min = MIN_OF(MIN_OF(lanes[0], lanes[1]), MIN_OF(lanes[2], lanes[3]));                       \
+        _mm256_store_pd(lanes, _mm256_max_pd(max0, max1));                                                   \
+        summary->max = MAX_OF(MAX_OF(lanes[0], lanes[1]), MAX_OF(lanes[2], lanes[3]));                       \
+        __m256d mean = _mm256_set1_pd(total / popcount64(valid));                                            \
+        __m256d sq0 = _mm256_setzero_pd(), sq1 = _mm256_setzero_pd();                                        \
+        for (int k = 0; k < 16; k += 2) {                                                                    \
+            __m256d m0 = _mm256_load_pd((const double *)lane_masks[(valid >> (4 * k)) & 15]);                \
+            __m256d m1 = _mm256_load_pd((const double *)lane_masks[(valid >> (4 * k + 4)) & 15]);            \
+            __m256d d0 = _mm256_and_pd(_mm256_sub_pd(LOAD(v + 4 * k), mean), m0);                            \
+            __m256d d1 = _mm256_and_pd(_mm256_sub_pd(LOAD(v + 4 * k + 4), mean), m1);                        \
+            sq0 = _mm256_add_pd(sq0, _mm256_mul_pd(d0, d0));                                                 \
+            sq1 = _mm256_add_pd(sq1, _mm256_mul_pd(d1, d1));                                                 \
+        }                                                                                                    \
+        _mm256_store_pd(lanes, _mm256_add_pd(sq0, sq1));                                                     \
+        summary->sum = total;                                                                                \
+        summary->m2 = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);                                         \
+    }
+
+AVX2_REDUCE_KERNEL(avx2_reduce_uint, unsigned int, AVX2_LOAD_UINT)
+AVX2_REDUCE_KERNEL(avx2_reduce_int, int, AVX2_LOAD_INT)
+AVX2_REDUCE_KERNEL(avx2_reduce_char, char, AVX2_LOAD_CHAR)
+AVX2_REDUCE_KERNEL(avx2_reduce_float, float, AVX2_LOAD_FLOAT)
+AVX2_REDUCE_KERNEL(avx2_reduce_double, double, AVX2_LOAD_DOUBLE)
+
+#endif // KERNELS_X86
+
+// Function to tell whether a column type has reduction kernels
+int has_reduce_kernel(ENUM_TYPE type) {
+    return type == UINT || type == INT || type == CHAR || type == FLOAT || type == DOUBLE;
+}
+
+// Select the full-block reduction kernel of a type for the active level
+static REDUCE_BLOCK_KERNEL select_reduce_kernel(ENUM_TYPE type) {
+#ifdef KERNELS_X86
+    if (get_kernel_level() == KERNEL_AVX2) {
+        switch (type) {
+            case UINT: return avx2_reduce_uint;
+            case INT: return avx2_reduce_int;
+            case CHAR: return avx2_reduce_char;
+            case FLOAT: return avx2_reduce_float;
+            case DOUBLE: return avx2_reduce_double;
+            default: break;
+        }
+    }
+#endif
+    switch (type) {
+        case UINT: return scalar_reduce_uint_block;
+        case INT: return scalar_reduce_int_block;
+        case CHAR: return scalar_reduce_char_block;
+        case FLOAT: return scalar_reduce_float_block;
+        case DOUBLE: return scalar_reduce_double_block;
+        default: return NULL;
+    }
+}
+
+// Scalar reduction kernel of a type, used for a partial block
+static void reduce_tail(ENUM_TYPE type, const void *values, unsigned int n, unsigned long long int valid,
+                        BLOCK_SUMMARY *summary) {
+    switch (type) {
+        case UINT: scalar_reduce_uint(values, n, valid, summary); break;
+        case INT: scalar_reduce_int(values, n, valid, summary); break;
+        case CHAR: scalar_reduce_char(values, n, valid, summary); break;
+        case FLOAT: scalar_reduce_float(values, n, valid, summary); break;
+        default: scalar_reduce_double(values, n, valid, summary); break;
+    }
+}
+
+void reduction_init(REDUCTION *reduction, ENUM_TYPE type, SUM_MODE mode) {
+    memset(reduction, 0, sizeof(REDUCTION));
+    reduction->type = type;
+    reduction->mode = mode;
+    reduction->min = INFINITY;
+    reduction->max = -INFINITY;
+}
+
+static int is_integer_type(ENUM_TYPE type) {
+    return type == UINT || type == INT || type == CHAR;
+}
+
+// Add a sum of floating values to the running total of the mode
+static void add_to_sum(REDUCTION *reduction, double value) {
+    switch (reduction->mode) {
+        case SUM_KAHAN: {
+            double total = reduction->sum + value;
+            if (fabs(reduction->sum) >= fabs(value)) {
+                reduction->compensation += (reduction->sum - total) + value;
+            } else {
+                reduction->compensation += (value - total) + reduction->sum;
+            }
+            reduction->sum = total;
+            break;
+        }
+        case SUM_PAIRWISE: {
+            // Binary counter: each carry adds two partials of the same size
+            int level = 0;
+            while ((reduction->partial_count >> level) & 1) {
+                value = reduction->partials[level] + value;
+                level++;
+            }
+            reduction->partial_count++;
+            reduction->partials[level] = value;
+            break;
+        }
+        default:
+            reduction->sum += value;
+            break;
+    }
+}
+
+// Total of the floating values added so far
+static double current_sum(const REDUCTION *reduction) {
+    if (reduction->mode == SUM_KAHAN) return reduction->sum + reduction->compensation;
+    if (reduction->mode != SUM_PAIRWISE) return reduction->sum;
+    double total = 0;
+    for (int level = 0; level < REDUCTION_LEVELS; level++) {
+        if ((reduction->partial_count >> level) & 1) total += reduction->partials[level];
+    }
+    return total;
+}
+
+// Add count values of sum sum, bounds min and max, mean sum / count and squared deviations m2
+static void add_summary(REDUCTION *reduction, unsigned long long int count, const BLOCK_SUMMARY *summary) {
+    if (summary->min < reduction->min) reduction->min = summary->min;
+    if (summary->max > reduction->max) reduction->max = summary->max;
+    double mean = summary->sum / (double)count;
+    double delta = mean - reduction->mean;
+    double total = (double)(reduction->count + count);
+    reduction->mean += delta * ((double)count / total);
+    reduction->m2 += summary->m2 + delta * delta * ((double)reduction->count * (double)count / total);
+    reduction->count += count;
+}
+
+// Function to reduce a range block by block
+// Integer block sums are exact in a double (64 values of 32 bits), so they go to the exact integer sum
+void reduce_kernel(const void *values, const unsigned long long int *validity,
+                   unsigned long long int start, unsigned long long int end, REDUCTION *reduction) {
+    ENUM_TYPE type = reduction->type;
+    REDUCE_BLOCK_KERNEL block = select_reduce_kernel(type);
+    if (block == NULL || start >= end) return;
+    size_t elem_size = type_size(type);
+    const char *base = (const char *)values;
+    int integer = is_integer_type(type);
+
+    for (unsigned long long int w = start / BITMAP_WORD_BITS; w < bitmap_words(end); w++) {
+        unsigned long long int valid = bitmap_range_mask(w, start, end);
+        if (validity != NULL) valid &= validity[w];
+        if (valid == 0) continue;
+
+        BLOCK_SUMMARY summary;
+        const char *block_values = base + w * BITMAP_WORD_BITS * elem_size;
+        if ((w + 1) * BITMAP_WORD_BITS <= end) {
+            block(block_values, valid, &summary);
+        } else {
+            reduce_tail(type, block_values, (unsigned int)(end - w * BITMAP_WORD_BITS), valid, &summary);
+        }
+        add_summary(reduction, (unsigned long long int)popcount64(valid), &summary);
+        if (integer) {
+            reduction->int_sum += (unsigned long long int)(long long int)summary.sum;
+        } else {
+            add_to_sum(reduction, summary.sum);
+        }
+    }
+}
+
+// Function to merge two reductions, the floating sum of from entering the mode of into as one block sum
+void reduction_merge(REDUCTION *into, const REDUCTION *from) {
+    if (from->count == 0) return;
+    BLOCK_SUMMARY summary = {from->mean * (double)from->count, from->min, from->max, from->m2};
+    add_summary(into, from->count, &summary);
+    into->int_sum += from->int_sum;
+    if (into->mode == SUM_KAHAN && from->mode == SUM_KAHAN) {
+        add_to_sum(into, from->sum);
+        into->compensation += from->compensation;
+    } else {
+        add_to_sum(into, current_sum(from));
+    }
+}
+
+// Function to read the results of a reduction
+void reduction_finish(const REDUCTION *reduction, COLUMN_AGGREGATES *aggregates) {
+    aggregates->count = reduction->count;
+    if (reduction->type == UINT) {
+        aggregates->sum = (double)reduction->int_sum;
+    } else if (is_integer_type(reduction->type)) {
+        aggregates->sum = (double)(long long int)reduction->int_sum;
+    } else {
+        aggregates->sum = current_sum(reduction);
+    }
+    if (reduction->count == 0) {
+        aggregates->mean = aggregates->min = aggregates->max = aggregates->variance = NAN;
+        return;
+    }
+    aggregates->mean = aggregates->sum / (double)reduction->count;
+    aggregates->min = reduction->min;
+    aggregates->max = reduction->max;
+    aggregates->variance = reduction->m2 / (double)reduction->count;
+}
@@ -0,0 +1,78 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "column.h"
+
+// Instruction sets a kernel can be compiled for, in increasing order of width
+// The 128-bit kernels only need SSE2: SSE4.2 adds no 32-bit or narrower comparison over it (pcmpgtq is 64-bit),
+// and SSE2 is part of every x86-64 processor
+enum kernel_level {
+    KERNEL_SCALAR = 0, KERNEL_SSE2, KERNEL_AVX2
+};
+typedef enum kernel_level KERNEL_LEVEL;
+
+// Function prototypes for the vectorized scan kernels
+
+// Instruction set picked at runtime from cpuid (can be lowered with set_kernel_level)
+KERNEL_LEVEL get_kernel_level(void);
+
+// Force a kernel level, capped at what the processor supports; returns the level in use
+KERNEL_LEVEL set_kernel_level(KERNEL_LEVEL level);
+
+// Whether a column type has a vectorized comparison kernel (UINT, INT, CHAR, FLOAT, DOUBLE)
+int has_compare_kernel(ENUM_TYPE type);
+
+// Add to counts the three-way comparison with the pivot of the values of rows [start, end)
+// values and validity are the column buffers from row 0; validity is NULL when every value is valid
+// and null rows are not counted
+void count_compare_kernel(ENUM_TYPE type, const void *values, const unsigned long long int *validity,
+                          unsigned long long int start, unsigned long long int end,
+                          const void *pivot, COMPARE_COUNTS *counts);
+
+// Set in selected the bits of the valid rows of [start, end) passing a filter, start being a multiple of 64
+// The same comparison masks as count_compare_kernel are combined per filter; returns the number of rows set
+unsigned int filter_kernel(ENUM_TYPE type, const void *values, const unsigned long long int *validity,
+                           unsigned long long int start, unsigned long long int end, FILTER_OP op,
+                           const void *pivot, const void *high, unsigned long long int *selected);
+
+// Running reduction of the non-null values of a numeric range, ranges reduced apart can be merged
+// The mean and the sum of squared deviations from it are merged block by block with Chan's formula,
+// which keeps the variance accurate where the sum of squares would cancel out
+#define REDUCTION_LEVELS 64
+typedef struct reduction {
+    ENUM_TYPE type;
+    SUM_MODE mode;
+    unsigned long long int count;
+    double mean;
+    double m2;  // Sum of the squared deviations from mean
+    double min;
+    double max;
+    unsigned long long int int_sum;  // Exact sum of an integer type, in two's complement for INT and CHAR
+    double sum;  // Running total of a floating type for SUM_PLAIN and SUM_KAHAN
+    double compensation;  // Rounding error of sum not yet added back, SUM_KAHAN
+    unsigned long long int partial_count;  // Block sums pushed for SUM_PAIRWISE: bit i is set while partials[i] is used
+    double partials[REDUCTION_LEVELS];  // partials[i] is the sum of 2^i consecutive block sums
+} REDUCTION;
+
+// Function prototypes for the reduction kernels
+// The AVX2 kernels widen 4 values to doubles per instruction, with two accumulators of each kind;
+// there is no SSE2 variant, below AVX2 the scalar kernels run
+
+// Whether a column type has reduction kernels (UINT, INT, CHAR, FLOAT, DOUBLE)
+int has_reduce_kernel(ENUM_TYPE type);
+
+// Start an empty reduction of a type
+void reduction_init(REDUCTION *reduction, ENUM_TYPE type, SUM_MODE mode);
+
+// Add to a reduction the valid values of rows [start, end), start being a multiple of 64
+// values and validity are the column buffers from row 0 like for count_compare_kernel
+void reduce_kernel(const void *values, const unsigned long long int *validity,
+                   unsigned long long int start, unsigned long long int end, REDUCTION *reduction);
+
+// Add a reduction of the same type and mode to another
+void reduction_merge(REDUCTION *into, const REDUCTION *from);
+
+// Sum, mean, bounds and variance of a reduction
+void reduction_finish(const REDUCTION *reduction, COLUMN_AGGREGATES *aggregates);
+
+#endif // KERNELS_H
@@ -1,4 +1,5 @@
 #include "cdataframe.h"
+#include "csv.h"
 #include <stdio.h>
 #include <stdlib.h> // For dynamic allocation and system clears
 
@@ -12,12 +13,20 @@ int main() {
     int choice;
     char data_type;
     char proceed;
-    printf("Do you want to fill the dataframe yourself (1) or use hardcoded data (2)? Enter choice: ");
+    printf("Do you want to fill the dataframe yourself (1), use hardcoded data (2) or load a CSV file (3)? Enter choice: ");
     scanf("%d", &choice);
 
     if (choice == 1) {
         printf("Please fill the dataframe:\n");
         fill_dataframe_from_user(df);
+    } else if (choice == 3) {
+        char path[256];
+        printf("Enter the path of the CSV file (with a header line): ");
+        scanf("%255s", path);
+        DATAFRAME *loaded = read_csv(path, NULL);
+        free_dataframe(df);
+        if (!loaded) return 1;
+        df = loaded;
     } else {
         // Example predefined data for demonstration purposes
         int data1[] = {1, 2, 3, 4, 5};
@@ -89,11 +98,14 @@ int main() {
                 printf("Enter data for a new row (integers only for simplicity):\n");
                 // Assuming rows are compatible with all columns
                 int *new_row = malloc(df->column_count * sizeof(int));
-                for (int i = 0; i < df->column_count; i++) {
-                    printf("Enter value for column %d: ", i + 1);
+                void **row_data = malloc(df->column_count * sizeof(void *));
+                for (unsigned int i = 0; i < df->column_count; i++) {
+                    printf("Enter value for column %u: ", i + 1);
                     scanf("%d", &new_row[i]);
+                    row_data[i] = &new_row[i];
                 }
-                add_row_to_dataframe(df, new_row);
+                add_row_to_dataframe(df, row_data);
+                free(row_data);
                 free(new_row);
                 break;
             case 7:
@@ -0,0 +1,213 @@
+// mremap is a Linux extension
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "memory.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Buffers of at least MAPPED_BUFFER_SIZE bytes are anonymous mappings that grow with mremap
+#ifdef __linux__
+#define MAPPED_BUFFERS
+#endif
+
+// Process-wide accounting of the aligned buffers, updated on every allocation and release
+static _Atomic size_t current_bytes;
+static _Atomic size_t peak_bytes;
+static _Atomic unsigned long long int allocation_count;
+
+// Round a size up to the next multiple of the buffer alignment
+static size_t round_to_alignment(size_t size) {
+    return (size + BUFFER_ALIGNMENT - 1) & ~(size_t)(BUFFER_ALIGNMENT - 1);
+}
+
+// Record bytes taken by a new buffer and raise the peak if needed
+static void track_alloc(size_t bytes) {
+    size_t current = atomic_fetch_add_explicit(&current_bytes, bytes, memory_order_relaxed) + bytes;
+    size_t peak = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    while (current > peak &&
+           !atomic_compare_exchange_weak_explicit(&peak_bytes, &peak, current, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+#ifdef CDATAFRAME_STATS
+    stat_add_bytes(bytes);
+#endif
+}
+
+// Record bytes given back by a released buffer
+static void track_free(size_t bytes) {
+    atomic_fetch_sub_explicit(&current_bytes, bytes, memory_order_relaxed);
+}
+
+// Every buffer is preceded by a header of BUFFER_ALIGNMENT bytes that keeps its size,
+// so that the data stays aligned and the release knows what to account for
+typedef struct buffer_header {
+    size_t bytes;  // Bytes of the allocation, header included
+    int mapped;  // 1 for an anonymous mapping, 0 for the heap
+} BUFFER_HEADER;
+
+static BUFFER_HEADER *buffer_header(void *ptr) {
+    return (BUFFER_HEADER *)((char *)ptr - BUFFER_ALIGNMENT);
+}
+
+#ifdef MAPPED_BUFFERS
+// Round a size up to whole pages
+static size_t round_to_pages(size_t size) {
+    static size_t page_size = 0;
+    if (page_size == 0) page_size = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+#endif
+
+// Allocate a buffer aligned on BUFFER_ALIGNMENT bytes
+void *aligned_buffer_alloc(size_t size) {
+    if (size == 0) return NULL;
+    size_t bytes = BUFFER_ALIGNMENT + round_to_alignment(size);
+    int mapped = 0;
+    char *base;
+#ifdef MAPPED_BUFFERS
+    if (bytes >= MAPPED_BUFFER_SIZE) {
+        bytes = round_to_pages(bytes);
+        base = (char *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return NULL;
+        mapped = 1;
+    } else
+#endif
+    {
+#ifdef _WIN32
+        base = (char *)_aligned_malloc(bytes, BUFFER_ALIGNMENT);
+#else
+        base = (char *)aligned_alloc(BUFFER_ALIGNMENT, bytes);
+#endif
+        if (base == NULL) return NULL;
+    }
+    BUFFER_HEADER *header = (BUFFER_HEADER *)base;
+    header->bytes = bytes;
+    header->mapped = mapped;
+    track_alloc(bytes);
+    return base + BUFFER_ALIGNMENT;
+}
+
+// Grow or shrink an aligned buffer, keeping the first min(old_size, new_size) bytes
+// A mapped buffer staying large is remapped: its pages move without being copied, so growing a column of
+// any size costs about the same and never holds the old and the new buffer at once
+void *aligned_buffer_realloc(void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) return aligned_buffer_alloc(new_size);
+    if (new_size == 0) {
+        aligned_buffer_free(ptr);
+        return NULL;
+    }
+    BUFFER_HEADER *header = buffer_header(ptr);
+    size_t old_bytes = header->bytes;
+#ifdef MAPPED_BUFFERS
+    size_t new_bytes = BUFFER_ALIGNMENT + round_to_alignment(new_size);
+    if (header->mapped && new_bytes >= MAPPED_BUFFER_SIZE) {
+        new_bytes = round_to_pages(new_bytes);
+        char *base = (char *)mremap(header, old_bytes, new_bytes, MREMAP_MAYMOVE);
+        if (base == MAP_FAILED) return NULL;
+        ((BUFFER_HEADER *)base)->bytes = new_bytes;
+        track_free(old_bytes);
+        track_alloc(new_bytes);
+        return base + BUFFER_ALIGNMENT;
+    }
+#endif
+    if (old_size > old_bytes - BUFFER_ALIGNMENT) old_size = old_bytes - BUFFER_ALIGNMENT;
+    void *new_ptr = aligned_buffer_alloc(new_size);
+    if (new_ptr == NULL) return NULL;
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    aligned_buffer_free(ptr);
+    return new_ptr;
+}
+
+// Release a buffer obtained from aligned_buffer_alloc or aligned_buffer_realloc
+void aligned_buffer_free(void *ptr) {
+    if (ptr == NULL) return;
+    BUFFER_HEADER *header = buffer_header(ptr);
+    track_free(header->bytes);
+#ifdef MAPPED_BUFFERS
+    if (header->mapped) {
+        munmap(header, header->bytes);
+        return;
+    }
+#endif
+#ifdef _WIN32
+    _aligned_free(header);
+#else
+    free(header);
+#endif
+}
+
+// Function to read the process-wide accounting of the aligned buffers
+void get_memory_stats(MEMORY_STATS *stats) {
+    if (stats == NULL) return;
+    stats->current = atomic_load_explicit(&current_bytes, memory_order_relaxed);
+    stats->peak = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    stats->allocations = atomic_load_explicit(&allocation_count, memory_order_relaxed);
+}
+
+// Function to restart the peak from the current usage
+void reset_memory_peak(void) {
+    atomic_store_explicit(&peak_bytes, atomic_load_explicit(&current_bytes, memory_order_relaxed),
+                          memory_order_relaxed);
+}
+
+// Map a whole file read-only and get its size
+const char *map_file(const char *path, size_t *size) {
+#ifdef _WIN32
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    char *data = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+    if (length >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = (char *)malloc((size_t)length + 1);
+        if (data != NULL && fread(data, 1, (size_t)length, file) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    *size = data != NULL ? (size_t)length : 0;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    if (*size == 0) {
+        close(fd);
+        return "";
+    }
+    void *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file referenced
+    if (data == MAP_FAILED) return NULL;
+    // The file is read front to back
+    madvise(data, *size, MADV_SEQUENTIAL);
+    return (const char *)data;
+#endif
+}
+
+// Release a mapping obtained from map_file
+void unmap_file(const char *data, size_t size) {
+    if (data == NULL) return;
+#ifdef _WIN32
+    (void)size;
+    free((void *)data);
+#else
+    if (size > 0) munmap((void *)data, size);
+#endif
+}
@@ -0,0 +1,43 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+// Alignment (in bytes) of every column value buffer, one cache line
+#define BUFFER_ALIGNMENT 64
+
+// Buffers from this size up are allocated as their own memory mapping where the system can grow one in place
+// or move it without copying (Linux mremap); elsewhere a growing buffer is copied
+#define MAPPED_BUFFER_SIZE (1 << 20)
+
+// Process-wide accounting of the aligned buffers (column values, string arenas and sorted indexes)
+typedef struct memory_stats {
+    size_t current;  // Bytes held right now, headers and alignment padding included
+    size_t peak;  // Highest value of current since the start or the last reset_memory_peak
+    unsigned long long int allocations;  // Buffers allocated so far, reallocations included
+} MEMORY_STATS;
+
+// Breakdown of the memory held by a column or a dataframe, in bytes
+typedef struct memory_usage {
+    size_t payload;  // Values of the rows in use, their strings and their validity bits
+    size_t overhead;  // Structs, titles, column arrays, deletion bitmaps and zone maps
+    size_t indexes;  // Sorted and hash indexes
+    size_t slack;  // Reserved capacity not in use yet (max_size - size rows, unused arena bytes)
+    size_t mapped;  // Bytes read from a file mapping rather than allocated, counted in no other field
+} MEMORY_USAGE;
+
+// Function prototypes for aligned buffer management
+void *aligned_buffer_alloc(size_t size);
+void *aligned_buffer_realloc(void *ptr, size_t old_size, size_t new_size);
+void aligned_buffer_free(void *ptr);
+
+// Function prototypes for the process-wide memory tracker
+void get_memory_stats(MEMORY_STATS *stats);
+void reset_memory_peak(void);
+
+// Function prototypes for read-only file mappings (a plain read where mmap is not available)
+// map_file returns NULL on failure; an empty file gives a non-NULL mapping of size 0
+const char *map_file(const char *path, size_t *size);
+void unmap_file(const char *data, size_t size);
+
+#endif // MEMORY_H
@@ -0,0 +1,317 @@
+//
+// Created by samya on 03/05/2024.
+//
+
+#include "sort.h"
+#include "bitmap.h"
+#include "threadpool.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+// Columns with fewer values are sorted on the calling thread only
+#define PARALLEL_SORT_ROWS (1u << 20)
+// Runs sorted by insertion before the merge passes of the string sort
+#define INSERTION_RUN 32
+
+// Map a value to an unsigned key whose unsigned order is the value order
+// Signed integers get their sign bit flipped; negative floats have every bit flipped, positive ones only the sign bit
+// -0.0 is folded into +0.0 since they compare equal
+static unsigned long long int float_key(float value) {
+    if (value == 0.0f) value = 0.0f;
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static unsigned long long int double_key(double value) {
+    if (value == 0.0) value = 0.0;
+    unsigned long long int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+}
+
+// Radix key of row i and number of significant key bytes of a type
+static unsigned long long int radix_key(const COLUMN *col, unsigned int i) {
+    switch (col->column_type) {
+        case UINT:
+            return ((const unsigned int *)col->values)[i];
+        case INT:
+            return (unsigned int)((const int *)col->values)[i] ^ 0x80000000u;
+        case CHAR:
+            return (unsigned char)((const char *)col->values)[i] ^ (CHAR_MIN < 0 ? 0x80u : 0u);
+        case FLOAT:
+            return float_key(((const float *)col->values)[i]);
+        case DOUBLE:
+            return double_key(((const double *)col->values)[i]);
+        case STRUCTURE:
+            return double_key(((const CustomStructure *)col->values)[i].value);
+        default:
+            return 0;
+    }
+}
+
+static unsigned int radix_key_bytes(ENUM_TYPE type) {
+    switch (type) {
+        case CHAR:
+            return 1;
+        case UINT:
+        case INT:
+        case FLOAT:
+            return 4;
+        default:
+            return 8;
+    }
+}
+
+// State shared by the chunks of a parallel radix pass
+typedef struct radix_job {
+    unsigned long long int *keys;
+    unsigned long long int *keys_out;
+    unsigned int *rows;
+    unsigned int *rows_out;
+    unsigned int n;
+    unsigned int chunks;
+    unsigned int shift;
+    unsigned long long int (*histograms)[RADIX_BUCKETS];  // One histogram, then one offset table, per chunk
+} RADIX_JOB;
+
+static void chunk_bounds(unsigned int n, unsigned int chunks, unsigned int chunk, unsigned int *start, unsigned int *end) {
+    *start = (unsigned int)((unsigned long long int)n * chunk / chunks);
+    *end = (unsigned int)((unsigned long long int)n * (chunk + 1) / chunks);
+}
+
+static void radix_histogram(void *ctx, unsigned int chunk, unsigned int worker) {
+    (void)worker;
+    RADIX_JOB *job = (RADIX_JOB *)ctx;
+    unsigned int start, end;
+    chunk_bounds(job->n, job->chunks, chunk, &start, &end);
+    unsigned long long int *histogram = job->histograms[chunk];
+    memset(histogram, 0, RADIX_BUCKETS * sizeof(unsigned long long int));
+    for (unsigned int i = start; i < end; i++) {
+        histogram[(job->keys[i] >> job->shift) & (RADIX_BUCKETS - 1)]++;
+    }
+}
+
+// Each chunk scatters its values to its own offsets, so the pass stays stable
+static void radix_scatter(void *ctx, unsigned int chunk, unsigned int worker) {
+    (void)worker;
+    RADIX_JOB *job = (RADIX_JOB *)ctx;
+    unsigned int start, end;
+    chunk_bounds(job->n, job->chunks, chunk, &start, &end);
+    unsigned long long int *offsets = job->histograms[chunk];
+    for (unsigned int i = start; i < end; i++) {
+        unsigned long long int pos = offsets[(job->keys[i] >> job->shift) & (RADIX_BUCKETS - 1)]++;
+        job->keys_out[pos] = job->keys[i];
+        job->rows_out[pos] = job->rows[i];
+    }
+}
+
+// LSD radix sort of (key, row) pairs, one pass per key byte; passes where every key has the same byte are skipped
+// Returns the buffer holding the sorted rows (rows or rows_tmp)
+static unsigned int *radix_sort(unsigned long long int *keys, unsigned long long int *keys_tmp,
+                                unsigned int *rows, unsigned int *rows_tmp, unsigned int n,
+                                unsigned int key_bytes, THREAD_POOL *pool,
+                                unsigned long long int (*histograms)[RADIX_BUCKETS], unsigned int chunks) {
+    RADIX_JOB job = {keys, keys_tmp, rows, rows_tmp, n, chunks, 0, histograms};
+    for (unsigned int byte = 0; byte < key_bytes; byte++) {
+        job.shift = byte * RADIX_BITS;
+        thread_pool_run(pool, chunks, radix_histogram, &job);
+
+        // Turn the per-chunk histograms into per-chunk starting offsets, digit major then chunk
+        int constant_digit = 0;
+        unsigned long long int offset = 0;
+        for (unsigned int digit = 0; digit < RADIX_BUCKETS; digit++) {
+            unsigned long long int digit_total = 0;
+            for (unsigned int c = 0; c < chunks; c++) {
+                unsigned long long int count = histograms[c][digit];
+                histograms[c][digit] = offset;
+                offset += count;
+                digit_total += count;
+            }
+            if (digit_total == n) constant_digit = 1;
+        }
+        if (constant_digit) continue;
+
+        thread_pool_run(pool, chunks, radix_scatter, &job);
+        unsigned long long int *swap_keys = job.keys;
+        job.keys = job.keys_out;
+        job.keys_out = swap_keys;
+        unsigned int *swap_rows = job.rows;
+        job.rows = job.rows_out;
+        job.rows_out = swap_rows;
+    }
+    return job.rows;
+}
+
+// Strings are ordered on an 8-byte big-endian prefix first, strcmp only breaks prefix ties
+typedef struct string_sort {
+    const COLUMN *col;
+    const unsigned long long int *prefixes;  // Indexed by row
+    int descending;
+    unsigned int *rows;
+    unsigned int *rows_tmp;
+    unsigned int n;
+    unsigned int width;  // Length of the runs merged by the current pass
+} STRING_SORT;
+
+static unsigned long long int string_prefix(const char *str) {
+    unsigned long long int prefix = 0;
+    unsigned int i = 0;
+    for (; i < 8 && str[i] != '\0'; i++) {
+        prefix = (prefix << 8) | (unsigned char)str[i];
+    }
+    // An empty string has a zero prefix, shifting by 64 bits would be undefined
+    return i > 0 ? prefix << (8 * (8 - i)) : 0;
+}
+
+static int compare_rows(const STRING_SORT *sort, unsigned int a, unsigned int b) {
+    int cmp;
+    if (sort->prefixes[a] != sort->prefixes[b]) {
+        cmp = sort->prefixes[a] < sort->prefixes[b] ? -1 : 1;
+    } else {
+        const unsigned long long int *offsets = (const unsigned long long int *)sort->col->values;
+        cmp = strcmp(sort->col->strings + offsets[a], sort->col->strings + offsets[b]);
+    }
+    return sort->descending ? -cmp : cmp;
+}
+
+// Stable insertion sort of one run
+static void insertion_sort_run(void *ctx, unsigned int run, unsigned int worker) {
+    (void)worker;
+    STRING_SORT *sort = (STRING_SORT *)ctx;
+    unsigned int start = run * sort->width;
+    unsigned int end = start + sort->width < sort->n ? start + sort->width : sort->n;
+    for (unsigned int i = start + 1; i < end; i++) {
+        unsigned int row = sort->rows[i];
+        unsigned int j = i;
+        while (j > start && compare_rows(sort, sort->rows[j - 1], row) > 0) {
+            sort->rows[j] = sort->rows[j - 1];
+            j--;
+        }
+        sort->rows[j] = row;
+    }
+}
+
+// Stable merge of two neighbouring runs of rows into rows_tmp
+static void merge_runs(void *ctx, unsigned int pair, unsigned int worker) {
+    (void)worker;
+    STRING_SORT *sort = (STRING_SORT *)ctx;
+    unsigned long long int start = (unsigned long long int)pair * 2 * sort->width;
+    unsigned long long int mid = start + sort->width < sort->n ? start + sort->width : sort->n;
+    unsigned long long int end = mid + sort->width < sort->n ? mid + sort->width : sort->n;
+    unsigned long long int i = start, j = mid, k = start;
+    while (i < mid && j < end) {
+        sort->rows_tmp[k++] = compare_rows(sort, sort->rows[j], sort->rows[i]) < 0 ? sort->rows[j++] : sort->rows[i++];
+    }
+    while (i < mid) sort->rows_tmp[k++] = sort->rows[i++];
+    while (j < end) sort->rows_tmp[k++] = sort->rows[j++];
+}
+
+// Bottom-up merge sort, the runs of each pass are merged in parallel; returns the buffer holding the result
+static unsigned int *string_merge_sort(STRING_SORT *sort, THREAD_POOL *pool) {
+    sort->width = INSERTION_RUN;
+    thread_pool_run(pool, (sort->n + INSERTION_RUN - 1) / INSERTION_RUN, insertion_sort_run, sort);
+    for (; sort->width < sort->n; sort->width *= 2) {
+        unsigned int pairs = (unsigned int)((sort->n + 2ULL * sort->width - 1) / (2ULL * sort->width));
+        thread_pool_run(pool, pairs, merge_runs, sort);
+        unsigned int *swap = sort->rows;
+        sort->rows = sort->rows_tmp;
+        sort->rows_tmp = swap;
+    }
+    return sort->rows;
+}
+
+// Function to sort a column into its index
+int sort_column(COLUMN *col, SORT_ORDER order) {
+    if (col == NULL) return 0;
+    unsigned int n = col->size;
+
+    // The index has room for max_size rows so that appends can keep it up to date
+    size_t capacity = col->max_size > 0 ? col->max_size : 1;
+    // The previous order is rebuilt from scratch, nothing needs to be copied
+    unsigned long long int *index = (unsigned long long int *)column_buffer_realloc(
+            col, col->index, 0, capacity * sizeof(unsigned long long int));
+    if (!index) {
+        fprintf(stderr, "Memory allocation failed for the column index.\n");
+        return 0;
+    }
+    col->index = index;
+    col->valid_index = 0;
+
+    // Valid rows are sorted, null and deleted rows go last in row order
+    unsigned int valid = n - (unsigned int)count_nulls(col) - col->deleted_count;
+    unsigned int *rows = (unsigned int *)malloc((n > 0 ? n : 1) * sizeof(unsigned int));
+    unsigned int *rows_tmp = (unsigned int *)malloc((n > 0 ? n : 1) * sizeof(unsigned int));
+    if (!rows || !rows_tmp) {
+        fprintf(stderr, "Memory allocation failed for the sort.\n");
+        free(rows);
+        free(rows_tmp);
+        return 0;
+    }
+    unsigned int k = 0, nulls = valid;
+    for (unsigned int i = 0; i < n; i++) {
+        if (is_null_at(col, i)) {
+            rows_tmp[nulls++] = i;
+        } else {
+            rows[k++] = i;
+        }
+    }
+    for (unsigned int i = valid; i < n; i++) {
+        index[i] = rows_tmp[i];
+    }
+
+    THREAD_POOL *pool = n >= PARALLEL_SORT_ROWS ? get_default_thread_pool() : NULL;
+    unsigned int *sorted = rows;
+    int ok = 1;
+
+    if (col->column_type == STRING) {
+        unsigned long long int *prefixes = (unsigned long long int *)malloc((n > 0 ? n : 1) * sizeof(unsigned long long int));
+        if (prefixes) {
+            const unsigned long long int *offsets = (const unsigned long long int *)col->values;
+            for (unsigned int i = 0; i < valid; i++) {
+                prefixes[rows[i]] = string_prefix(col->strings + offsets[rows[i]]);
+            }
+            STRING_SORT sort = {col, prefixes, order == DESC, rows, rows_tmp, valid, 0};
+            sorted = string_merge_sort(&sort, pool);
+            free(prefixes);
+        } else {
+            ok = 0;
+        }
+    } else if (col->elem_size > 0) {
+        unsigned int chunks = pool ? thread_pool_size(pool) : 1;
+        unsigned long long int *keys = (unsigned long long int *)malloc((n > 0 ? n : 1) * sizeof(unsigned long long int));
+        unsigned long long int *keys_tmp = (unsigned long long int *)malloc((n > 0 ? n : 1) * sizeof(unsigned long long int));
+        unsigned long long int (*histograms)[RADIX_BUCKETS] = malloc(chunks * sizeof(*histograms));
+        if (keys && keys_tmp && histograms) {
+            // Descending order complements the keys, which keeps equal values in row order
+            unsigned long long int flip = order == DESC ? ~0ULL : 0ULL;
+            for (unsigned int i = 0; i < valid; i++) {
+                keys[i] = radix_key(col, rows[i]) ^ flip;
+            }
+            sorted = radix_sort(keys, keys_tmp, rows, rows_tmp, valid, radix_key_bytes(col->column_type),
+                                pool, histograms, chunks);
+        } else {
+            ok = 0;
+        }
+        free(keys);
+        free(keys_tmp);
+        free(histograms);
+    }
+
+    if (ok) {
+        for (unsigned int i = 0; i < valid; i++) {
+            index[i] = sorted[i];
+        }
+        col->valid_index = 1;
+        col->sort_dir = order;
+    } else {
+        fprintf(stderr, "Memory allocation failed for the sort.\n");
+    }
+    free(rows);
+    free(rows_tmp);
+    return ok;
+}
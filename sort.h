@@ -5,4 +5,15 @@
 #ifndef CDATAFRAME2_SORT_H
 #define CDATAFRAME2_SORT_H
 
+#include "column.h"
+
+// Function prototypes for sorting columns
+
+// Fill col->index with the stable permutation of the rows in the given order, nulls last
+// INT, UINT, CHAR, FLOAT, DOUBLE and STRUCTURE (by value) use an LSD radix sort, STRING a merge sort;
+// large columns are partitioned across the threads of the process-wide pool
+// The index is then kept valid by appends that preserve the order and used by the count_* functions
+// Returns 1 on success, 0 on failure
+int sort_column(COLUMN *col, SORT_ORDER order);
+
 #endif //CDATAFRAME2_SORT_H
@@ -0,0 +1,179 @@
+#include "stats.h"
+#include "writer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STAT_NAME_ENTRY(id, name) name,
+static const char *const stat_names[STAT_OP_COUNT] = {STAT_OPERATIONS(STAT_NAME_ENTRY)};
+#undef STAT_NAME_ENTRY
+
+#ifdef CDATAFRAME_STATS
+
+// Counters of one operation on one thread; only that thread writes them, readers load them relaxed
+typedef struct stat_counters {
+    _Atomic unsigned long long int calls;
+    _Atomic unsigned long long int rows;
+    _Atomic unsigned long long int bytes;
+    _Atomic unsigned long long int nanoseconds;
+} STAT_COUNTERS;
+
+// Counters of every operation of one thread, kept after the thread exits so that readers still see them
+typedef struct stat_block {
+    STAT_COUNTERS ops[STAT_OP_COUNT];
+    struct stat_block *next;
+} STAT_BLOCK;
+
+static STAT_BLOCK *_Atomic stat_blocks = NULL;
+static _Thread_local STAT_BLOCK *local_block = NULL;
+static _Thread_local int current_op = -1;
+
+// Monotonic clock in nanoseconds
+static unsigned long long int now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long int)ts.tv_sec * 1000000000ULL + (unsigned long long int)ts.tv_nsec;
+}
+
+// Counters of the calling thread, registered on first use; NULL if they could not be allocated
+static STAT_BLOCK *thread_block(void) {
+    if (local_block != NULL) return local_block;
+    STAT_BLOCK *block = (STAT_BLOCK *)calloc(1, sizeof(STAT_BLOCK));
+    if (block == NULL) return NULL;
+    block->next = atomic_load_explicit(&stat_blocks, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&stat_blocks, &block->next, block, memory_order_release,
+                                                  memory_order_relaxed)) {
+    }
+    local_block = block;
+    return block;
+}
+
+// Single-writer increment: a plain load and store, no locked instruction
+static void counter_add(_Atomic unsigned long long int *counter, unsigned long long int value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// Function to open a call of an operation on the current thread
+STAT_CALL stat_call_begin(STAT_OP op, unsigned long long int rows) {
+    STAT_CALL call = {op, current_op, rows, now_ns()};
+    current_op = (int)op;
+    return call;
+}
+
+// Function to close a call, adding its time and rows to the counters of the thread
+void stat_call_end(STAT_CALL *call) {
+    unsigned long long int elapsed = now_ns() - call->start;
+    current_op = call->outer;
+    STAT_BLOCK *block = thread_block();
+    if (block == NULL) return;
+    STAT_COUNTERS *counters = &block->ops[call->op];
+    counter_add(&counters->calls, 1);
+    counter_add(&counters->rows, call->rows);
+    counter_add(&counters->nanoseconds, elapsed);
+}
+
+// Function to charge an allocation to the innermost operation running on the current thread
+void stat_add_bytes(size_t bytes) {
+    if (current_op < 0) return;
+    STAT_BLOCK *block = thread_block();
+    if (block != NULL) counter_add(&block->ops[current_op].bytes, bytes);
+}
+
+int dataframe_stats_enabled(void) {
+    return 1;
+}
+
+void dataframe_stats_get(STAT_OP op, STAT_TOTALS *totals) {
+    memset(totals, 0, sizeof(STAT_TOTALS));
+    if ((int)op < 0 || op >= STAT_OP_COUNT) return;
+    for (STAT_BLOCK *block = atomic_load_explicit(&stat_blocks, memory_order_acquire); block != NULL;
+         block = block->next) {
+        const STAT_COUNTERS *counters = &block->ops[op];
+        totals->calls += atomic_load_explicit(&counters->calls, memory_order_relaxed);
+        totals->rows += atomic_load_explicit(&counters->rows, memory_order_relaxed);
+        totals->bytes += atomic_load_explicit(&counters->bytes, memory_order_relaxed);
+        totals->nanoseconds += atomic_load_explicit(&counters->nanoseconds, memory_order_relaxed);
+    }
+}
+
+// Calls in progress on other threads may add to the counters right after they are cleared
+void dataframe_stats_reset(void) {
+    for (STAT_BLOCK *block = atomic_load_explicit(&stat_blocks, memory_order_acquire); block != NULL;
+         block = block->next) {
+        for (int op = 0; op < STAT_OP_COUNT; op++) {
+            atomic_store_explicit(&block->ops[op].calls, 0, memory_order_relaxed);
+            atomic_store_explicit(&block->ops[op].rows, 0, memory_order_relaxed);
+            atomic_store_explicit(&block->ops[op].bytes, 0, memory_order_relaxed);
+            atomic_store_explicit(&block->ops[op].nanoseconds, 0, memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+int dataframe_stats_enabled(void) {
+    return 0;
+}
+
+void dataframe_stats_get(STAT_OP op, STAT_TOTALS *totals) {
+    (void)op;
+    memset(totals, 0, sizeof(STAT_TOTALS));
+}
+
+void dataframe_stats_reset(void) {
+}
+
+#endif
+
+// Function to render the merged counters of the operations that were called
+char *dataframe_stats_dump(STATS_FORMAT format) {
+    TEXT_WRITER writer;
+    writer_init(&writer, -1);
+    int json = format == STATS_JSON;
+    if (json) {
+        writer_put_string(&writer, "{\"enabled\": ");
+        writer_put_string(&writer, dataframe_stats_enabled() ? "true" : "false");
+        writer_put_string(&writer, ", \"operations\": [");
+    } else if (!dataframe_stats_enabled()) {
+        writer_put_string(&writer, "Instrumentation is not compiled in (build with CDATAFRAME_STATS).\n");
+    } else {
+        writer_put_string(&writer, "operation                          calls        rows       bytes   total ms   ns/call\n");
+    }
+
+    int listed = 0;
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        STAT_TOTALS totals;
+        dataframe_stats_get((STAT_OP)op, &totals);
+        if (totals.calls == 0) continue;
+        if (json) {
+            writer_put_string(&writer, listed > 0 ? ", {\"name\": \"" : "{\"name\": \"");
+            writer_put_string(&writer, stat_names[op]);
+            writer_put_string(&writer, "\", \"calls\": ");
+            writer_put_uint(&writer, totals.calls);
+            writer_put_string(&writer, ", \"rows\": ");
+            writer_put_uint(&writer, totals.rows);
+            writer_put_string(&writer, ", \"bytes\": ");
+            writer_put_uint(&writer, totals.bytes);
+            writer_put_string(&writer, ", \"nanoseconds\": ");
+            writer_put_uint(&writer, totals.nanoseconds);
+            writer_put_char(&writer, '}');
+        } else {
+            char line[160];
+            snprintf(line, sizeof(line), "%-28s %11llu %11llu %11llu %10.3f %9llu\n", stat_names[op], totals.calls,
+                     totals.rows, totals.bytes, totals.nanoseconds / 1e6, totals.nanoseconds / totals.calls);
+            writer_put_string(&writer, line);
+        }
+        listed++;
+    }
+    if (json) writer_put_string(&writer, "]}\n");
+
+    // The text is handed over with its terminator instead of closing the writer
+    writer_put_char(&writer, '\0');
+    if (writer.failed) {
+        writer_close(&writer);
+        return NULL;
+    }
+    return writer.data;
+}
@@ -0,0 +1,93 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+
+// Operations counted by the instrumentation, the costly public functions of column.h, cdataframe.h, groupby.h,
+// join.h and filter.h
+// Per-cell accessors (get_value_at, is_null_at, convert_value...) are left out: the clock would cost more than them
+#define STAT_OPERATIONS(X)                                                                                        \
+    X(CREATE_COLUMN, "create_column") X(INSERT_VALUE, "insert_value") X(COLUMN_RESERVE, "column_reserve")       \
+    X(COLUMN_APPEND_N, "column_append_n") X(REMOVE_LAST_VALUE, "remove_last_value")                            \
+    X(COLUMN_APPEND_GATHER, "column_append_gather")                                                             \
+    X(COLUMN_DELETE_ROW, "column_delete_row") X(COLUMN_COMPACT, "column_compact") X(DELETE_COLUMN, "delete_column") \
+    X(PRINT_COL, "print_col") X(WRITE_COLUMN_ROWS, "write_column_rows") X(COUNT_OCCURRENCES, "count_occurrences") \
+    X(SET_VALUE_AT, "set_value_at") X(COUNT_NULLS, "count_nulls") X(COUNT_COMPARE, "count_compare")             \
+    X(COUNT_COMPARE_WITH_INDEX, "count_compare_with_index") X(COLUMN_HISTOGRAM, "column_histogram")             \
+    X(COLUMN_AGGREGATE, "column_aggregate") X(COLUMN_FILTER, "column_filter")                                   \
+    X(HARD_FILL_DATAFRAME, "hard_fill_dataframe") X(FREE_DATAFRAME, "free_dataframe")                           \
+    X(DISPLAY_FULL_DATAFRAME, "display_full_dataframe") X(DISPLAY_DATAFRAME_ROWS, "display_dataframe_rows")     \
+    X(DISPLAY_DATAFRAME_COLUMNS, "display_dataframe_columns") X(ADD_ROW_TO_DATAFRAME, "add_row_to_dataframe")   \
+    X(ADD_ROWS_TO_DATAFRAME, "add_rows_to_dataframe") X(DELETE_ROWS_FROM_DATAFRAME, "delete_rows_from_dataframe") \
+    X(COMPACT_DATAFRAME, "compact_dataframe") X(REMOVE_COLUMN_FROM_DATAFRAME, "remove_column_from_dataframe")   \
+    X(CHECK_VALUE_EXISTENCE, "check_value_existence") X(COUNT_CELLS_COMPARE, "count_cells_compare")             \
+    X(COUNT_CELLS_HISTOGRAM, "count_cells_histogram") X(DATAFRAME_AGGREGATE, "dataframe_aggregate")             \
+    X(DATAFRAME_GROUP_BY, "dataframe_group_by")                                                                 \
+    X(DATAFRAME_JOIN, "dataframe_join")                                                                         \
+    X(DATAFRAME_FILTER, "dataframe_filter")
+
+#define STAT_ENUM_ENTRY(id, name) STAT_##id,
+typedef enum stat_op {
+    STAT_OPERATIONS(STAT_ENUM_ENTRY)
+    STAT_OP_COUNT
+} STAT_OP;
+#undef STAT_ENUM_ENTRY
+
+// Totals of one operation over every thread
+typedef struct stat_totals {
+    unsigned long long int calls;
+    unsigned long long int rows;  // Rows the calls touched, cells over every column for dataframe operations
+    unsigned long long int bytes;  // Bytes of aligned buffers allocated while the operation was the innermost one
+    unsigned long long int nanoseconds;  // Time spent inside the calls, nested operations included
+} STAT_TOTALS;
+
+// Output formats of dataframe_stats_dump
+typedef enum stats_format {
+    STATS_TEXT,
+    STATS_JSON
+} STATS_FORMAT;
+
+// Function prototypes for reading the counters, available whether or not they are compiled in
+
+// Whether the library was built with CDATAFRAME_STATS
+int dataframe_stats_enabled(void);
+
+// Merge the per-thread counters of an operation, all zeros when compiled out
+void dataframe_stats_get(STAT_OP op, STAT_TOTALS *totals);
+
+// Text table or JSON document of the operations called so far, to be freed by the caller; NULL on failure
+char *dataframe_stats_dump(STATS_FORMAT format);
+
+// Set every counter back to zero
+void dataframe_stats_reset(void);
+
+#ifdef CDATAFRAME_STATS
+
+#if !defined(__GNUC__)
+#error "CDATAFRAME_STATS needs the cleanup attribute of GCC or Clang"
+#endif
+
+// Call in progress on the current thread, closed by stat_call_end when it goes out of scope
+typedef struct stat_call {
+    STAT_OP op;
+    int outer;  // Operation the call is nested in, -1 for none
+    unsigned long long int rows;
+    unsigned long long int start;
+} STAT_CALL;
+
+STAT_CALL stat_call_begin(STAT_OP op, unsigned long long int rows);
+void stat_call_end(STAT_CALL *call);
+void stat_add_bytes(size_t bytes);
+
+// Count the enclosing function as one call of op touching rows rows, timed until it returns
+#define STAT_SCOPE(op, rows) \
+    __attribute__((cleanup(stat_call_end))) STAT_CALL stat_call_ = stat_call_begin(STAT_##op, (rows))
+
+#else
+
+// Compiled out: no code, the arguments are not even evaluated
+#define STAT_SCOPE(op, rows)
+
+#endif
+
+#endif // STATS_H
@@ -0,0 +1,263 @@
+#include "storage.h"
+#include "memory.h"
+#include "bitmap.h"
+#include "zonemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STORAGE_MAGIC "CDFRAME"
+#define STORAGE_VERSION 2
+// Written as a number so that a file from a machine of the other byte order is recognized
+#define STORAGE_BYTE_ORDER 0x01020304u
+
+// First bytes of the file
+typedef struct file_header {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned int column_count;
+    unsigned int zone_rows;  // ZONE_ROWS of the writer, the zone maps are ignored when it differs
+    unsigned long long int columns_offset;  // Offset of the column_count COLUMN_ENTRY
+} FILE_HEADER;
+
+// Where the buffers of a column are, offsets from the start of the file, 0 for an absent buffer
+typedef struct column_entry {
+    unsigned int type;
+    unsigned int size;
+    unsigned int deleted_count;
+    unsigned int reserved;
+    unsigned long long int title_offset;  // NUL-terminated
+    unsigned long long int title_length;
+    unsigned long long int values_offset;
+    unsigned long long int values_bytes;
+    unsigned long long int strings_offset;
+    unsigned long long int strings_bytes;
+    unsigned long long int validity_offset;
+    unsigned long long int deleted_offset;
+    unsigned long long int zones_offset;
+} COLUMN_ENTRY;
+
+static unsigned long long int align_offset(unsigned long long int offset) {
+    return (offset + BUFFER_ALIGNMENT - 1) & ~(unsigned long long int)(BUFFER_ALIGNMENT - 1);
+}
+
+static unsigned long long int zone_bytes(unsigned int size) {
+    return (unsigned long long int)((size + ZONE_ROWS - 1) / ZONE_ROWS) * sizeof(ZONE);
+}
+
+static unsigned long long int validity_bytes(unsigned int size) {
+    return (unsigned long long int)bitmap_words(size) * sizeof(unsigned long long int);
+}
+
+// Gives bytes an aligned place after *end and returns its offset, 0 for nothing to store
+static unsigned long long int place_block(unsigned long long int *end, unsigned long long int bytes) {
+    if (bytes == 0) return 0;
+    unsigned long long int offset = align_offset(*end);
+    *end = offset + bytes;
+    return offset;
+}
+
+// Pads the file up to offset, then writes the block
+static int write_block(FILE *file, unsigned long long int *written, unsigned long long int offset,
+                       const void *data, unsigned long long int bytes) {
+    static const char zeros[BUFFER_ALIGNMENT] = {0};
+    if (bytes == 0) return 1;
+    while (*written < offset) {
+        size_t pad = offset - *written < sizeof(zeros) ? (size_t)(offset - *written) : sizeof(zeros);
+        if (fwrite(zeros, 1, pad, file) != pad) return 0;
+        *written += pad;
+    }
+    if (fwrite(data, 1, (size_t)bytes, file) != (size_t)bytes) return 0;
+    *written += bytes;
+    return 1;
+}
+
+// Writes the dataframe to a binary columnar file
+int save_dataframe(DATAFRAME *df, const char *path) {
+    if (!df || !path) {
+        fprintf(stderr, "Invalid arguments for saving the dataframe.\n");
+        return -1;
+    }
+
+    // The dead bytes of the string arenas are dropped rather than written
+    for (unsigned int i = 0; i < df->column_count; i++) {
+        if (df->columns[i]->strings_dead > 0 && !column_repack_strings(df->columns[i])) return -1;
+    }
+
+    COLUMN_ENTRY *entries = (COLUMN_ENTRY *)calloc(df->column_count + 1, sizeof(COLUMN_ENTRY));
+    size_t path_length = strlen(path);
+    char *temp_path = (char *)malloc(path_length + 5);
+    if (!entries || !temp_path) {
+        free(entries);
+        free(temp_path);
+        fprintf(stderr, "Memory allocation failed for saving the dataframe.\n");
+        return -1;
+    }
+    memcpy(temp_path, path, path_length);
+    memcpy(temp_path + path_length, ".tmp", 5);
+
+    // Lay the blocks out first so that the header can be written in front of them
+    FILE_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORAGE_MAGIC, sizeof(STORAGE_MAGIC));
+    header.version = STORAGE_VERSION;
+    header.byte_order = STORAGE_BYTE_ORDER;
+    header.column_count = df->column_count;
+    header.zone_rows = ZONE_ROWS;
+    header.columns_offset = align_offset(sizeof(FILE_HEADER));
+    unsigned long long int end = header.columns_offset + (unsigned long long int)df->column_count * sizeof(COLUMN_ENTRY);
+    for (unsigned int i = 0; i < df->column_count; i++) {
+        COLUMN *col = df->columns[i];
+        COLUMN_ENTRY *entry = &entries[i];
+        entry->type = col->column_type;
+        entry->size = col->size;
+        entry->title_length = strlen(col->title);
+        entry->title_offset = place_block(&end, entry->title_length + 1);
+        entry->values_bytes = (unsigned long long int)col->size * col->elem_size;
+        entry->values_offset = place_block(&end, entry->values_bytes);
+        entry->strings_bytes = col->strings_size;
+        entry->strings_offset = place_block(&end, entry->strings_bytes);
+        entry->validity_offset = col->validity != NULL ? place_block(&end, validity_bytes(col->size)) : 0;
+        entry->deleted_count = col->deleted_count;
+        entry->deleted_offset = col->deleted != NULL ? place_block(&end, validity_bytes(col->size)) : 0;
+        entry->zones_offset = col->zones != NULL ? place_block(&end, zone_bytes(col->size)) : 0;
+    }
+
+    FILE *file = fopen(temp_path, "wb");
+    int ok = file != NULL;
+    unsigned long long int written = 0;
+    ok = ok && write_block(file, &written, 0, &header, sizeof(header));
+    ok = ok && write_block(file, &written, header.columns_offset, entries,
+                           (unsigned long long int)df->column_count * sizeof(COLUMN_ENTRY));
+    for (unsigned int i = 0; ok && i < df->column_count; i++) {
+        COLUMN *col = df->columns[i];
+        COLUMN_ENTRY *entry = &entries[i];
+        ok = write_block(file, &written, entry->title_offset, col->title, entry->title_length + 1) &&
+             write_block(file, &written, entry->values_offset, col->values, entry->values_bytes) &&
+             write_block(file, &written, entry->strings_offset, col->strings, entry->strings_bytes) &&
+             (!entry->validity_offset ||
+              write_block(file, &written, entry->validity_offset, col->validity, validity_bytes(col->size))) &&
+             (!entry->deleted_offset ||
+              write_block(file, &written, entry->deleted_offset, col->deleted, validity_bytes(col->size))) &&
+             (!entry->zones_offset ||
+              write_block(file, &written, entry->zones_offset, col->zones, zone_bytes(col->size)));
+    }
+    if (file != NULL && fclose(file) != 0) ok = 0;
+#ifdef _WIN32
+    // rename does not replace an existing file there
+    if (ok) remove(path);
+#endif
+    if (ok && rename(temp_path, path) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "Failed to write the dataframe file '%s'.\n", path);
+        remove(temp_path);
+    }
+    free(temp_path);
+    free(entries);
+    return ok ? 0 : -1;
+}
+
+// Tells whether [offset, offset + bytes) lies inside the file
+static int in_file(unsigned long long int offset, unsigned long long int bytes, size_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+// Tells whether the offsets of the valid rows of a STRING entry all point into its string block, and whether
+// that block ends with a NUL, so that no string read from the mapping runs past it
+static int strings_fit(const char *data, const COLUMN_ENTRY *entry) {
+    if (entry->strings_bytes > 0 && data[entry->strings_offset + entry->strings_bytes - 1] != '\0') return 0;
+    const unsigned long long int *offsets = (const unsigned long long int *)(data + entry->values_offset);
+    const unsigned long long int *validity =
+            entry->validity_offset ? (const unsigned long long int *)(data + entry->validity_offset) : NULL;
+    FOR_EACH_SET_BIT(validity, 0, entry->size, i,
+        if (offsets[i] >= entry->strings_bytes) return 0;
+    )
+    return 1;
+}
+
+// Builds a read-only column over the buffers of an entry, NULL if the entry does not fit the file
+static COLUMN *map_column(const char *data, size_t size, const COLUMN_ENTRY *entry, int use_zones) {
+    if (entry->type < NULLVAL || entry->type > STRUCTURE || entry->title_offset == 0 ||
+        !in_file(entry->title_offset, entry->title_length + 1, size) ||
+        data[entry->title_offset + entry->title_length] != '\0') {
+        return NULL;
+    }
+    ENUM_TYPE type = (ENUM_TYPE)entry->type;
+    size_t elem_size = type == STRING ? sizeof(unsigned long long int) : type_size(type);
+    if (entry->values_bytes != (unsigned long long int)entry->size * elem_size ||
+        !in_file(entry->values_offset, entry->values_bytes, size) ||
+        !in_file(entry->strings_offset, entry->strings_bytes, size) ||
+        (entry->validity_offset && !in_file(entry->validity_offset, validity_bytes(entry->size), size)) ||
+        (entry->deleted_offset && !in_file(entry->deleted_offset, validity_bytes(entry->size), size)) ||
+        (entry->deleted_count > 0 && (!entry->deleted_offset || !entry->validity_offset)) ||
+        (entry->zones_offset && !in_file(entry->zones_offset, zone_bytes(entry->size), size)) ||
+        (type == STRING && !strings_fit(data, entry))) {
+        return NULL;
+    }
+
+    COLUMN *col = create_column(type, (char *)data + entry->title_offset);
+    if (!col) return NULL;
+    col->read_only = 1;
+    col->size = entry->size;
+    col->max_size = entry->size;
+    col->values = entry->values_offset ? (void *)(data + entry->values_offset) : NULL;
+    col->strings = entry->strings_offset ? (char *)(data + entry->strings_offset) : NULL;
+    col->strings_size = entry->strings_bytes;
+    col->strings_capacity = entry->strings_bytes;
+    col->validity = entry->validity_offset ? (unsigned long long int *)(data + entry->validity_offset) : NULL;
+    col->deleted = entry->deleted_offset ? (unsigned long long int *)(data + entry->deleted_offset) : NULL;
+    col->deleted_count = entry->deleted_count;
+    col->zones = entry->zones_offset && use_zones ? (ZONE *)(data + entry->zones_offset) : NULL;
+    return col;
+}
+
+// Maps a binary columnar file as a dataframe of read-only columns
+DATAFRAME *open_dataframe(const char *path) {
+    if (!path) {
+        fprintf(stderr, "Invalid arguments for opening a dataframe file.\n");
+        return NULL;
+    }
+    size_t size;
+    const char *data = map_file(path, &size);
+    if (data == NULL) {
+        fprintf(stderr, "Cannot open the dataframe file '%s'.\n", path);
+        return NULL;
+    }
+
+    FILE_HEADER header;
+    if (size < sizeof(header)) {
+        fprintf(stderr, "'%s' is not a dataframe file.\n", path);
+        unmap_file(data, size);
+        return NULL;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, STORAGE_MAGIC, sizeof(STORAGE_MAGIC)) != 0 || header.version != STORAGE_VERSION ||
+        header.byte_order != STORAGE_BYTE_ORDER || header.columns_offset % BUFFER_ALIGNMENT != 0 ||
+        // A dataframe without columns ends with its header, before the aligned offset of the empty column table
+        (header.column_count > 0 && !in_file(header.columns_offset, (unsigned long long int)header.column_count * sizeof(COLUMN_ENTRY), size))) {
+        fprintf(stderr, "'%s' is not a dataframe file of this version and byte order.\n", path);
+        unmap_file(data, size);
+        return NULL;
+    }
+
+    DATAFRAME *df = create_dataframe();
+    if (!df) {
+        unmap_file(data, size);
+        return NULL;
+    }
+    // The dataframe owns the mapping from now on
+    df->mapping = data;
+    df->mapping_size = size;
+    const COLUMN_ENTRY *entries = (const COLUMN_ENTRY *)(data + header.columns_offset);
+    for (unsigned int i = 0; i < header.column_count; i++) {
+        COLUMN *col = map_column(data, size, &entries[i], header.zone_rows == ZONE_ROWS);
+        if (!col || add_column_to_dataframe(df, col) != 0) {
+            if (col) delete_column(&col);
+            fprintf(stderr, "Column %u of '%s' is corrupted.\n", i + 1, path);
+            free_dataframe(df);
+            return NULL;
+        }
+    }
+    return df;
+}
@@ -0,0 +1,22 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "cdataframe.h"
+
+// Binary columnar dataframe files: a header with the column titles and types, then for every column its
+// value buffer, string arena, validity and deletion bitmaps and zone map, each on a BUFFER_ALIGNMENT boundary
+// The file uses the byte order of the machine that wrote it
+
+// Function prototypes for saving and reopening dataframes
+
+// Write the dataframe to path (through a temporary file renamed over it), returns 0 on success and -1 on failure
+// String arenas holding dead bytes are repacked first
+int save_dataframe(DATAFRAME *df, const char *path);
+
+// Map a file written by save_dataframe; returns NULL on failure, a truncated or corrupted file included
+// The columns point into the mapping, so only the offsets of the STRING columns are read on open, to check them
+// against their string block; the rest is read when scanned
+// They are read-only, but can still be sorted and hash-indexed, or removed from the dataframe
+DATAFRAME *open_dataframe(const char *path);
+
+#endif // STORAGE_H
@@ -0,0 +1,22 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Assertions of the unit tests: a failed check is reported and the test goes on, main returns check_status()
+static int check_failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);   \
+            check_failures++;                                                               \
+        }                                                                                   \
+    } while (0)
+
+static int check_status(void) {
+    if (check_failures > 0) fprintf(stderr, "%d check(s) failed\n", check_failures);
+    return check_failures > 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,145 @@
+#include "check.h"
+#include "cdataframe.h"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+static int same_aggregates(const COLUMN_AGGREGATES *a, const COLUMN_AGGREGATES *b) {
+    return memcmp(a, b, sizeof(COLUMN_AGGREGATES)) == 0;
+}
+
+// Exact aggregates of a small column: nulls and deleted rows are left out
+static void test_small(void) {
+    COLUMN *col = create_column(INT, "n");
+    int values[] = {4, -2, 1000, 7, 5, -9, 3};
+    for (unsigned int i = 0; i < 7; i++) {
+        CHECK(insert_value(col, &values[i]));
+        if (i % 3 == 0) CHECK(insert_value(col, NULL));
+    }
+    // Rows: 4 null -2 1000 null 7 5 -9 null 3; 1000 and -9 go
+    CHECK(column_delete_row(col, 3));
+    CHECK(column_delete_row(col, 7));
+    for (int mode = SUM_PLAIN; mode <= SUM_PAIRWISE; mode++) {
+        COLUMN_AGGREGATES aggregates;
+        CHECK(column_aggregate(col, (SUM_MODE)mode, &aggregates));
+        CHECK(aggregates.count == 5);
+        CHECK(aggregates.sum == 17.0 && aggregates.mean == 3.4);
+        CHECK(aggregates.min == -2.0 && aggregates.max == 7.0);
+        // Mean 3.4, squared deviations 0.36 + 29.16 + 12.96 + 2.56 + 0.16 = 45.2
+        CHECK(fabs(aggregates.variance - 45.2 / 5) < 1e-12);
+    }
+    delete_column(&col);
+}
+
+static void test_empty_and_unsupported(void) {
+    COLUMN *col = create_column(DOUBLE, "empty");
+    COLUMN_AGGREGATES aggregates;
+    CHECK(column_aggregate(col, SUM_KAHAN, &aggregates));
+    CHECK(aggregates.count == 0 && aggregates.sum == 0.0);
+    CHECK(isnan(aggregates.mean) && isnan(aggregates.min) && isnan(aggregates.max) && isnan(aggregates.variance));
+    // Only nulls and deleted rows
+    CHECK(insert_value(col, NULL));
+    double value = 1.0;
+    CHECK(insert_value(col, &value));
+    CHECK(column_delete_row(col, 1));
+    CHECK(column_aggregate(col, SUM_PLAIN, &aggregates) && aggregates.count == 0 && isnan(aggregates.mean));
+    delete_column(&col);
+
+    COLUMN *strings = create_column(STRING, "s");
+    CHECK(column_aggregate(strings, SUM_PLAIN, &aggregates) == 0);
+    delete_column(&strings);
+}
+
+// Integer sums are exact whatever the mode, at the limits of the types
+static void test_integer_extremes(void) {
+    COLUMN *ints = create_column(INT, "i");
+    COLUMN *uints = create_column(UINT, "u");
+    for (unsigned int i = 0; i < 1000; i++) {
+        int value = i % 2 == 0 ? INT_MAX : INT_MIN;
+        unsigned int uvalue = UINT_MAX;
+        CHECK(insert_value(ints, &value));
+        CHECK(insert_value(uints, &uvalue));
+    }
+    COLUMN_AGGREGATES aggregates;
+    CHECK(column_aggregate(ints, SUM_PLAIN, &aggregates));
+    CHECK(aggregates.sum == -500.0 && aggregates.min == (double)INT_MIN && aggregates.max == (double)INT_MAX);
+    CHECK(column_aggregate(uints, SUM_PLAIN, &aggregates));
+    CHECK(aggregates.sum == 1000.0 * UINT_MAX && aggregates.variance == 0.0);
+    delete_column(&ints);
+    delete_column(&uints);
+}
+
+// Block sums that a running total loses: one block of 2^54, then thousands of blocks summing to 2.0 each
+static void test_compensated_sums(void) {
+    COLUMN *col = create_column(DOUBLE, "x");
+    double big = ldexp(1.0, 54), small = 2.0 / 64;
+    unsigned int blocks = 4000;
+    for (unsigned int i = 0; i < 64; i++) CHECK(insert_value(col, i == 0 ? &big : &(double){0.0}));
+    for (unsigned int i = 0; i < 64 * blocks; i++) CHECK(insert_value(col, &small));
+    double exact = big + 2.0 * blocks;
+    COLUMN_AGGREGATES plain, kahan, pairwise;
+    CHECK(column_aggregate(col, SUM_PLAIN, &plain));
+    CHECK(column_aggregate(col, SUM_KAHAN, &kahan));
+    CHECK(column_aggregate(col, SUM_PAIRWISE, &pairwise));
+    CHECK(plain.sum != exact);
+    CHECK(kahan.sum == exact);
+    CHECK(fabs(pairwise.sum - exact) < fabs(plain.sum - exact));
+    delete_column(&col);
+}
+
+// The block and segment variances merged with Chan's formula match a two-pass variance on values with an offset,
+// and the result does not depend on the number of threads
+// The offset stays where the running mean, a double, resolves the spread of the block means
+static void test_merged_variance(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *col = add_new_column_to_dataframe(df, DOUBLE, "x");
+    add_new_column_to_dataframe(df, STRING, "label");
+    unsigned int rows = 4 * SEGMENT_ROWS + 1234, seed = 7;
+    for (unsigned int row = 0; row < rows; row++) {
+        seed = seed * 1103515245u + 12345u;
+        double value = 1e4 + (double)(seed >> 8) / (1 << 24) * (row < SEGMENT_ROWS ? 1.0 : 3.0);
+        CHECK(insert_value(col, row % 11 == 0 ? NULL : &value));
+    }
+    for (unsigned int row = 5; row < rows; row += 13) CHECK(column_delete_row(col, row));
+
+    long double sum = 0, squares = 0;
+    unsigned long long int count = 0;
+    for (unsigned int row = 0; row < rows; row++) {
+        double *value = (double *)get_value_at(col, row);
+        if (value == NULL) continue;
+        sum += *value;
+        count++;
+    }
+    long double mean = sum / count;
+    for (unsigned int row = 0; row < rows; row++) {
+        double *value = (double *)get_value_at(col, row);
+        if (value != NULL) squares += (*value - mean) * (*value - mean);
+    }
+    double variance = (double)(squares / count);
+
+    COLUMN_AGGREGATES single;
+    CHECK(column_aggregate(col, SUM_KAHAN, &single));
+    CHECK(single.count == count);
+    CHECK(fabs(single.mean - (double)mean) < 1e-6);
+    CHECK(fabs(single.variance - variance) < 1e-9 * variance);
+
+    COLUMN_AGGREGATES per_column[2];
+    unsigned int thread_counts[] = {1, 4};
+    for (unsigned int t = 0; t < 2; t++) {
+        CHECK(set_dataframe_thread_count(df, thread_counts[t]) == 0);
+        CHECK(dataframe_aggregate(df, SUM_KAHAN, per_column) == 0);
+        CHECK(same_aggregates(&per_column[0], &single));
+        // A column without reduction gets the aggregates of no value
+        CHECK(per_column[1].count == 0 && isnan(per_column[1].mean));
+    }
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_small();
+    test_empty_and_unsupported();
+    test_integer_extremes();
+    test_compensated_sums();
+    test_merged_variance();
+    return check_status();
+}
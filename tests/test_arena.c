@@ -0,0 +1,176 @@
+#include "check.h"
+#include "cdataframe.h"
+#include "arena.h"
+#include "memory.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Fill a buffer with a pattern depending on a seed and the offset, and check it back
+static void fill(void *ptr, size_t size, unsigned int seed) {
+    unsigned char *bytes = (unsigned char *)ptr;
+    for (size_t i = 0; i < size; i++) bytes[i] = (unsigned char)(i * 31 + seed);
+}
+
+static int has_pattern(const void *ptr, size_t size, unsigned int seed) {
+    const unsigned char *bytes = (const unsigned char *)ptr;
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] != (unsigned char)(i * 31 + seed)) return 0;
+    }
+    return 1;
+}
+
+static int is_aligned(const void *ptr) {
+    return (uintptr_t)ptr % BUFFER_ALIGNMENT == 0;
+}
+
+// Growth in place of the last allocation, moves of the others and shrinking
+static void test_realloc(void) {
+    ARENA *arena = arena_create(4096);
+    CHECK(arena_alloc(arena, 0) == NULL);
+
+    char *a = (char *)arena_alloc(arena, 100);
+    CHECK(a != NULL && is_aligned(a));
+    fill(a, 100, 1);
+    // The last allocation grows in place while its block has room
+    CHECK(arena_realloc(arena, a, 100, 500) == a);
+    CHECK(has_pattern(a, 100, 1));
+    fill(a, 500, 1);
+
+    char *b = (char *)arena_alloc(arena, 64);
+    CHECK(b != NULL && is_aligned(b) && b >= a + 500);
+    fill(b, 64, 2);
+    // a is no longer the last allocation: it moves and keeps its bytes, b is left alone
+    char *moved = (char *)arena_realloc(arena, a, 500, 800);
+    CHECK(moved != NULL && moved != a && is_aligned(moved));
+    CHECK(has_pattern(moved, 500, 1));
+    CHECK(has_pattern(b, 64, 2));
+    // Shrinking keeps a buffer in place, the last one or not
+    CHECK(arena_realloc(arena, moved, 800, 200) == moved);
+    CHECK(arena_realloc(arena, b, 64, 32) == b);
+    CHECK(has_pattern(b, 32, 2));
+
+    char *title = arena_strdup(arena, "a column title");
+    CHECK(title != NULL && strcmp(title, "a column title") == 0);
+
+    // Doubling a buffer past the block size, which ends in a dedicated block
+    size_t size = 256;
+    char *c = (char *)arena_alloc(arena, size);
+    fill(c, size, 3);
+    while (size < 64 * 1024) {
+        c = (char *)arena_realloc(arena, c, size, 2 * size);
+        CHECK(c != NULL && is_aligned(c));
+        if (c == NULL) break;
+        CHECK(has_pattern(c, size, 3));
+        size *= 2;
+        fill(c, size, 3);
+    }
+    CHECK(has_pattern(b, 32, 2) && has_pattern(moved, 200, 1));
+    arena_destroy(arena);
+}
+
+// A buffer alone in its dedicated block grows with the block, past MAPPED_BUFFER_SIZE where it is remapped,
+// without leaving a copy behind in the arena
+static void test_dedicated_growth(void) {
+    ARENA *arena = arena_create(4096);
+    char *small = (char *)arena_alloc(arena, 128);
+    fill(small, 128, 4);
+    // Larger than the room left in the block and than a quarter of the next one: a dedicated block
+    size_t size = 5000;
+    char *big = (char *)arena_alloc(arena, size);
+    CHECK(big != NULL && is_aligned(big));
+    fill(big, size, 5);
+    size_t before = arena_memory_usage(arena, NULL);
+
+    while (size < 3 * (size_t)MAPPED_BUFFER_SIZE) {
+        size_t new_size = size + size / 2 + 1000;
+        char *grown = (char *)arena_realloc(arena, big, size, new_size);
+        CHECK(grown != NULL && is_aligned(grown));
+        if (grown == NULL) break;
+        CHECK(has_pattern(grown, size, 5));
+        big = grown;
+        size = new_size;
+        fill(big, size, 5);
+    }
+    // Only the dedicated block grew: the arena holds the new size, not every intermediate copy
+    size_t after = arena_memory_usage(arena, NULL);
+    CHECK(after - before <= size - 5000 + BUFFER_ALIGNMENT);
+    CHECK(has_pattern(small, 128, 4));
+
+    // The small buffer is still the last allocation of the current block and grows in place
+    CHECK(arena_realloc(arena, small, 128, 1024) == small);
+    // Shrinking the big buffer keeps it where it is
+    CHECK(arena_realloc(arena, big, size, 100) == big);
+    CHECK(has_pattern(big, 100, 5));
+    arena_destroy(arena);
+}
+
+// Columns of an arena dataframe grow in turns, each buffer moving past the others, through the arena blocks
+// and past MAPPED_BUFFER_SIZE; the values survive the growth, a deletion and the parallel compaction
+static void test_arena_dataframe(void) {
+    DATAFRAME *df = create_arena_dataframe(64 * 1024);
+    CHECK(df != NULL && df->arena != NULL);
+    if (df == NULL) return;
+    COLUMN *ints = add_new_column_to_dataframe(df, INT, "id");
+    COLUMN *doubles = add_new_column_to_dataframe(df, DOUBLE, "score");
+    COLUMN *names = add_new_column_to_dataframe(df, STRING, "name");
+    CHECK(ints != NULL && doubles != NULL && names != NULL);
+    CHECK(ints->arena == df->arena && names->arena == df->arena);
+
+    unsigned int rows = 400000;
+    char text[32];
+    for (unsigned int row = 0; row < rows; row++) {
+        int id = (int)row;
+        double score = row * 0.5;
+        snprintf(text, sizeof(text), "name %u", row);
+        CHECK(insert_value(ints, &id));
+        CHECK(insert_value(doubles, row % 7 == 0 ? NULL : &score));
+        CHECK(insert_value(names, text));
+    }
+    CHECK(ints->size == rows && (size_t)rows * sizeof(double) > 2 * (size_t)MAPPED_BUFFER_SIZE);
+    CHECK(names->strings_size > (size_t)MAPPED_BUFFER_SIZE);
+
+    unsigned int mismatches = 0;
+    for (unsigned int row = 0; row < rows; row++) {
+        int *id = (int *)get_value_at(ints, row);
+        double *score = (double *)get_value_at(doubles, row);
+        snprintf(text, sizeof(text), "name %u", row);
+        if (id == NULL || *id != (int)row) mismatches++;
+        if (row % 7 == 0 ? score != NULL : (score == NULL || *score != row * 0.5)) mismatches++;
+        if (strcmp((char *)get_value_at(names, row), text) != 0) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // Drop every third row and compact: the columns are rebuilt in the arena from several threads
+    unsigned int num_deleted = 0;
+    unsigned int *deleted = malloc((rows / 3 + 1) * sizeof(unsigned int));
+    for (unsigned int row = 0; row < rows; row += 3) deleted[num_deleted++] = row;
+    CHECK(set_dataframe_thread_count(df, 4) == 0);
+    CHECK(delete_rows_from_dataframe(df, deleted, num_deleted) == 0);
+    CHECK(compact_dataframe(df) == 0);
+    free(deleted);
+    CHECK(ints->size == rows - num_deleted && names->size == rows - num_deleted);
+
+    mismatches = 0;
+    unsigned int kept = 0;
+    for (unsigned int row = 0; row < rows; row++) {
+        if (row % 3 == 0) continue;
+        int *id = (int *)get_value_at(ints, kept);
+        double *score = (double *)get_value_at(doubles, kept);
+        snprintf(text, sizeof(text), "name %u", row);
+        if (id == NULL || *id != (int)row) mismatches++;
+        if (row % 7 == 0 ? score != NULL : (score == NULL || *score != row * 0.5)) mismatches++;
+        if (strcmp((char *)get_value_at(names, kept), text) != 0) mismatches++;
+        kept++;
+    }
+    CHECK(mismatches == 0);
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_realloc();
+    test_dedicated_growth();
+    test_arena_dataframe();
+    return check_status();
+}
@@ -0,0 +1,264 @@
+#include "check.h"
+#include "csv.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_FILE "test_csv.csv"
+#define MESSAGES_FILE "test_csv.err"
+
+static void write_text(const char *path, const char *text) {
+    FILE *file = fopen(path, "wb");
+    CHECK(file != NULL);
+    if (file == NULL) return;
+    fputs(text, file);
+    fclose(file);
+}
+
+// Read a CSV text with read_csv, keeping what it reports on stderr in messages
+static DATAFRAME *read_text(const char *text, const CSV_OPTIONS *options, char *messages, size_t size) {
+    write_text(TEST_FILE, text);
+    fflush(stderr);
+    int saved = dup(2);
+    FILE *capture = fopen(MESSAGES_FILE, "w+");
+    if (capture != NULL) dup2(fileno(capture), 2);
+    DATAFRAME *df = read_csv(TEST_FILE, options);
+    fflush(stderr);
+    dup2(saved, 2);
+    close(saved);
+    messages[0] = '\0';
+    if (capture != NULL) {
+        rewind(capture);
+        size_t length = fread(messages, 1, size - 1, capture);
+        messages[length] = '\0';
+        fclose(capture);
+    }
+    return df;
+}
+
+static int same_string(COLUMN *col, unsigned int row, const char *expected) {
+    char *value = (char *)get_value_at(col, row);
+    return expected == NULL ? value == NULL : value != NULL && strcmp(value, expected) == 0;
+}
+
+// Every type written by write_csv comes back from read_csv with the same values and nulls
+static void test_round_trip(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *ints = add_new_column_to_dataframe(df, INT, "int, signed");
+    COLUMN *uints = add_new_column_to_dataframe(df, UINT, "uint");
+    COLUMN *doubles = add_new_column_to_dataframe(df, DOUBLE, "\"double\"");
+    COLUMN *floats = add_new_column_to_dataframe(df, FLOAT, "float");
+    COLUMN *chars = add_new_column_to_dataframe(df, CHAR, "char");
+    COLUMN *strings = add_new_column_to_dataframe(df, STRING, "string");
+    int int_values[] = {INT_MIN, -1, 0, INT_MAX, 42, 7};
+    unsigned int uint_values[] = {0, 1, UINT_MAX, 123456789, 5, 6};
+    double double_values[] = {0.1, -0.0, 1e-300, -1.7976931348623157e308, INFINITY, 1.0 / 3.0};
+    float float_values[] = {0.1f, -3.4028235e38f, 1e-45f, 2.5f, -INFINITY, 1.0f / 3.0f};
+    char char_values[] = {'a', ',', '"', ' ', 'z', 'q'};
+    char *string_values[] = {"plain", "with, comma", "with \"quotes\"", "", " spaced ", "carriage\rreturn"};
+    for (unsigned int i = 0; i < 6; i++) {
+        CHECK(insert_value(ints, &int_values[i]));
+        CHECK(insert_value(uints, i == 4 ? NULL : &uint_values[i]));
+        CHECK(insert_value(doubles, &double_values[i]));
+        CHECK(insert_value(floats, &float_values[i]));
+        CHECK(insert_value(chars, &char_values[i]));
+        CHECK(insert_value(strings, i == 1 ? NULL : string_values[i]));
+    }
+    // A deleted row is not written, a shorter column gives empty fields
+    for (unsigned int c = 0; c < 6; c++) CHECK(column_delete_row(df->columns[c], 5));
+    int extra = 99;
+    CHECK(insert_value(ints, &extra));
+
+    CHECK(write_csv(df, TEST_FILE, NULL) == 0);
+    CSV_OPTIONS options;
+    csv_default_options(&options);
+    const char *types[] = {"INT", "UINT", "DOUBLE", "FLOAT", "CHAR", "STRING"};
+    options.types = types;
+    options.num_types = 6;
+    DATAFRAME *read = read_csv(TEST_FILE, &options);
+    CHECK(read != NULL && read->column_count == 6);
+    if (read != NULL) {
+        for (unsigned int c = 0; c < 6; c++) {
+            CHECK(strcmp(read->columns[c]->title, df->columns[c]->title) == 0);
+            CHECK(read->columns[c]->size == 6);
+        }
+        COLUMN *r_ints = read->columns[0], *r_uints = read->columns[1], *r_doubles = read->columns[2];
+        COLUMN *r_floats = read->columns[3], *r_chars = read->columns[4], *r_strings = read->columns[5];
+        for (unsigned int i = 0; i < 5; i++) {
+            CHECK(*(int *)get_value_at(r_ints, i) == int_values[i]);
+            CHECK(i == 4 ? is_null_at(r_uints, i) : *(unsigned int *)get_value_at(r_uints, i) == uint_values[i]);
+            double d = *(double *)get_value_at(r_doubles, i);
+            CHECK(d == double_values[i] && signbit(d) == signbit(double_values[i]));
+            CHECK(*(float *)get_value_at(r_floats, i) == float_values[i]);
+            CHECK(*(char *)get_value_at(r_chars, i) == char_values[i]);
+            CHECK(same_string(r_strings, i, i == 1 ? NULL : string_values[i]));
+        }
+        // The row after the deleted one only has its INT cell
+        CHECK(*(int *)get_value_at(r_ints, 5) == 99);
+        for (unsigned int c = 1; c < 6; c++) CHECK(is_null_at(read->columns[c], 5));
+        free_dataframe(read);
+    }
+    free_dataframe(df);
+}
+
+// A text holding a line break cannot be read back as one field, so it is refused
+static void test_line_breaks_refused(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *strings = add_new_column_to_dataframe(df, STRING, "text");
+    CHECK(insert_value(strings, "one line"));
+    CHECK(insert_value(strings, "two\nlines"));
+    CHECK(write_csv(df, TEST_FILE, NULL) == -1);
+    CHECK(set_value_at(strings, 1, "two\r\nlines"));
+    CHECK(write_csv(df, TEST_FILE, NULL) == -1);
+    CHECK(set_value_at(strings, 1, "fine"));
+    CHECK(write_csv(df, TEST_FILE, NULL) == 0);
+    rename_column_title(df, 0, "multi\nline title");
+    CHECK(write_csv(df, TEST_FILE, NULL) == -1);
+    free_dataframe(df);
+}
+
+// Quoting, doubled quotes, CRLF, blank lines and missing trailing fields
+static void test_fields(void) {
+    char messages[512];
+    DATAFRAME *df = read_text("name,comment,n\r\n"
+                              "\"a,b\",\"say \"\"hi\"\"\",1\r\n"
+                              "\r\n"
+                              "plain,,2\r\n"
+                              "\"\",x\r\n"
+                              "last,\"quoted\"\r\n", NULL, messages, sizeof(messages));
+    CHECK(df != NULL && df->column_count == 3);
+    if (df != NULL) {
+        CHECK(strcmp(df->columns[2]->title, "n") == 0);
+        COLUMN *names = df->columns[0], *comments = df->columns[1], *numbers = df->columns[2];
+        CHECK(names->size == 4 && numbers->column_type == INT);
+        CHECK(same_string(names, 0, "a,b") && same_string(comments, 0, "say \"hi\""));
+        CHECK(same_string(names, 1, "plain") && same_string(comments, 1, NULL));
+        // A quoted empty field is an empty string, an unquoted one a null
+        CHECK(same_string(names, 2, "") && same_string(comments, 2, "x") && is_null_at(numbers, 2));
+        CHECK(same_string(comments, 3, "quoted") && is_null_at(numbers, 3));
+        CHECK(*(int *)get_value_at(numbers, 1) == 2);
+        free_dataframe(df);
+    }
+    CHECK(messages[0] == '\0');
+}
+
+// Types are inferred from the sample, INT widening to DOUBLE and anything else to STRING
+static void test_type_inference(void) {
+    char messages[512];
+    DATAFRAME *df = read_text("i,d,s,e,m\n1,2,x,,-3\n-4,2.5,7,,\n5,1e3,y,,8\n", NULL, messages, sizeof(messages));
+    CHECK(df != NULL && df->column_count == 5);
+    if (df != NULL) {
+        ENUM_TYPE expected[] = {INT, DOUBLE, STRING, STRING, INT};
+        for (unsigned int c = 0; c < 5; c++) CHECK(df->columns[c]->column_type == expected[c]);
+        CHECK(*(double *)get_value_at(df->columns[1], 2) == 1000.0);
+        CHECK(same_string(df->columns[2], 1, "7"));
+        CHECK(count_nulls(df->columns[3]) == 3 && is_null_at(df->columns[4], 1));
+        free_dataframe(df);
+    }
+
+    // A value past the sample that does not parse is stored as a null and reported
+    CSV_OPTIONS options;
+    csv_default_options(&options);
+    options.sample_rows = 1;
+    df = read_text("n\n1\nabc\n3\n", &options, messages, sizeof(messages));
+    CHECK(df != NULL && df->columns[0]->column_type == INT && df->columns[0]->size == 3);
+    if (df != NULL) {
+        CHECK(is_null_at(df->columns[0], 1) && *(int *)get_value_at(df->columns[0], 2) == 3);
+        free_dataframe(df);
+    }
+    CHECK(strstr(messages, "1 CSV values did not match") != NULL);
+}
+
+// Given types, bad values, rows with extra fields, no header and another delimiter
+static void test_options(void) {
+    char messages[512];
+    CSV_OPTIONS options;
+    csv_default_options(&options);
+    const char *types[] = {"UINT", NULL, "CHAR"};
+    options.types = types;
+    options.num_types = 3;
+    options.delimiter = ';';
+    options.has_header = 0;
+    DATAFRAME *df = read_text("1;a;x\n-2;b;yy\n3;c;z;extra\n4;d;w;more;fields\n", &options, messages, sizeof(messages));
+    CHECK(df != NULL && df->column_count == 3);
+    if (df != NULL) {
+        CHECK(strcmp(df->columns[0]->title, "Column 1") == 0);
+        CHECK(df->columns[0]->column_type == UINT && df->columns[1]->column_type == STRING);
+        CHECK(df->columns[0]->size == 4);
+        // -2 is no UINT and "yy" no CHAR
+        CHECK(is_null_at(df->columns[0], 1) && is_null_at(df->columns[2], 1));
+        CHECK(*(char *)get_value_at(df->columns[2], 3) == 'w');
+        free_dataframe(df);
+    }
+    CHECK(strstr(messages, "2 CSV values did not match") != NULL);
+    CHECK(strstr(messages, "2 CSV rows had more fields than the 3 columns") != NULL);
+
+    options.types = (const char *[]){"BOOL"};
+    options.num_types = 1;
+    CHECK(read_text("1\n", &options, messages, sizeof(messages)) == NULL);
+    CHECK(read_csv("no-such-file.csv", NULL) == NULL);
+
+    df = read_text("", NULL, messages, sizeof(messages));
+    CHECK(df != NULL && df->column_count == 0);
+    free_dataframe(df);
+    df = read_text("a,b\n", NULL, messages, sizeof(messages));
+    CHECK(df != NULL && df->column_count == 2 && df->columns[0]->size == 0);
+    free_dataframe(df);
+}
+
+// A file of several MiB is parsed in chunks, whose rows must come back in file order
+static void test_chunks(int use_arena) {
+    unsigned int rows = 300000;
+    size_t capacity = (size_t)rows * 40 + 64;
+    char *text = (char *)malloc(capacity);
+    size_t length = (size_t)snprintf(text, capacity, "id,value,label\n");
+    for (unsigned int row = 0; row < rows; row++) {
+        if (row % 1000 == 999) {
+            length += (size_t)snprintf(text + length, capacity - length, "%u,,\"row, %u\"\n", row, row);
+        } else {
+            length += (size_t)snprintf(text + length, capacity - length, "%u,%u.5,row %u\n", row, row % 977, row);
+        }
+    }
+    char messages[512];
+    CSV_OPTIONS options;
+    csv_default_options(&options);
+    options.use_arena = use_arena;
+    DATAFRAME *df = read_text(text, &options, messages, sizeof(messages));
+    free(text);
+    CHECK(df != NULL && df->column_count == 3);
+    if (df == NULL) return;
+    CHECK(use_arena ? df->arena != NULL : df->arena == NULL);
+    COLUMN *ids = df->columns[0], *values = df->columns[1], *labels = df->columns[2];
+    CHECK(ids->size == rows && values->column_type == DOUBLE);
+    unsigned int mismatches = 0;
+    char label[32];
+    for (unsigned int row = 0; row < rows && row < ids->size; row++) {
+        if (*(int *)get_value_at(ids, row) != (int)row) mismatches++;
+        if (row % 1000 == 999) {
+            snprintf(label, sizeof(label), "row, %u", row);
+            if (!is_null_at(values, row)) mismatches++;
+        } else {
+            snprintf(label, sizeof(label), "row %u", row);
+            if (*(double *)get_value_at(values, row) != row % 977 + 0.5) mismatches++;
+        }
+        if (!same_string(labels, row, label)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(count_nulls(values) == (int)(rows / 1000));
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_round_trip();
+    test_line_breaks_refused();
+    test_fields();
+    test_type_inference();
+    test_options();
+    test_chunks(0);
+    test_chunks(1);
+    remove(TEST_FILE);
+    remove(MESSAGES_FILE);
+    return check_status();
+}
@@ -0,0 +1,203 @@
+#include "check.h"
+#include "cdataframe.h"
+#include "hashindex.h"
+#include "sort.h"
+#include "zonemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expected contents of an INT column: one cell per row, with its value, null and deleted flags
+typedef struct model_cell {
+    int value;
+    int null;
+    int deleted;
+} MODEL_CELL;
+
+typedef struct model {
+    MODEL_CELL *cells;
+    unsigned int size;
+} MODEL;
+
+// Check a column against the model, cell by cell and through the counts (zone maps, hash index)
+static void check_model(COLUMN *col, const MODEL *model) {
+    CHECK(col->size == model->size);
+    unsigned int mismatches = 0, nulls = 0, deleted = 0;
+    for (unsigned int row = 0; row < model->size && row < col->size; row++) {
+        const MODEL_CELL *cell = &model->cells[row];
+        int *value = (int *)get_value_at(col, row);
+        if (is_deleted_at(col, row) != cell->deleted) mismatches++;
+        if (cell->null || cell->deleted ? value != NULL : value == NULL || *value != cell->value) mismatches++;
+        nulls += (unsigned int)(cell->null && !cell->deleted);
+        deleted += (unsigned int)cell->deleted;
+    }
+    CHECK(mismatches == 0);
+    CHECK(count_nulls(col) == (int)nulls);
+    CHECK(col->deleted_count == deleted);
+
+    int pivots[] = {-1, 0, 150, 409, 410, 1000, 5000};
+    for (unsigned int p = 0; p < sizeof(pivots) / sizeof(pivots[0]); p++) {
+        unsigned long long int less = 0, equal = 0, greater = 0;
+        for (unsigned int row = 0; row < model->size; row++) {
+            const MODEL_CELL *cell = &model->cells[row];
+            if (cell->null || cell->deleted) continue;
+            if (cell->value < pivots[p]) less++; else if (cell->value > pivots[p]) greater++; else equal++;
+        }
+        COMPARE_COUNTS counts;
+        count_compare(col, &pivots[p], &counts);
+        CHECK(counts.less == less && counts.equal == equal && counts.greater == greater);
+        CHECK(count_occurrences(col, &pivots[p]) == (int)equal);
+        unsigned long long int hashed;
+        if (col->hash_index != NULL) CHECK(hash_index_count(col, &pivots[p], &hashed) && hashed == equal);
+    }
+}
+
+// Remove the deleted cells of the model, like column_compact
+static void compact_model(MODEL *model) {
+    unsigned int kept = 0;
+    for (unsigned int row = 0; row < model->size; row++) {
+        if (!model->cells[row].deleted) model->cells[kept++] = model->cells[row];
+    }
+    model->size = kept;
+}
+
+static void delete_both(COLUMN *col, MODEL *model, unsigned int row) {
+    CHECK(column_delete_row(col, row));
+    model->cells[row].deleted = 1;
+}
+
+// Deleted rows leave the zone maps, the hash index and the sorted index, compaction renumbers the others
+static void test_column_delete_and_compact(void) {
+    COLUMN *col = create_column(INT, "n");
+    MODEL model = {(MODEL_CELL *)calloc(20000, sizeof(MODEL_CELL)), 0};
+    for (unsigned int row = 0; row < 20000; row++) {
+        MODEL_CELL cell = {(int)(row / 10), row % 17 == 0, 0};
+        CHECK(insert_value(col, cell.null ? NULL : &cell.value));
+        model.cells[model.size++] = cell;
+    }
+    CHECK(build_hash_index(col));
+    CHECK(sort_column(col, ASC));
+    check_model(col, &model);
+
+    for (unsigned int row = 0; row < 20000; row += 7) delete_both(col, &model, row);
+    // A whole zone block goes
+    for (unsigned int row = ZONE_ROWS; row < 2 * ZONE_ROWS; row++) delete_both(col, &model, row);
+    CHECK(col->valid_index == 0);
+    check_model(col, &model);
+
+    // Deleting twice changes nothing, rows past the end and deleted cells cannot be changed
+    unsigned int deleted = col->deleted_count;
+    CHECK(column_delete_row(col, 7) == 1 && col->deleted_count == deleted);
+    CHECK(column_delete_row(col, 20000) == 0);
+    int value = 3;
+    CHECK(set_value_at(col, 14, &value) == 0);
+    CHECK(is_null_at(col, 14));
+
+    // Removing a deleted last row also forgets its deletion
+    delete_both(col, &model, 19999);
+    CHECK(remove_last_value(col));
+    model.size--;
+    check_model(col, &model);
+
+    CHECK(column_compact(col));
+    compact_model(&model);
+    CHECK(col->deleted == NULL && col->deleted_count == 0);
+    check_model(col, &model);
+
+    // Appends after compaction land after the renumbered rows
+    value = 409;
+    CHECK(insert_value(col, &value));
+    model.cells[model.size++] = (MODEL_CELL){409, 0, 0};
+    check_model(col, &model);
+
+    // Compaction of a column without deleted rows, or without rows, keeps it as it is
+    CHECK(column_compact(col));
+    check_model(col, &model);
+    COLUMN *empty = create_column(INT, "empty");
+    CHECK(column_compact(empty) && empty->size == 0);
+    delete_column(&empty);
+    free(model.cells);
+    delete_column(&col);
+}
+
+// Deleted strings count as dead bytes until compaction repacks the arena
+static void test_strings_dead(void) {
+    COLUMN *col = create_column(STRING, "s");
+    char text[32];
+    size_t live_bytes = 0, dead_bytes = 0;
+    for (unsigned int row = 0; row < 1000; row++) {
+        snprintf(text, sizeof(text), "value %u", row);
+        CHECK(insert_value(col, text));
+        if (row % 3 == 0) {
+            dead_bytes += strlen(text) + 1;
+        } else {
+            live_bytes += strlen(text) + 1;
+        }
+    }
+    for (unsigned int row = 0; row < 1000; row += 3) CHECK(column_delete_row(col, row));
+    CHECK(col->strings_dead == dead_bytes);
+    CHECK(col->strings_size == live_bytes + dead_bytes);
+
+    CHECK(column_compact(col));
+    CHECK(col->size == 666 && col->strings_dead == 0 && col->strings_size == live_bytes);
+    unsigned int mismatches = 0;
+    for (unsigned int row = 0; row < col->size; row++) {
+        unsigned int original = row / 2 * 3 + 1 + row % 2;
+        snprintf(text, sizeof(text), "value %u", original);
+        char *value = (char *)get_value_at(col, row);
+        if (value == NULL || strcmp(value, text) != 0) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // Overwritten and nulled strings are dead too, and compaction repacks them without deleted rows
+    CHECK(set_value_at(col, 0, "a much longer value than before"));
+    CHECK(set_value_at(col, 1, NULL));
+    CHECK(col->strings_dead > 0);
+    CHECK(column_compact(col));
+    CHECK(col->strings_dead == 0 && col->size == 666);
+    CHECK(strcmp((char *)get_value_at(col, 0), "a much longer value than before") == 0 && is_null_at(col, 1));
+    CHECK(strcmp((char *)get_value_at(col, 665), "value 998") == 0);
+    delete_column(&col);
+}
+
+// Dataframe deletions check every row first, then mark them in every column
+static void test_dataframe(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *ids = add_new_column_to_dataframe(df, INT, "id");
+    COLUMN *names = add_new_column_to_dataframe(df, STRING, "name");
+    char text[32];
+    for (int row = 0; row < 100; row++) {
+        snprintf(text, sizeof(text), "name %d", row);
+        CHECK(insert_value(ids, &row));
+        CHECK(insert_value(names, text));
+    }
+    CHECK(delete_rows_from_dataframe(df, (unsigned int[]){5, 1, 5}, 3) == 0);
+    CHECK(ids->deleted_count == 2 && names->deleted_count == 2);
+    CHECK(delete_rows_from_dataframe(df, (unsigned int[]){9, 100}, 2) == -1);
+    CHECK(!is_deleted_at(ids, 9) && !is_deleted_at(names, 9));
+    CHECK(delete_rows_from_dataframe(df, NULL, 0) == 0);
+
+    CHECK(compact_dataframe(df) == 0);
+    CHECK(ids->size == 98 && names->size == 98 && ids->deleted_count == 0);
+    CHECK(*(int *)get_value_at(ids, 1) == 2 && *(int *)get_value_at(ids, 4) == 6);
+    CHECK(strcmp((char *)get_value_at(names, 4), "name 6") == 0);
+
+    // Past the threshold the dataframe compacts itself
+    df->auto_compact_percent = 25;
+    unsigned int rows[25];
+    for (unsigned int k = 0; k < 25; k++) rows[k] = k * 4;
+    CHECK(delete_rows_from_dataframe(df, rows, 23) == 0);
+    CHECK(ids->deleted_count == 23 && ids->size == 98);
+    CHECK(delete_rows_from_dataframe(df, rows + 23, 2) == 0);
+    CHECK(ids->deleted_count == 0 && ids->size == 73 && names->size == 73);
+    CHECK(names->strings_dead == 0);
+    CHECK(*(int *)get_value_at(ids, 0) == 2 && strcmp((char *)get_value_at(names, 0), "name 2") == 0);
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_column_delete_and_compact();
+    test_strings_dead();
+    test_dataframe();
+    return check_status();
+}
@@ -0,0 +1,177 @@
+#include "check.h"
+#include "filter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROWS (2 * SEGMENT_ROWS + 777)
+
+static const FILTER_OP all_ops[] = {FILTER_LT, FILTER_LE, FILTER_EQ, FILTER_NE, FILTER_GE, FILTER_GT, FILTER_BETWEEN};
+
+// IEEE 754 comparison of a value with the pivot, as the filters do it
+static int passes(FILTER_OP op, double value, double pivot, double high) {
+    switch (op) {
+        case FILTER_LT: return value < pivot;
+        case FILTER_LE: return value <= pivot;
+        case FILTER_EQ: return value == pivot;
+        case FILTER_NE: return value != pivot;
+        case FILTER_GE: return value >= pivot;
+        case FILTER_GT: return value > pivot;
+        case FILTER_BETWEEN: return pivot <= value && value <= high;
+    }
+    return 0;
+}
+
+static int is_selected(const SELECTION *sel, unsigned int row) {
+    return (int)((sel->bits[row / 64] >> (row % 64)) & 1);
+}
+
+// Compare the selection of every operator with a row by row evaluation
+static void check_filters(COLUMN *col, double pivot, double high) {
+    for (unsigned int o = 0; o < sizeof(all_ops) / sizeof(all_ops[0]); o++) {
+        FILTER_OP op = all_ops[o];
+        COL_TYPE typed_pivot, typed_high;
+        if (col->column_type == INT) {
+            typed_pivot.int_value = (int)pivot;
+            typed_high.int_value = (int)high;
+        } else {
+            typed_pivot.double_value = pivot;
+            typed_high.double_value = high;
+        }
+        SELECTION *sel = column_filter(col, op, &typed_pivot, &typed_high);
+        CHECK(sel != NULL);
+        if (sel == NULL) continue;
+        CHECK(sel->rows == col->size);
+        unsigned int expected_count = 0, mismatches = 0;
+        for (unsigned int row = 0; row < col->size; row++) {
+            void *value = get_value_at(col, row);
+            int expected = 0;
+            if (value != NULL) {
+                double number = col->column_type == INT ? *(int *)value : *(double *)value;
+                expected = passes(op, number, pivot, high);
+            }
+            expected_count += (unsigned int)expected;
+            if (is_selected(sel, row) != expected) mismatches++;
+        }
+        CHECK(mismatches == 0);
+        CHECK(sel->count == expected_count);
+        free_selection(&sel);
+        CHECK(sel == NULL);
+    }
+}
+
+// NaN values only pass FILTER_NE, a NaN pivot lets every non-null row pass FILTER_NE and nothing else
+static void test_nan(void) {
+    COLUMN *col = create_column(DOUBLE, "x");
+    for (unsigned int row = 0; row < ROWS; row++) {
+        double value = row % 17 == 0 ? NAN : (double)(row % 1000) - 500.0;
+        if (row % 29 == 0) {
+            CHECK(insert_value(col, NULL));
+        } else {
+            CHECK(insert_value(col, &value));
+        }
+    }
+    for (unsigned int row = 5; row < ROWS; row += 41) CHECK(column_delete_row(col, row));
+    check_filters(col, 10.0, 250.0);
+    check_filters(col, -500.0, -500.0);
+    check_filters(col, NAN, 100.0);
+    check_filters(col, -100.0, NAN);
+
+    double nan = NAN;
+    SELECTION *sel = column_filter(col, FILTER_NE, &nan, NULL);
+    CHECK(sel != NULL && sel->count == col->size - (unsigned int)count_nulls(col) - col->deleted_count);
+    free_selection(&sel);
+    delete_column(&col);
+}
+
+// Increasing values so that the zone maps rule whole blocks in or out
+static void test_zone_blocks(void) {
+    COLUMN *col = create_column(INT, "n");
+    for (unsigned int row = 0; row < ROWS; row++) {
+        int value = (int)(row / 100);
+        CHECK(insert_value(col, row % 1000 == 999 ? NULL : &value));
+    }
+    for (unsigned int row = 0; row < ROWS; row += 5003) CHECK(column_delete_row(col, row));
+    check_filters(col, 700.0, 900.0);
+    check_filters(col, -1.0, 0.0);
+    check_filters(col, 1e6, 2e6);
+    delete_column(&col);
+}
+
+static void test_empty_and_invalid(void) {
+    COLUMN *col = create_column(INT, "empty");
+    int pivot = 3;
+    SELECTION *sel = column_filter(col, FILTER_GE, &pivot, NULL);
+    CHECK(sel != NULL && sel->rows == 0 && sel->count == 0);
+    free_selection(&sel);
+    CHECK(column_filter(col, FILTER_BETWEEN, &pivot, NULL) == NULL);
+    CHECK(column_filter(col, FILTER_EQ, NULL, NULL) == NULL);
+    delete_column(&col);
+}
+
+// Combined selections gathered into a new dataframe, nulls and strings included
+static void test_dataframe_filter(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *ids = add_new_column_to_dataframe(df, INT, "id");
+    COLUMN *names = add_new_column_to_dataframe(df, STRING, "name");
+    COLUMN *scores = add_new_column_to_dataframe(df, DOUBLE, "score");
+    char *name_values[] = {"ann", "bob", NULL, "dee", "eve", "fay"};
+    double score_values[] = {9.5, 3.0, 7.25, NAN, 8.0, 1.0};
+    for (int i = 0; i < 6; i++) {
+        CHECK(insert_value(ids, &i));
+        CHECK(insert_value(names, name_values[i]));
+        CHECK(insert_value(scores, i == 5 ? NULL : &score_values[i]));
+    }
+    for (unsigned int c = 0; c < 3; c++) CHECK(column_delete_row(df->columns[c], 4));
+
+    double low = 5.0;
+    int max_id = 3;
+    SELECTION *high_scores = column_filter(scores, FILTER_GE, &low, NULL);
+    SELECTION *first_ids = column_filter(ids, FILTER_LE, &max_id, NULL);
+    CHECK(high_scores != NULL && high_scores->count == 2);
+    CHECK(first_ids != NULL && first_ids->count == 4);
+    SELECTION *either = column_filter(scores, FILTER_GE, &low, NULL);
+    CHECK(selection_or(either, first_ids) == 1 && either->count == 4);
+    CHECK(selection_and(high_scores, first_ids) == 1 && high_scores->count == 2);
+
+    unsigned int rows[4];
+    CHECK(selection_to_rows(high_scores, rows) == 2 && rows[0] == 0 && rows[1] == 2);
+
+    DATAFRAME *result = dataframe_filter(df, high_scores);
+    CHECK(result != NULL && result->column_count == 3);
+    if (result != NULL) {
+        CHECK(strcmp(result->columns[1]->title, "name") == 0);
+        CHECK(result->columns[0]->size == 2);
+        CHECK(*(int *)get_value_at(result->columns[0], 1) == 2);
+        CHECK(strcmp((char *)get_value_at(result->columns[1], 0), "ann") == 0);
+        CHECK(is_null_at(result->columns[1], 1));
+        CHECK(*(double *)get_value_at(result->columns[2], 1) == 7.25);
+        free_dataframe(result);
+    }
+
+    // Selections over a different number of rows cannot be combined, an empty selection gives empty columns
+    COLUMN *other = create_column(INT, "other");
+    SELECTION *none = column_filter(other, FILTER_EQ, &max_id, NULL);
+    CHECK(selection_and(either, none) == 0);
+    result = dataframe_filter(df, none);
+    CHECK(result != NULL && result->column_count == 3);
+    if (result != NULL) {
+        for (unsigned int c = 0; c < 3; c++) CHECK(result->columns[c]->size == 0);
+    }
+    free_dataframe(result);
+
+    free_selection(&none);
+    delete_column(&other);
+    free_selection(&either);
+    free_selection(&first_ids);
+    free_selection(&high_scores);
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_nan();
+    test_zone_blocks();
+    test_empty_and_invalid();
+    test_dataframe_filter();
+    return check_status();
+}
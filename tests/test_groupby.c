@@ -0,0 +1,189 @@
+#include "check.h"
+#include "groupby.h"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+// Rows spread over several segments so that the per-worker tables are merged
+#define ROWS (3 * SEGMENT_ROWS + 5000)
+#define KEYS 110  // Keys 97..109 only appear in the last segment
+#define NULL_GROUP KEYS
+
+// Expected aggregates of one group
+typedef struct expected_group {
+    unsigned int first_row;  // UINT_MAX while the group has no row
+    unsigned int rows;
+    unsigned int count;
+    double sum;
+    int min;
+    int max;
+} EXPECTED_GROUP;
+
+static int key_of(unsigned int row) {
+    return row < 3 * SEGMENT_ROWS ? (int)(row % 97) : 97 + (int)(row % 13);
+}
+
+static int key_is_null(unsigned int row) {
+    return row % 101 == 0;
+}
+
+static int value_of(unsigned int row) {
+    return (int)((row * 31u) % 1000u) - 500;
+}
+
+static int value_is_null(unsigned int row) {
+    return row % 37 == 0;
+}
+
+static int row_is_deleted(unsigned int row) {
+    return row % 53 == 0;
+}
+
+static DATAFRAME *build_dataframe(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *keys = add_new_column_to_dataframe(df, INT, "key");
+    COLUMN *values = add_new_column_to_dataframe(df, INT, "price");
+    for (unsigned int row = 0; row < ROWS; row++) {
+        int key = key_of(row), value = value_of(row);
+        CHECK(insert_value(keys, key_is_null(row) ? NULL : &key));
+        CHECK(insert_value(values, value_is_null(row) ? NULL : &value));
+    }
+    for (unsigned int row = 0; row < ROWS; row += 53) {
+        CHECK(column_delete_row(keys, row));
+        CHECK(column_delete_row(values, row));
+    }
+    return df;
+}
+
+// Check the result of grouping the test dataframe against aggregates computed row by row
+static void check_grouped(DATAFRAME *df) {
+    static EXPECTED_GROUP expected[KEYS + 1];
+    for (unsigned int g = 0; g <= KEYS; g++) {
+        expected[g] = (EXPECTED_GROUP){UINT_MAX, 0, 0, 0.0, INT_MAX, INT_MIN};
+    }
+    unsigned int groups = 0;
+    for (unsigned int row = 0; row < ROWS; row++) {
+        if (row_is_deleted(row)) continue;
+        EXPECTED_GROUP *group = &expected[key_is_null(row) ? NULL_GROUP : key_of(row)];
+        if (group->first_row == UINT_MAX) {
+            group->first_row = row;
+            groups++;
+        }
+        group->rows++;
+        if (value_is_null(row)) continue;
+        int value = value_of(row);
+        group->count++;
+        group->sum += value;
+        if (value < group->min) group->min = value;
+        if (value > group->max) group->max = value;
+    }
+
+    AGGREGATION aggregations[] = {{1, AGG_COUNT}, {1, AGG_SUM}, {1, AGG_MIN}, {1, AGG_MAX}, {1, AGG_MEAN}, {0, AGG_COUNT}};
+    DATAFRAME *result = dataframe_group_by(df, (unsigned int[]){0}, 1, aggregations, 6);
+    CHECK(result != NULL);
+    if (result == NULL) return;
+    CHECK(result->column_count == 7);
+    CHECK(strcmp(result->columns[0]->title, "key") == 0);
+    CHECK(strcmp(result->columns[2]->title, "sum(price)") == 0);
+    CHECK(result->columns[3]->column_type == INT && result->columns[5]->column_type == DOUBLE);
+    CHECK(result->columns[0]->size == groups);
+
+    unsigned int previous_first_row = 0;
+    for (unsigned int r = 0; r < result->columns[0]->size; r++) {
+        int *key = (int *)get_value_at(result->columns[0], r);
+        const EXPECTED_GROUP *group = &expected[key == NULL ? NULL_GROUP : *key];
+        // Groups come in order of first appearance
+        CHECK(r == 0 || group->first_row > previous_first_row);
+        previous_first_row = group->first_row;
+        CHECK(*(unsigned int *)get_value_at(result->columns[1], r) == group->count);
+        CHECK(*(double *)get_value_at(result->columns[2], r) == group->sum);
+        CHECK(*(int *)get_value_at(result->columns[3], r) == group->min);
+        CHECK(*(int *)get_value_at(result->columns[4], r) == group->max);
+        CHECK(fabs(*(double *)get_value_at(result->columns[5], r) - group->sum / group->count) < 1e-9);
+        // Null keys are not counted as values of the key column
+        CHECK(*(unsigned int *)get_value_at(result->columns[6], r) == (key == NULL ? 0 : group->rows));
+    }
+    free_dataframe(result);
+}
+
+// The same groups whatever the number of workers merging their tables
+static void test_merged_workers(void) {
+    DATAFRAME *df = build_dataframe();
+    unsigned int thread_counts[] = {1, 4};
+    for (unsigned int t = 0; t < 2; t++) {
+        CHECK(set_dataframe_thread_count(df, thread_counts[t]) == 0);
+        check_grouped(df);
+    }
+    free_dataframe(df);
+}
+
+static void test_empty(void) {
+    DATAFRAME *df = create_dataframe();
+    add_new_column_to_dataframe(df, STRING, "name");
+    add_new_column_to_dataframe(df, DOUBLE, "score");
+    AGGREGATION sum = {1, AGG_SUM};
+    DATAFRAME *result = dataframe_group_by(df, (unsigned int[]){0}, 1, &sum, 1);
+    CHECK(result != NULL && result->column_count == 2 && result->columns[0]->size == 0);
+    free_dataframe(result);
+    // Non-numeric aggregates and missing keys are refused
+    CHECK(dataframe_group_by(df, (unsigned int[]){0}, 1, &(AGGREGATION){0, AGG_SUM}, 1) == NULL);
+    CHECK(dataframe_group_by(df, NULL, 0, &sum, 1) == NULL);
+    free_dataframe(df);
+}
+
+// Hashed keys of several columns, with a group whose values are all null
+static void test_string_and_char_keys(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *names = add_new_column_to_dataframe(df, STRING, "name");
+    COLUMN *grades = add_new_column_to_dataframe(df, CHAR, "grade");
+    COLUMN *scores = add_new_column_to_dataframe(df, DOUBLE, "score");
+    char *name_values[] = {"bob", "amy", "bob", NULL, "amy", "bob", NULL, "cat"};
+    char grade_values[] = {'a', 'b', 'a', 'c', 'b', 'b', 'c', 'a'};
+    double score_values[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+    for (unsigned int i = 0; i < 8; i++) {
+        CHECK(insert_value(names, name_values[i]));
+        CHECK(insert_value(grades, &grade_values[i]));
+        CHECK(insert_value(scores, i == 5 ? NULL : &score_values[i]));
+    }
+    for (unsigned int c = 0; c < 3; c++) CHECK(column_delete_row(df->columns[c], 7));
+
+    AGGREGATION aggregations[] = {{2, AGG_SUM}, {2, AGG_MAX}};
+    DATAFRAME *result = dataframe_group_by(df, (unsigned int[]){0, 1}, 2, aggregations, 2);
+    CHECK(result != NULL && result->column_count == 4);
+    if (result != NULL) {
+        // Groups (bob, a) (amy, b) (null, c) (bob, b), the deleted (cat, a) row is gone
+        const char *expected_names[] = {"bob", "amy", NULL, "bob"};
+        char expected_grades[] = {'a', 'b', 'c', 'b'};
+        double expected_sums[] = {4.0, 7.0, 11.0, 0.0};
+        CHECK(result->columns[0]->size == 4);
+        for (unsigned int r = 0; r < 4 && r < result->columns[0]->size; r++) {
+            char *name = (char *)get_value_at(result->columns[0], r);
+            CHECK(expected_names[r] == NULL ? name == NULL : name != NULL && strcmp(name, expected_names[r]) == 0);
+            CHECK(*(char *)get_value_at(result->columns[1], r) == expected_grades[r]);
+        }
+        for (unsigned int r = 0; r < 3; r++) {
+            CHECK(*(double *)get_value_at(result->columns[2], r) == expected_sums[r]);
+        }
+        // (bob, b) only has a null score: its sum and max are null
+        CHECK(is_null_at(result->columns[2], 3) && is_null_at(result->columns[3], 3));
+        free_dataframe(result);
+    }
+
+    // A single CHAR key uses the direct table
+    result = dataframe_group_by(df, (unsigned int[]){1}, 1, &(AGGREGATION){2, AGG_MEAN}, 1);
+    CHECK(result != NULL && result->columns[0]->size == 3);
+    if (result != NULL) {
+        CHECK(*(char *)get_value_at(result->columns[0], 0) == 'a');
+        CHECK(*(double *)get_value_at(result->columns[1], 0) == 2.0);
+        CHECK(*(double *)get_value_at(result->columns[1], 1) == 3.5);
+        free_dataframe(result);
+    }
+    free_dataframe(df);
+}
+
+int main(void) {
+    test_merged_workers();
+    test_empty();
+    test_string_and_char_keys();
+    return check_status();
+}
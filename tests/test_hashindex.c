@@ -0,0 +1,141 @@
+#include "check.h"
+#include "hashindex.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DOMAIN 40  // Distinct values of the random operations
+
+typedef struct generated {
+    COL_TYPE cell;
+    char text[32];
+} GENERATED;
+
+// Value number k of the domain of a type; DOUBLE has -0.0 and 0.0, which are equal, and a NaN
+static void *make_value(ENUM_TYPE type, unsigned int k, GENERATED *out) {
+    switch (type) {
+        case INT:
+            out->cell.int_value = (int)k - DOMAIN / 2;
+            return &out->cell;
+        case DOUBLE:
+            out->cell.double_value = k == 0 ? -0.0 : k == 1 ? 0.0 : k == 2 ? NAN : ((double)k - DOMAIN / 2) * 0.5;
+            return &out->cell;
+        default:
+            snprintf(out->text, sizeof(out->text), "key %u", k);
+            return out->text;
+    }
+}
+
+// Cells equal to value, by scan: a NaN cell equals every value like in count_compare
+static unsigned long long int scan_count(COLUMN *col, void *value) {
+    unsigned long long int count = 0;
+    for (unsigned int row = 0; row < col->size; row++) {
+        void *cell = get_value_at(col, row);
+        if (cell != NULL && compare_values(col->column_type, cell, value) == 0) count++;
+    }
+    return count;
+}
+
+// The index answers every value of the domain like a scan
+static void check_index(COLUMN *col) {
+    CHECK(col->hash_index != NULL);
+    unsigned int mismatches = 0;
+    for (unsigned int k = 0; k < DOMAIN; k++) {
+        GENERATED value;
+        void *pivot = make_value(col->column_type, k, &value);
+        unsigned long long int count;
+        // A NaN pivot is left to the scan
+        if (col->column_type == DOUBLE && k == 2) {
+            CHECK(!hash_index_count(col, pivot, &count));
+            continue;
+        }
+        if (!hash_index_count(col, pivot, &count) || count != scan_count(col, pivot)) mismatches++;
+        if (count_occurrences(col, pivot) != (int)scan_count(col, pivot)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+}
+
+// Random inserts, overwrites, removals, deletions, batch appends and compactions keep the index exact
+static void test_random_operations(ENUM_TYPE type) {
+    COLUMN *col = create_column(type, "x");
+    CHECK(build_hash_index(col));
+    unsigned int seed = 2024;
+    for (unsigned int step = 1; step <= 20000; step++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int choice = (seed >> 16) % 100;
+        unsigned int k = (seed >> 8) % DOMAIN;
+        GENERATED value;
+        if (choice < 40 || col->size == 0) {
+            CHECK(insert_value(col, choice % 20 == 0 ? NULL : make_value(type, k, &value)));
+        } else if (choice < 60) {
+            unsigned int row = (seed >> 4) % col->size;
+            int ok = set_value_at(col, row, choice % 10 == 0 ? NULL : make_value(type, k, &value));
+            CHECK(ok == !is_deleted_at(col, row));
+        } else if (choice < 75) {
+            CHECK(remove_last_value(col));
+        } else if (choice < 85) {
+            CHECK(column_delete_row(col, (seed >> 4) % col->size));
+        } else if (choice < 90) {
+            COL_TYPE cells[8];
+            GENERATED texts[8];
+            char *strings[8];
+            for (unsigned int i = 0; i < 8; i++) {
+                void *generated = make_value(type, (k + i * 7) % DOMAIN, &texts[i]);
+                if (type == STRING) strings[i] = (char *)generated; else cells[i] = texts[i].cell;
+            }
+            CHECK(column_append_n(col, type == STRING ? (void *)strings : (void *)cells, 8));
+        } else if (choice == 90) {
+            CHECK(column_compact(col));
+        }
+        if (step % 500 == 0) check_index(col);
+    }
+    delete_column(&col);
+}
+
+// Keys whose count dropped to 0 stay as tombstones until the table grows, which drops them
+static void test_tombstones(ENUM_TYPE type) {
+    COLUMN *col = create_column(type, "x");
+    GENERATED value;
+    for (unsigned int k = 0; k < DOMAIN; k++) CHECK(insert_value(col, make_value(type, k, &value)));
+    CHECK(build_hash_index(col));
+    size_t first_usage = 0;
+    for (unsigned int round = 0; round < 50; round++) {
+        for (unsigned int i = 0; i < 300; i++) {
+            COL_TYPE cell;
+            char text[32];
+            void *fresh = &cell;
+            if (type == STRING) {
+                snprintf(text, sizeof(text), "fresh %u %u", round, i);
+                fresh = text;
+            } else if (type == INT) {
+                cell.int_value = 1000 + (int)(round * 300 + i);
+            } else {
+                cell.double_value = 1000.5 + round * 300 + i;
+            }
+            CHECK(insert_value(col, fresh));
+        }
+        while (col->size > DOMAIN) CHECK(remove_last_value(col));
+        if (round == 0) first_usage = hash_index_memory_usage(col);
+    }
+    // Dead keys do not pile up round after round
+    CHECK(hash_index_memory_usage(col) <= 2 * first_usage);
+    check_index(col);
+    GENERATED gone;
+    COL_TYPE removed = {.int_value = 1000};
+    if (type == DOUBLE) removed.double_value = 1000.5;
+    unsigned long long int count = 1;
+    if (type == STRING) snprintf(gone.text, sizeof(gone.text), "fresh 0 0");
+    void *pivot = type == STRING ? (void *)gone.text : (void *)&removed;
+    // Only the NaN cell of a DOUBLE column still equals a removed value
+    CHECK(hash_index_count(col, pivot, &count) && count == (type == DOUBLE ? 1 : 0) && count == scan_count(col, pivot));
+    delete_column(&col);
+}
+
+int main(void) {
+    ENUM_TYPE types[] = {INT, DOUBLE, STRING};
+    for (unsigned int t = 0; t < 3; t++) {
+        test_random_operations(types[t]);
+        test_tombstones(types[t]);
+    }
+    return check_status();
+}
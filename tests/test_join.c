@@ -0,0 +1,160 @@
+#include "check.h"
+#include "join.h"
+#include <stdlib.h>
+#include <string.h>
+
+// One side of a generated join: a key column and the row number as a payload to identify the rows
+typedef struct side_spec {
+    unsigned int rows;
+    unsigned int key_range;  // Keys are row % key_range
+    unsigned int null_every;  // Null key every so many rows
+    unsigned int delete_every;  // Deleted row every so many rows
+} SIDE_SPEC;
+
+static int key_is_null(const SIDE_SPEC *spec, unsigned int row) {
+    return row % spec->null_every == 1;
+}
+
+static int row_is_deleted(const SIDE_SPEC *spec, unsigned int row) {
+    return row % spec->delete_every == 2;
+}
+
+static DATAFRAME *build_side(const SIDE_SPEC *spec, char *key_title, char *id_title) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *keys = add_new_column_to_dataframe(df, INT, key_title);
+    COLUMN *ids = add_new_column_to_dataframe(df, UINT, id_title);
+    for (unsigned int row = 0; row < spec->rows; row++) {
+        int key = (int)(row % spec->key_range);
+        CHECK(insert_value(keys, key_is_null(spec, row) ? NULL : &key));
+        CHECK(insert_value(ids, &row));
+    }
+    for (unsigned int row = 2; row < spec->rows; row += spec->delete_every) {
+        CHECK(column_delete_row(keys, row));
+        CHECK(column_delete_row(ids, row));
+    }
+    return df;
+}
+
+// Join two generated sides and compare the output with the pairs enumerated in left then right row order
+static void check_join(const SIDE_SPEC *left_spec, const SIDE_SPEC *right_spec, JOIN_TYPE type) {
+    DATAFRAME *left = build_side(left_spec, "key", "left_id");
+    DATAFRAME *right = build_side(right_spec, "right_key", "right_id");
+
+    // Right rows of each key in row order
+    unsigned int keys = right_spec->key_range > left_spec->key_range ? right_spec->key_range : left_spec->key_range;
+    unsigned int *starts = (unsigned int *)calloc(keys + 1, sizeof(unsigned int));
+    unsigned int *right_rows = (unsigned int *)malloc((right_spec->rows + 1) * sizeof(unsigned int));
+    for (unsigned int row = 0; row < right_spec->rows; row++) {
+        if (!key_is_null(right_spec, row) && !row_is_deleted(right_spec, row)) starts[row % right_spec->key_range + 1]++;
+    }
+    for (unsigned int key = 0; key < keys; key++) starts[key + 1] += starts[key];
+    unsigned int *cursors = (unsigned int *)malloc((keys + 1) * sizeof(unsigned int));
+    memcpy(cursors, starts, (keys + 1) * sizeof(unsigned int));
+    for (unsigned int row = 0; row < right_spec->rows; row++) {
+        if (!key_is_null(right_spec, row) && !row_is_deleted(right_spec, row)) {
+            right_rows[cursors[row % right_spec->key_range]++] = row;
+        }
+    }
+
+    DATAFRAME *result = dataframe_join(left, right, 0, 0, type);
+    CHECK(result != NULL);
+    if (result != NULL) {
+        CHECK(result->column_count == 3);
+        CHECK(strcmp(result->columns[0]->title, "key") == 0 && strcmp(result->columns[2]->title, "right_id") == 0);
+        COLUMN *out_keys = result->columns[0], *out_left = result->columns[1], *out_right = result->columns[2];
+        unsigned int out = 0, mismatches = 0;
+        for (unsigned int row = 0; row < left_spec->rows; row++) {
+            if (row_is_deleted(left_spec, row)) continue;
+            unsigned int key = row % left_spec->key_range;
+            int null_key = key_is_null(left_spec, row);
+            unsigned int first = null_key || key >= keys ? 0 : starts[key];
+            unsigned int last = null_key || key >= keys ? 0 : starts[key + 1];
+            if (first == last && type == JOIN_LEFT) {
+                // An unmatched left row keeps its cells, with a null right cell
+                if (out >= out_left->size || *(unsigned int *)get_value_at(out_left, out) != row ||
+                    !is_null_at(out_right, out) || is_null_at(out_keys, out) != null_key) {
+                    mismatches++;
+                }
+                out++;
+            }
+            for (unsigned int m = first; m < last; m++, out++) {
+                if (out >= out_left->size || *(unsigned int *)get_value_at(out_left, out) != row ||
+                    is_null_at(out_right, out) || *(unsigned int *)get_value_at(out_right, out) != right_rows[m] ||
+                    *(int *)get_value_at(out_keys, out) != (int)key) {
+                    mismatches++;
+                }
+            }
+        }
+        CHECK(out == out_left->size);
+        CHECK(mismatches == 0);
+        free_dataframe(result);
+    }
+    free(starts);
+    free(cursors);
+    free(right_rows);
+    free_dataframe(left);
+    free_dataframe(right);
+}
+
+// Duplicate keys on both sides, left rows spread over several output ranges
+static void test_generated(void) {
+    SIDE_SPEC large = {150000, 5000, 97, 89};
+    SIDE_SPEC small = {12000, 7000, 31, 23};
+    check_join(&large, &small, JOIN_INNER);
+    check_join(&large, &small, JOIN_LEFT);
+    // The smaller side is on the left this time
+    check_join(&small, &large, JOIN_INNER);
+    check_join(&small, &large, JOIN_LEFT);
+}
+
+static void test_empty_sides(void) {
+    SIDE_SPEC rows = {1000, 10, 7, 11};
+    SIDE_SPEC none = {0, 10, 7, 11};
+    check_join(&rows, &none, JOIN_INNER);
+    check_join(&rows, &none, JOIN_LEFT);
+    check_join(&none, &rows, JOIN_LEFT);
+}
+
+static void test_string_keys(void) {
+    DATAFRAME *left = create_dataframe();
+    DATAFRAME *right = create_dataframe();
+    COLUMN *left_keys = add_new_column_to_dataframe(left, STRING, "name");
+    COLUMN *right_keys = add_new_column_to_dataframe(right, STRING, "name");
+    COLUMN *ages = add_new_column_to_dataframe(right, INT, "age");
+    char *left_values[] = {"cat", NULL, "amy", "dan", "amy"};
+    char *right_values[] = {"amy", "cat", NULL, "amy", "eve"};
+    int age_values[] = {30, 40, 50, 60, 70};
+    for (unsigned int i = 0; i < 5; i++) {
+        CHECK(insert_value(left_keys, left_values[i]));
+        CHECK(insert_value(right_keys, right_values[i]));
+        CHECK(insert_value(ages, &age_values[i]));
+    }
+
+    DATAFRAME *result = dataframe_join(left, right, 0, 0, JOIN_LEFT);
+    CHECK(result != NULL && result->column_count == 2);
+    if (result != NULL) {
+        // cat-40, null, amy-30, amy-60, dan, amy-30, amy-60
+        const char *names[] = {"cat", NULL, "amy", "amy", "dan", "amy", "amy"};
+        int ages_expected[] = {40, -1, 30, 60, -1, 30, 60};
+        CHECK(result->columns[0]->size == 7);
+        for (unsigned int r = 0; r < 7 && r < result->columns[0]->size; r++) {
+            char *name = (char *)get_value_at(result->columns[0], r);
+            CHECK(names[r] == NULL ? name == NULL : name != NULL && strcmp(name, names[r]) == 0);
+            int *age = (int *)get_value_at(result->columns[1], r);
+            CHECK(ages_expected[r] < 0 ? age == NULL : age != NULL && *age == ages_expected[r]);
+        }
+        free_dataframe(result);
+    }
+
+    // Keys of different types are refused
+    CHECK(dataframe_join(left, right, 0, 1, JOIN_INNER) == NULL);
+    free_dataframe(left);
+    free_dataframe(right);
+}
+
+int main(void) {
+    test_generated();
+    test_empty_sides();
+    test_string_keys();
+    return check_status();
+}
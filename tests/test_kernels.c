@@ -0,0 +1,182 @@
+#include "check.h"
+#include "kernels.h"
+#include "bitmap.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const FILTER_OP all_ops[] = {FILTER_LT, FILTER_LE, FILTER_EQ, FILTER_NE, FILTER_GE, FILTER_GT, FILTER_BETWEEN};
+
+// Row counts around the 64-row blocks, so that the scalar tail runs after the full-block kernels
+static const unsigned int sizes[] = {1, 63, 64, 65, 64 * 5 + 23};
+
+// Values of each type the rows and pivots are drawn from: the non-finite ones first, then the extremes
+static const unsigned int uint_pool[] = {0, 1, 2, 1000, 123456789, 0x7fffffffu, 0x80000000u, 0x80000001u,
+                                         UINT_MAX - 1, UINT_MAX};
+static const int int_pool[] = {INT_MIN, INT_MIN + 1, -1000, -1, 0, 1, 1000, INT_MAX - 1, INT_MAX};
+static const char char_pool[] = {CHAR_MIN, CHAR_MIN + 1, (char)-1, 0, 1, 'a', CHAR_MAX - 1, CHAR_MAX};
+static const float float_pool[] = {NAN, INFINITY, -INFINITY, -0.0f, 0.0f, FLT_MIN, 1e-45f, -1e-45f, 1.5f, -2.5f,
+                                   1e30f, -1e30f};
+static const double double_pool[] = {NAN, INFINITY, -INFINITY, -0.0, 0.0, DBL_MIN, 5e-324, -5e-324, 1.5, -2.5,
+                                     1e300, -1e300};
+
+typedef struct pool {
+    ENUM_TYPE type;
+    const void *values;
+    unsigned int count;
+    unsigned int non_finite;  // Leading NaN and infinities, left out of the finite reductions
+} POOL;
+
+static const POOL pools[] = {
+    {UINT, uint_pool, sizeof(uint_pool) / sizeof(uint_pool[0]), 0},
+    {INT, int_pool, sizeof(int_pool) / sizeof(int_pool[0]), 0},
+    {CHAR, char_pool, sizeof(char_pool) / sizeof(char_pool[0]), 0},
+    {FLOAT, float_pool, sizeof(float_pool) / sizeof(float_pool[0]), 3},
+    {DOUBLE, double_pool, sizeof(double_pool) / sizeof(double_pool[0]), 3},
+};
+
+static unsigned int seed = 12345;
+
+static unsigned int next_random(void) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static const void *pool_value(const POOL *pool, unsigned int i) {
+    return (const char *)pool->values + (size_t)i * type_size(pool->type);
+}
+
+// Rows drawn from the pool, from its first finite value when finite is set
+static void *random_values(const POOL *pool, unsigned int n, int finite) {
+    size_t elem_size = type_size(pool->type);
+    char *values = malloc(n * elem_size);
+    unsigned int first = finite ? pool->non_finite : 0;
+    for (unsigned int row = 0; row < n; row++) {
+        unsigned int i = first + next_random() % (pool->count - first);
+        memcpy(values + row * elem_size, pool_value(pool, i), elem_size);
+    }
+    return values;
+}
+
+// Validity with about one row in five null
+static unsigned long long int *random_validity(unsigned int n) {
+    unsigned long long int *validity = calloc(bitmap_words(n), sizeof(unsigned long long int));
+    for (unsigned int row = 0; row < n; row++) {
+        if (next_random() % 5 != 0) validity[row / 64] |= 1ULL << (row % 64);
+    }
+    return validity;
+}
+
+// Equal, or both NaN
+static int same_double(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static int close_double(double a, double b) {
+    if (same_double(a, b)) return 1;
+    return fabs(a - b) <= 1e-9 * fmax(fabs(a), fabs(b));
+}
+
+// Counts and filters of every pivot of the pool, at the active level and with the scalar kernels
+static void check_comparisons(const POOL *pool, const void *values, const unsigned long long int *validity,
+                              unsigned int n, KERNEL_LEVEL level) {
+    unsigned int words = (unsigned int)bitmap_words(n);
+    unsigned long long int *selected = calloc(words, sizeof(unsigned long long int));
+    unsigned long long int *expected = calloc(words, sizeof(unsigned long long int));
+    unsigned int starts[] = {0, n / 2 + 1};
+    for (unsigned int p = 0; p < pool->count; p++) {
+        const void *pivot = pool_value(pool, p);
+        const void *high = pool_value(pool, (p * 7 + 3) % pool->count);
+        for (unsigned int s = 0; s < 2; s++) {
+            if (starts[s] >= n) continue;
+            COMPARE_COUNTS got = {0, 0, 0}, want = {0, 0, 0};
+            set_kernel_level(KERNEL_SCALAR);
+            count_compare_kernel(pool->type, values, validity, starts[s], n, pivot, &want);
+            set_kernel_level(level);
+            count_compare_kernel(pool->type, values, validity, starts[s], n, pivot, &got);
+            CHECK(got.less == want.less && got.equal == want.equal && got.greater == want.greater);
+        }
+        for (unsigned int o = 0; o < sizeof(all_ops) / sizeof(all_ops[0]); o++) {
+            memset(selected, 0, words * sizeof(unsigned long long int));
+            memset(expected, 0, words * sizeof(unsigned long long int));
+            set_kernel_level(KERNEL_SCALAR);
+            unsigned int want = filter_kernel(pool->type, values, validity, 0, n, all_ops[o], pivot, high, expected);
+            set_kernel_level(level);
+            unsigned int got = filter_kernel(pool->type, values, validity, 0, n, all_ops[o], pivot, high, selected);
+            CHECK(got == want);
+            CHECK(memcmp(selected, expected, words * sizeof(unsigned long long int)) == 0);
+        }
+    }
+    free(selected);
+    free(expected);
+}
+
+static void reduce(ENUM_TYPE type, const void *values, const unsigned long long int *validity,
+                   unsigned int start, unsigned int n, COLUMN_AGGREGATES *aggregates) {
+    REDUCTION reduction;
+    reduction_init(&reduction, type, SUM_PLAIN);
+    reduce_kernel(values, validity, start, n, &reduction);
+    reduction_finish(&reduction, aggregates);
+}
+
+// Reductions at the active level and with the scalar kernels
+// The lanes group the values differently, so floating sums and variances may differ in their last bits
+static void check_reductions(const POOL *pool, const void *values, const unsigned long long int *validity,
+                             unsigned int n, KERNEL_LEVEL level) {
+    int integer = pool->type == UINT || pool->type == INT || pool->type == CHAR;
+    for (unsigned int start = 0; start < n; start += 64) {
+        COLUMN_AGGREGATES got, want;
+        set_kernel_level(KERNEL_SCALAR);
+        reduce(pool->type, values, validity, start, n, &want);
+        set_kernel_level(level);
+        reduce(pool->type, values, validity, start, n, &got);
+        CHECK(got.count == want.count);
+        CHECK(same_double(got.min, want.min) && same_double(got.max, want.max));
+        CHECK(integer ? got.sum == want.sum : close_double(got.sum, want.sum));
+        CHECK(close_double(got.mean, want.mean));
+        CHECK(close_double(got.variance, want.variance));
+    }
+}
+
+// Every level the processor supports gives the results of the scalar kernels
+static void test_levels(void) {
+    KERNEL_LEVEL detected = get_kernel_level();
+    for (int l = KERNEL_SSE2; l <= KERNEL_AVX2; l++) {
+        KERNEL_LEVEL level = (KERNEL_LEVEL)l;
+        if (set_kernel_level(level) != level) continue;
+        for (unsigned int t = 0; t < sizeof(pools) / sizeof(pools[0]); t++) {
+            const POOL *pool = &pools[t];
+            for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                unsigned int n = sizes[s];
+                for (int finite = 0; finite <= 1; finite++) {
+                    void *values = random_values(pool, n, finite);
+                    unsigned long long int *validity = random_validity(n);
+                    check_comparisons(pool, values, NULL, n, level);
+                    check_comparisons(pool, values, validity, n, level);
+                    check_reductions(pool, values, NULL, n, level);
+                    check_reductions(pool, values, validity, n, level);
+                    free(values);
+                    free(validity);
+                }
+            }
+        }
+    }
+    CHECK(set_kernel_level(detected) == detected);
+}
+
+// A forced level is capped at the detected one and the scalar level is always available
+static void test_set_level(void) {
+    KERNEL_LEVEL detected = get_kernel_level();
+    CHECK(set_kernel_level(KERNEL_SCALAR) == KERNEL_SCALAR);
+    CHECK(get_kernel_level() == KERNEL_SCALAR);
+    CHECK(set_kernel_level(KERNEL_AVX2) == detected);
+    CHECK(get_kernel_level() == detected);
+}
+
+int main(void) {
+    test_set_level();
+    test_levels();
+    return check_status();
+}
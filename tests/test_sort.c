@@ -0,0 +1,220 @@
+#include "check.h"
+#include "sort.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Row of the index at a position
+static unsigned int index_row(const COLUMN *col, unsigned int position) {
+    return (unsigned int)col->index[position];
+}
+
+// Check that the first valid positions of the index are in order and that every row appears once
+static void check_sorted(COLUMN *col, unsigned int valid, SORT_ORDER order) {
+    unsigned char *seen = (unsigned char *)calloc(col->size > 0 ? col->size : 1, 1);
+    for (unsigned int i = 0; i < col->size; i++) {
+        unsigned int row = index_row(col, i);
+        CHECK(row < col->size && !seen[row]);
+        if (row < col->size) seen[row] = 1;
+        if (i > 0 && i < valid) {
+            unsigned int previous = index_row(col, i - 1);
+            int cmp = compare_values(col->column_type, get_value_at(col, previous), get_value_at(col, row));
+            CHECK(order == ASC ? cmp <= 0 : cmp >= 0);
+            // Stable: equal values keep their row order
+            if (cmp == 0) CHECK(previous < row);
+        }
+    }
+    free(seen);
+}
+
+static void test_empty(void) {
+    COLUMN *col = create_column(INT, "empty");
+    CHECK(sort_column(col, ASC) == 1);
+    CHECK(col->valid_index == 1);
+    delete_column(&col);
+}
+
+// Nulls then deleted rows come after the valid rows, each group in row order
+static void test_nulls_and_deleted_last(SORT_ORDER order) {
+    COLUMN *col = create_column(INT, "values");
+    int values[] = {5, -3, 7, 5, 0, -3, 9, 1};
+    for (unsigned int i = 0; i < 8; i++) {
+        CHECK(insert_value(col, &values[i]));
+        if (i == 2 || i == 5) CHECK(insert_value(col, NULL));
+    }
+    // Rows: 5 -3 7 null 5 0 -3 null 9 1
+    CHECK(column_delete_row(col, 2));
+    CHECK(column_delete_row(col, 9));
+    CHECK(sort_column(col, order) == 1);
+    CHECK(col->valid_index == 1 && col->sort_dir == order);
+    check_sorted(col, 6, order);
+    for (unsigned int i = 0; i < 6; i++) CHECK(!is_null_at(col, index_row(col, i)));
+    unsigned int tail[] = {2, 3, 7, 9};
+    for (unsigned int i = 0; i < 4; i++) CHECK(index_row(col, 6 + i) == tail[i]);
+    if (order == ASC) {
+        CHECK(index_row(col, 0) == 1 && index_row(col, 1) == 6 && index_row(col, 5) == 8);
+    } else {
+        CHECK(index_row(col, 0) == 8 && index_row(col, 4) == 1 && index_row(col, 5) == 6);
+    }
+    delete_column(&col);
+}
+
+// Signed zeros, negative values and infinities of the float radix keys
+static void test_double_keys(void) {
+    COLUMN *col = create_column(DOUBLE, "doubles");
+    double values[] = {2.5, -0.0, -INFINITY, 1e300, -1e-300, 0.0, INFINITY, -2.5};
+    for (unsigned int i = 0; i < 8; i++) CHECK(insert_value(col, &values[i]));
+    CHECK(sort_column(col, ASC) == 1);
+    check_sorted(col, 8, ASC);
+    CHECK(index_row(col, 0) == 2 && index_row(col, 7) == 6);
+    delete_column(&col);
+}
+
+static void test_strings(void) {
+    COLUMN *col = create_column(STRING, "names");
+    char *values[] = {"pear", "apple", NULL, "fig", "apple", ""};
+    for (unsigned int i = 0; i < 6; i++) CHECK(insert_value(col, values[i]));
+    CHECK(column_delete_row(col, 3));
+    CHECK(sort_column(col, ASC) == 1);
+    unsigned int expected[] = {5, 1, 4, 0, 2, 3};
+    for (unsigned int i = 0; i < 6; i++) CHECK(index_row(col, i) == expected[i]);
+    delete_column(&col);
+}
+
+// Large enough to be partitioned across the thread pool
+static void test_parallel(void) {
+    COLUMN *col = create_column(INT, "large");
+    unsigned int n = (1u << 20) + 12345;
+    unsigned int seed = 12345;
+    for (unsigned int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        if (i % 1000 == 7) {
+            CHECK(insert_value(col, NULL));
+        } else {
+            int value = (int)(seed >> 8) - (1 << 23);
+            CHECK(insert_value(col, &value));
+        }
+    }
+    for (unsigned int i = 3; i < n; i += 4099) CHECK(column_delete_row(col, i));
+    unsigned int invalid = (unsigned int)count_nulls(col) + col->deleted_count;
+    CHECK(sort_column(col, DESC) == 1);
+    check_sorted(col, n - invalid, DESC);
+    for (unsigned int i = n - invalid; i < n; i++) {
+        CHECK(is_null_at(col, index_row(col, i)));
+        if (i > n - invalid) CHECK(index_row(col, i - 1) < index_row(col, i));
+    }
+    delete_column(&col);
+}
+
+// Counts of the non-null rows by comparison with a pivot, row by row like the scans (NaN counts as equal)
+static COMPARE_COUNTS scan_counts(COLUMN *col, void *pivot) {
+    COMPARE_COUNTS counts = {0, 0, 0};
+    for (unsigned int row = 0; row < col->size; row++) {
+        void *value = get_value_at(col, row);
+        if (value == NULL) continue;
+        int cmp = compare_values(col->column_type, value, pivot);
+        if (cmp < 0) counts.less++; else if (cmp > 0) counts.greater++; else counts.equal++;
+    }
+    return counts;
+}
+
+// The counts answered through the index, when it is still valid, and through count_compare match a full scan
+static void check_indexed_counts(COLUMN *col) {
+    double pivots[] = {-1.0, 0.5, 2.0, 2.5, 3.0, 7.0, 1e9};
+    for (unsigned int p = 0; p < sizeof(pivots) / sizeof(pivots[0]); p++) {
+        COL_TYPE pivot;
+        if (col->column_type == INT) pivot.int_value = (int)pivots[p]; else pivot.double_value = pivots[p];
+        COMPARE_COUNTS expected = scan_counts(col, &pivot), counts;
+        if (count_compare_with_index(col, &pivot, &counts)) {
+            CHECK(counts.less == expected.less && counts.equal == expected.equal && counts.greater == expected.greater);
+        }
+        count_compare(col, &pivot, &counts);
+        CHECK(counts.less == expected.less && counts.equal == expected.equal && counts.greater == expected.greater);
+        CHECK(count_less_than(col, &pivot) == (int)expected.less);
+        CHECK(count_occurrences(col, &pivot) == (int)expected.equal);
+    }
+}
+
+// A NaN appended to a sorted column drops the index instead of leaving it unsorted
+static void test_nan_append(void) {
+    COLUMN *col = create_column(DOUBLE, "x");
+    double values[] = {1.0, 2.0, 3.0, NAN, 0.5};
+    for (unsigned int i = 0; i < 3; i++) CHECK(insert_value(col, &values[i]));
+    CHECK(sort_column(col, ASC) == 1);
+    CHECK(insert_value(col, &values[3]));
+    CHECK(col->valid_index == 0);
+    CHECK(insert_value(col, &values[4]));
+    double pivot = 2.5;
+    CHECK(count_less_than(col, &pivot) == 3);
+    check_indexed_counts(col);
+    delete_column(&col);
+}
+
+// Appends keep the index while they follow its order, every other change drops it; counts stay right throughout
+static void test_index_repair(SORT_ORDER order, ENUM_TYPE type) {
+    COLUMN *col = create_column(type, "x");
+    unsigned int seed = 99;
+    for (unsigned int i = 0; i < 200; i++) {
+        seed = seed * 1103515245u + 12345u;
+        COL_TYPE value;
+        if (type == INT) value.int_value = (int)(seed >> 16) % 10; else value.double_value = (double)((seed >> 16) % 10);
+        CHECK(insert_value(col, i % 13 == 0 ? NULL : &value));
+    }
+    CHECK(sort_column(col, order) == 1);
+    check_indexed_counts(col);
+
+    // In order: after the last value for ASC, before the first for DESC, and nulls anywhere
+    for (int step = 0; step < 5; step++) {
+        COL_TYPE value;
+        if (type == INT) value.int_value = order == ASC ? 10 + step : -step; else value.double_value = order == ASC ? 10.0 + step : -step;
+        CHECK(insert_value(col, &value));
+        CHECK(insert_value(col, NULL));
+        CHECK(col->valid_index == 1);
+        check_indexed_counts(col);
+    }
+    // Out of order
+    COL_TYPE middle;
+    if (type == INT) middle.int_value = 3; else middle.double_value = 3.0;
+    CHECK(insert_value(col, &middle));
+    CHECK(col->valid_index == 0);
+    check_indexed_counts(col);
+
+    CHECK(sort_column(col, order) == 1);
+    CHECK(set_value_at(col, 5, &middle));
+    CHECK(col->valid_index == 0);
+    check_indexed_counts(col);
+
+    CHECK(sort_column(col, order) == 1);
+    CHECK(column_delete_row(col, 7));
+    CHECK(col->valid_index == 0);
+    check_indexed_counts(col);
+
+    if (type == DOUBLE) {
+        CHECK(sort_column(col, order) == 1);
+        double nan = NAN;
+        CHECK(insert_value(col, &nan));
+        CHECK(col->valid_index == 0);
+        check_indexed_counts(col);
+        // Sorting again puts the NaN at an end, where the index refuses to answer
+        CHECK(sort_column(col, order) == 1);
+        check_indexed_counts(col);
+        double value = order == ASC ? 1e6 : -1e6;
+        CHECK(insert_value(col, &value));
+        check_indexed_counts(col);
+    }
+    delete_column(&col);
+}
+
+int main(void) {
+    test_empty();
+    test_nulls_and_deleted_last(ASC);
+    test_nulls_and_deleted_last(DESC);
+    test_double_keys();
+    test_strings();
+    test_parallel();
+    test_nan_append();
+    test_index_repair(ASC, INT);
+    test_index_repair(DESC, INT);
+    test_index_repair(ASC, DOUBLE);
+    test_index_repair(DESC, DOUBLE);
+    return check_status();
+}
@@ -0,0 +1,175 @@
+#include "check.h"
+#include "storage.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FILE "test_storage.cdf"
+
+// Read a whole file, NULL on failure
+static char *read_bytes(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = (char *)malloc(*size > 0 ? *size : 1);
+    if (data != NULL && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+static void write_bytes(const char *path, const char *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    CHECK(file != NULL);
+    if (file == NULL) return;
+    CHECK(fwrite(data, 1, size, file) == size);
+    fclose(file);
+}
+
+// Offset of the first occurrence of a string (terminating NUL included) in a buffer, size when there is none
+static size_t find_string(const char *data, size_t size, const char *str) {
+    size_t length = strlen(str) + 1;
+    for (size_t i = 0; i + length <= size; i++) {
+        if (memcmp(data + i, str, length) == 0) return i;
+    }
+    return size;
+}
+
+// A dataframe with nulls, a deleted row, an overwritten string and an empty column
+static DATAFRAME *build_dataframe(void) {
+    DATAFRAME *df = create_dataframe();
+    COLUMN *ints = add_new_column_to_dataframe(df, INT, "ints");
+    COLUMN *doubles = add_new_column_to_dataframe(df, DOUBLE, "doubles");
+    COLUMN *strings = add_new_column_to_dataframe(df, STRING, "strings");
+    add_new_column_to_dataframe(df, UINT, "empty");
+    int int_values[] = {4, -7, 0, 12, 99};
+    double double_values[] = {1.5, NAN, -0.25, 1e300, 3.0};
+    char *string_values[] = {"alpha", "", NULL, "a somewhat longer string", "zzzz-last"};
+    for (unsigned int i = 0; i < 5; i++) {
+        CHECK(insert_value(ints, i == 1 ? NULL : &int_values[i]));
+        CHECK(insert_value(doubles, &double_values[i]));
+        CHECK(insert_value(strings, string_values[i]));
+    }
+    CHECK(set_value_at(strings, 3, "short"));
+    // The empty column has no row 2, so the row is deleted column by column
+    for (unsigned int c = 0; c < 3; c++) CHECK(column_delete_row(df->columns[c], 2));
+    return df;
+}
+
+static void test_round_trip(void) {
+    DATAFRAME *df = build_dataframe();
+    CHECK(save_dataframe(df, TEST_FILE) == 0);
+    // The dead bytes of the overwritten string are not written
+    CHECK(df->columns[2]->strings_dead == 0);
+
+    DATAFRAME *mapped = open_dataframe(TEST_FILE);
+    CHECK(mapped != NULL);
+    if (mapped == NULL) {
+        free_dataframe(df);
+        return;
+    }
+    CHECK(mapped->column_count == 4);
+    const char *titles[] = {"ints", "doubles", "strings", "empty"};
+    ENUM_TYPE types[] = {INT, DOUBLE, STRING, UINT};
+    for (unsigned int c = 0; c < 4; c++) {
+        COLUMN *col = mapped->columns[c];
+        CHECK(strcmp(col->title, titles[c]) == 0);
+        CHECK(col->column_type == types[c]);
+        CHECK(col->read_only == 1);
+        CHECK(col->size == df->columns[c]->size);
+        CHECK(col->deleted_count == df->columns[c]->deleted_count);
+    }
+
+    COLUMN *ints = mapped->columns[0];
+    CHECK(*(int *)get_value_at(ints, 0) == 4 && *(int *)get_value_at(ints, 4) == 99);
+    CHECK(is_null_at(ints, 1) && count_nulls(ints) == 1);
+    CHECK(is_deleted_at(ints, 2) && get_value_at(ints, 2) == NULL);
+
+    COLUMN *doubles = mapped->columns[1];
+    CHECK(isnan(*(double *)get_value_at(doubles, 1)));
+    CHECK(*(double *)get_value_at(doubles, 3) == 1e300);
+    CHECK(is_deleted_at(doubles, 2));
+
+    COLUMN *strings = mapped->columns[2];
+    CHECK(strcmp((char *)get_value_at(strings, 0), "alpha") == 0);
+    CHECK(strcmp((char *)get_value_at(strings, 1), "") == 0);
+    CHECK(strcmp((char *)get_value_at(strings, 3), "short") == 0);
+    CHECK(strcmp((char *)get_value_at(strings, 4), "zzzz-last") == 0);
+    CHECK(get_value_at(strings, 2) == NULL);
+
+    CHECK(mapped->columns[3]->size == 0);
+
+    // Mapped columns refuse changes but can still be scanned
+    int value = 5;
+    CHECK(insert_value(ints, &value) == 0);
+    CHECK(ints->size == 5);
+    CHECK(count_equal_to(ints, &(int){12}) == 1);
+
+    free_dataframe(mapped);
+    free_dataframe(df);
+}
+
+static void test_empty_dataframe(void) {
+    DATAFRAME *df = create_dataframe();
+    CHECK(save_dataframe(df, TEST_FILE) == 0);
+    DATAFRAME *mapped = open_dataframe(TEST_FILE);
+    CHECK(mapped != NULL && mapped->column_count == 0);
+    free_dataframe(mapped);
+    free_dataframe(df);
+}
+
+// Truncated files and string offsets or arenas reaching past the string block are rejected
+static void test_corrupted_files(void) {
+    DATAFRAME *df = build_dataframe();
+    CHECK(save_dataframe(df, TEST_FILE) == 0);
+    free_dataframe(df);
+    size_t size = 0;
+    char *data = read_bytes(TEST_FILE, &size);
+    CHECK(data != NULL);
+    if (data == NULL) return;
+
+    write_bytes(TEST_FILE, data, size / 2);
+    CHECK(open_dataframe(TEST_FILE) == NULL);
+    write_bytes(TEST_FILE, data, 4);
+    CHECK(open_dataframe(TEST_FILE) == NULL);
+
+    // The last string of the block loses its NUL
+    size_t last = find_string(data, size, "zzzz-last");
+    CHECK(last < size);
+    if (last < size) {
+        char *copy = (char *)malloc(size);
+        memcpy(copy, data, size);
+        copy[last + strlen("zzzz-last")] = 'x';
+        write_bytes(TEST_FILE, copy, size);
+        CHECK(open_dataframe(TEST_FILE) == NULL);
+        free(copy);
+    }
+
+    write_bytes(TEST_FILE, data, size);
+    DATAFRAME *mapped = open_dataframe(TEST_FILE);
+    CHECK(mapped != NULL);
+    if (mapped != NULL) {
+        // Point the offset of the first string far past the string block
+        COLUMN *strings = mapped->columns[2];
+        size_t offset_position = (size_t)((const char *)strings->values - mapped->mapping);
+        free_dataframe(mapped);
+        unsigned long long int bad_offset = 1ull << 40;
+        memcpy(data + offset_position, &bad_offset, sizeof(bad_offset));
+        write_bytes(TEST_FILE, data, size);
+        CHECK(open_dataframe(TEST_FILE) == NULL);
+    }
+    free(data);
+    CHECK(open_dataframe("no-such-file.cdf") == NULL);
+}
+
+int main(void) {
+    test_round_trip();
+    test_empty_dataframe();
+    test_corrupted_files();
+    remove(TEST_FILE);
+    return check_status();
+}
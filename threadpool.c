@@ -0,0 +1,200 @@
+#include "threadpool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct thread_pool {
+    pthread_t *threads;  // Workers 1..num_threads-1, the caller acts as worker 0
+    unsigned int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;  // Signaled when a new batch is posted or on shutdown
+    pthread_cond_t work_done;  // Signaled when the last worker leaves a batch
+    pthread_mutex_t run_lock;  // Serializes batches from concurrent callers
+    unsigned long long int generation;  // Incremented for every batch
+    int shutdown;
+
+    // Current batch
+    POOL_TASK task;
+    void *ctx;
+    unsigned int num_tasks;
+    atomic_uint next_task;
+    unsigned int active_workers;  // Workers still inside the batch
+};
+
+// Set inside pool threads and while the caller runs a batch, so that nested batches run inline
+static _Thread_local int inside_batch = 0;
+
+// Pull task indexes until the batch is exhausted
+static void run_tasks(THREAD_POOL *pool, unsigned int worker) {
+    unsigned int i;
+    while ((i = atomic_fetch_add(&pool->next_task, 1)) < pool->num_tasks) {
+        pool->task(pool->ctx, i, worker);
+    }
+}
+
+typedef struct worker_args {
+    THREAD_POOL *pool;
+    unsigned int worker;
+} WORKER_ARGS;
+
+static void *worker_main(void *arg) {
+    WORKER_ARGS args = *(WORKER_ARGS *)arg;
+    free(arg);
+    THREAD_POOL *pool = args.pool;
+    unsigned long long int seen = 0;
+    inside_batch = 1;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool, args.worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active_workers == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Function to get the number of CPUs available to the process
+unsigned int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (unsigned int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned int)n : 1;
+#endif
+}
+
+// Function to create a thread pool
+THREAD_POOL *create_thread_pool(unsigned int num_threads) {
+    if (num_threads == 0) num_threads = cpu_count();
+
+    THREAD_POOL *pool = (THREAD_POOL *)calloc(1, sizeof(THREAD_POOL));
+    if (!pool) {
+        fprintf(stderr, "Memory allocation failed for the thread pool.\n");
+        return NULL;
+    }
+    pool->threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+    if (!pool->threads) {
+        fprintf(stderr, "Memory allocation failed for the thread pool.\n");
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    atomic_init(&pool->next_task, 0);
+
+    // The caller is worker 0, so only num_threads - 1 threads are started
+    pool->num_threads = 1;
+    for (unsigned int i = 1; i < num_threads; i++) {
+        WORKER_ARGS *args = (WORKER_ARGS *)malloc(sizeof(WORKER_ARGS));
+        if (!args) break;
+        args->pool = pool;
+        args->worker = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, args) != 0) {
+            free(args);
+            fprintf(stderr, "Failed to start worker thread %u.\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+    return pool;
+}
+
+// Function to stop the workers and free the pool
+void free_thread_pool(THREAD_POOL *pool) {
+    if (pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned int i = 1; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    free(pool->threads);
+    free(pool);
+}
+
+// Function to get the number of threads of a pool
+unsigned int thread_pool_size(THREAD_POOL *pool) {
+    return pool == NULL ? 1 : pool->num_threads;
+}
+
+// Function to run a batch of tasks on the pool
+void thread_pool_run(THREAD_POOL *pool, unsigned int num_tasks, POOL_TASK task, void *ctx) {
+    if (num_tasks == 0) return;
+
+    // Small batches, single-threaded pools and nested batches run on the calling thread
+    if (pool == NULL || pool->num_threads == 1 || num_tasks == 1 || inside_batch) {
+        for (unsigned int i = 0; i < num_tasks; i++) {
+            task(ctx, i, 0);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->num_tasks = num_tasks;
+    atomic_store(&pool->next_task, 0);
+    pool->active_workers = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    inside_batch = 1;
+    run_tasks(pool, 0);
+    inside_batch = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active_workers > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+static THREAD_POOL *default_pool = NULL;
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+
+static void create_default_pool(void) {
+    default_pool = create_thread_pool(0);
+}
+
+// Function to get the process-wide pool, created on first use with one thread per CPU
+THREAD_POOL *get_default_thread_pool(void) {
+    pthread_once(&default_pool_once, create_default_pool);
+    return default_pool;
+}
+
+// Function to resize the process-wide pool
+void set_thread_count(unsigned int num_threads) {
+    pthread_once(&default_pool_once, create_default_pool);
+    THREAD_POOL *old_pool = default_pool;
+    default_pool = create_thread_pool(num_threads);
+    free_thread_pool(old_pool);
+}
@@ -0,0 +1,37 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Reusable pool of worker threads running batches of independent tasks
+
+typedef struct thread_pool THREAD_POOL;
+
+// A task receives the shared context, its index in the batch and the index of the worker running it
+// (0 is the calling thread), so that each worker can accumulate into its own partial result
+typedef void (*POOL_TASK)(void *ctx, unsigned int task_index, unsigned int worker);
+
+// Function prototypes for managing thread pools
+
+// Create a pool running batches on num_threads threads (the caller included), 0 for one per CPU
+THREAD_POOL *create_thread_pool(unsigned int num_threads);
+
+// Stop the workers and free the pool
+void free_thread_pool(THREAD_POOL *pool);
+
+// Number of threads running a batch, the calling thread included
+unsigned int thread_pool_size(THREAD_POOL *pool);
+
+// Run task for every index of [0, num_tasks) and return once all of them are done
+// Workers pull the next index from a shared counter, so uneven tasks balance out
+// A batch started from inside a task runs on the calling thread only
+void thread_pool_run(THREAD_POOL *pool, unsigned int num_tasks, POOL_TASK task, void *ctx);
+
+// Process-wide pool used by the dataframes that do not own one
+THREAD_POOL *get_default_thread_pool(void);
+
+// Resize the process-wide pool, 0 for one thread per CPU; must not race with running batches
+void set_thread_count(unsigned int num_threads);
+
+// Number of CPUs available to the process
+unsigned int cpu_count(void);
+
+#endif // THREADPOOL_H
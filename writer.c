@@ -0,0 +1,213 @@
+#include "writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Two-digit groups, so that integers are converted two digits per division
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const double double_powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+static const unsigned long long int integer_powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+// Largest number of decimals rendered without printf
+#define FAST_DECIMALS 9
+
+// Function to start a writer
+void writer_init(TEXT_WRITER *writer, int fd) {
+    writer->fd = fd;
+    writer->data = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+    writer->failed = 0;
+}
+
+static int write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, length > 0x40000000 ? 0x40000000 : (unsigned int)length);
+#else
+        ssize_t n = write(fd, data, length);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+// Function to write the buffered text out
+int writer_flush(TEXT_WRITER *writer) {
+    if (writer->fd < 0) return !writer->failed;
+    if (!writer->failed && writer->length > 0 && !write_all(writer->fd, writer->data, writer->length)) {
+        writer->failed = 1;
+    }
+    writer->length = 0;
+    return !writer->failed;
+}
+
+// Function to flush a writer and release its buffer
+int writer_close(TEXT_WRITER *writer) {
+    int ok = writer_flush(writer);
+    free(writer->data);
+    writer->data = NULL;
+    writer->capacity = 0;
+    return ok;
+}
+
+// Room for length more bytes at the end of the buffer, NULL after a failure
+static char *writer_reserve(TEXT_WRITER *writer, size_t length) {
+    if (writer->failed) return NULL;
+    if (writer->length + length <= writer->capacity) return writer->data + writer->length;
+    if (writer->fd >= 0 && !writer_flush(writer)) return NULL;
+    if (writer->length + length > writer->capacity) {
+        size_t capacity = writer->capacity > 0 ? writer->capacity * 2 : writer->fd >= 0 ? WRITER_BUFFER_SIZE : 4096;
+        while (capacity < writer->length + length) capacity *= 2;
+        char *data = (char *)realloc(writer->data, capacity);
+        if (!data) {
+            writer->failed = 1;
+            return NULL;
+        }
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+    return writer->data + writer->length;
+}
+
+// Function to append bytes
+void writer_put(TEXT_WRITER *writer, const char *text, size_t length) {
+    // Large blocks go straight to the file
+    if (writer->fd >= 0 && length >= WRITER_BUFFER_SIZE) {
+        if (writer_flush(writer) && !write_all(writer->fd, text, length)) writer->failed = 1;
+        return;
+    }
+    char *p = writer_reserve(writer, length);
+    if (!p) return;
+    memcpy(p, text, length);
+    writer->length += length;
+}
+
+// Function to append a NUL-terminated string
+void writer_put_string(TEXT_WRITER *writer, const char *text) {
+    writer_put(writer, text, strlen(text));
+}
+
+// Function to append one character
+void writer_put_char(TEXT_WRITER *writer, char c) {
+    char *p = writer_reserve(writer, 1);
+    if (!p) return;
+    *p = c;
+    writer->length++;
+}
+
+// Function to append an unsigned integer in decimal
+void writer_put_uint(TEXT_WRITER *writer, unsigned long long int value) {
+    char digits[20];
+    char *end = digits + sizeof(digits), *q = end;
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100);
+        value /= 100;
+        q -= 2;
+        memcpy(q, digit_pairs + 2 * pair, 2);
+    }
+    if (value >= 10) {
+        q -= 2;
+        memcpy(q, digit_pairs + 2 * value, 2);
+    } else {
+        *--q = (char)('0' + value);
+    }
+    writer_put(writer, q, (size_t)(end - q));
+}
+
+// Function to append a signed integer in decimal
+void writer_put_int(TEXT_WRITER *writer, long long int value) {
+    if (value < 0) {
+        writer_put_char(writer, '-');
+        writer_put_uint(writer, 0 - (unsigned long long int)value);
+    } else {
+        writer_put_uint(writer, (unsigned long long int)value);
+    }
+}
+
+// Appends sign, then magnitude scaled down by 10^decimals with exactly that many decimals
+static void put_scaled(TEXT_WRITER *writer, int negative, unsigned long long int magnitude, unsigned int decimals) {
+    if (negative) writer_put_char(writer, '-');
+    writer_put_uint(writer, magnitude / integer_powers_of_ten[decimals]);
+    if (decimals == 0) return;
+    char *p = writer_reserve(writer, decimals + 1);
+    if (!p) return;
+    unsigned long long int fraction = magnitude % integer_powers_of_ten[decimals];
+    p[0] = '.';
+    for (unsigned int i = decimals; i > 0; i--) {
+        p[i] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    writer->length += decimals + 1;
+}
+
+// Appends the text printf gives for a format taking one double
+static void put_printf(TEXT_WRITER *writer, const char *format, int precision, double value) {
+    int length = snprintf(NULL, 0, format, precision, value);
+    if (length < 0) return;
+    char *p = writer_reserve(writer, (size_t)length + 1);
+    if (!p) return;
+    snprintf(p, (size_t)length + 1, format, precision, value);
+    writer->length += (size_t)length;
+}
+
+// Function to append a double with a fixed number of decimals, rounded like printf
+void writer_put_fixed(TEXT_WRITER *writer, double value, unsigned int decimals) {
+    if (decimals <= FAST_DECIMALS) {
+        double scaled = fabs(value) * double_powers_of_ten[decimals];
+        // Below 1e15 an ulp of scaled is at most 1/8, so the rounded product rounds like the exact one
+        // unless it lies within an ulp of a tie; NaN fails the comparison
+        if (scaled < 1e15) {
+            double whole = floor(scaled), fraction = scaled - whole;
+            if (fabs(fraction - 0.5) > scaled * 0x1p-52) {
+                put_scaled(writer, signbit(value) != 0, (unsigned long long int)whole + (fraction > 0.5), decimals);
+                return;
+            }
+        }
+    }
+    put_printf(writer, "%.*f", (int)decimals, value);
+}
+
+// Function to append a double that reads back exactly
+void writer_put_double(TEXT_WRITER *writer, double value) {
+    for (unsigned int decimals = 0; decimals <= FAST_DECIMALS && fabs(value) < 1e15; decimals++) {
+        double scaled = nearbyint(fabs(value) * double_powers_of_ten[decimals]);
+        // Both operands are exact, so the reader's division gives back value
+        if (scaled < 0x1p53 && scaled / double_powers_of_ten[decimals] == fabs(value)) {
+            put_scaled(writer, signbit(value) != 0, (unsigned long long int)scaled, decimals);
+            return;
+        }
+    }
+    put_printf(writer, "%.*g", 17, value);
+}
+
+// Function to append a float that reads back exactly
+void writer_put_float(TEXT_WRITER *writer, float value) {
+    double magnitude = fabs((double)value);
+    for (unsigned int decimals = 0; decimals <= FAST_DECIMALS && magnitude < 1e15; decimals++) {
+        double scaled = nearbyint(magnitude * double_powers_of_ten[decimals]);
+        if (scaled < 0x1p53 && (float)(scaled / double_powers_of_ten[decimals]) == (float)magnitude) {
+            put_scaled(writer, signbit(value) != 0, (unsigned long long int)scaled, decimals);
+            return;
+        }
+    }
+    put_printf(writer, "%.*g", 9, value);
+}
@@ -0,0 +1,45 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h>
+
+// Size of the buffer of a writer, flushed with one write call when full
+#define WRITER_BUFFER_SIZE (1 << 20)
+
+// Buffered text output to a file descriptor, or to a growing memory buffer
+typedef struct text_writer {
+    int fd;  // Destination, -1 to keep the text in memory
+    char *data;
+    size_t length;
+    size_t capacity;
+    int failed;  // Set by an allocation or write failure, later output is dropped
+} TEXT_WRITER;
+
+// Function prototypes for managing writers
+
+// Start a writer on fd, or in memory when fd is -1
+void writer_init(TEXT_WRITER *writer, int fd);
+
+// Write the buffered text to the file descriptor (no-op in memory), returns 0 after a failure
+int writer_flush(TEXT_WRITER *writer);
+
+// Flush and release the buffer, returns 0 if anything failed
+int writer_close(TEXT_WRITER *writer);
+
+// Function prototypes for appending text
+
+void writer_put(TEXT_WRITER *writer, const char *text, size_t length);
+void writer_put_string(TEXT_WRITER *writer, const char *text);
+void writer_put_char(TEXT_WRITER *writer, char c);
+void writer_put_uint(TEXT_WRITER *writer, unsigned long long int value);
+void writer_put_int(TEXT_WRITER *writer, long long int value);
+
+// Same text as printf("%.*f", decimals, value)
+void writer_put_fixed(TEXT_WRITER *writer, double value, unsigned int decimals);
+
+// Text that reads back as the same double (or as the same float after a (float) cast), with the fewest
+// decimals up to 9 when they are exact and 17 (9 for float) significant digits otherwise
+void writer_put_double(TEXT_WRITER *writer, double value);
+void writer_put_float(TEXT_WRITER *writer, float value);
+
+#endif // WRITER_H
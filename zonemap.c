@@ -0,0 +1,159 @@
+#include "zonemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+static int has_zone_map(ENUM_TYPE type) {
+    return type == UINT || type == INT || type == CHAR || type == FLOAT || type == DOUBLE;
+}
+
+// Every value of these types converts exactly to a double, with the same ordering
+static double value_as_double(ENUM_TYPE type, const void *value) {
+    switch (type) {
+        case UINT:
+            return *(const unsigned int *)value;
+        case INT:
+            return *(const int *)value;
+        case CHAR:
+            return *(const char *)value;
+        case FLOAT:
+            return *(const float *)value;
+        default:
+            return *(const double *)value;
+    }
+}
+
+static size_t zone_count(size_t rows) {
+    return (rows + ZONE_ROWS - 1) / ZONE_ROWS;
+}
+
+// Function to make room for the zones of capacity rows
+int zone_map_reserve(COLUMN *col, size_t capacity) {
+    if (!has_zone_map(col->column_type)) return 1;
+    size_t old_zones = col->zones != NULL ? zone_count(col->max_size) : 0, new_zones = zone_count(capacity);
+    if (new_zones <= old_zones) return 1;
+    ZONE *zones = (ZONE *)realloc(col->zones, new_zones * sizeof(ZONE));
+    if (!zones) {
+        fprintf(stderr, "Zone map reallocation failed.\n");
+        return 0;
+    }
+    for (size_t z = old_zones; z < new_zones; z++) {
+        zones[z].min = INFINITY;
+        zones[z].max = -INFINITY;
+        zones[z].count = 0;
+        zones[z].nan_count = 0;
+    }
+    col->zones = zones;
+    return 1;
+}
+
+// Function to account for the value of a row
+void zone_map_add_row(COLUMN *col, unsigned int row) {
+    if (col->zones == NULL) return;
+    const void *value = get_value_at(col, row);
+    if (value == NULL) return;
+    ZONE *zone = &col->zones[row / ZONE_ROWS];
+    double v = value_as_double(col->column_type, value);
+    if (v != v) {
+        zone->nan_count++;
+        return;
+    }
+    if (v < zone->min) zone->min = v;
+    if (v > zone->max) zone->max = v;
+    zone->count++;
+}
+
+// Function to forget the value of a row, the bounds are left as they are
+void zone_map_remove_row(COLUMN *col, unsigned int row) {
+    if (col->zones == NULL) return;
+    const void *value = get_value_at(col, row);
+    if (value == NULL) return;
+    ZONE *zone = &col->zones[row / ZONE_ROWS];
+    double v = value_as_double(col->column_type, value);
+    if (v != v) {
+        zone->nan_count--;
+    } else {
+        zone->count--;
+    }
+}
+
+// Function to recompute the zone map of a column
+int zone_map_rebuild(COLUMN *col) {
+    if (col->zones == NULL) return 1;
+    size_t count = zone_count(col->max_size);
+    ZONE *zones = (ZONE *)realloc(col->zones, (count > 0 ? count : 1) * sizeof(ZONE));
+    if (!zones) {
+        fprintf(stderr, "Zone map reallocation failed.\n");
+        return 0;
+    }
+    col->zones = zones;
+    for (size_t z = 0; z < count; z++) {
+        zones[z].min = INFINITY;
+        zones[z].max = -INFINITY;
+        zones[z].count = 0;
+        zones[z].nan_count = 0;
+    }
+    for (unsigned int row = 0; row < col->size; row++) {
+        zone_map_add_row(col, row);
+    }
+    return 1;
+}
+
+// Function to compare the rows [start, end) with a pivot, skipping the blocks settled by their bounds
+void zone_map_scan(const COLUMN *col, unsigned int start, unsigned int end, const void *pivot, COMPARE_COUNTS *counts) {
+    double p = col->zones != NULL ? value_as_double(col->column_type, pivot) : NAN;
+    // A NaN pivot equals every value, the plain scan handles it
+    if (p != p) {
+        col->ops->scan(col, start, end, pivot, counts);
+        return;
+    }
+
+    unsigned int row = start;
+    while (row < end) {
+        unsigned int block_start = row - row % ZONE_ROWS;
+        unsigned int block_end = col->size - block_start < ZONE_ROWS ? col->size : block_start + ZONE_ROWS;
+        unsigned int stop = block_end < end ? block_end : end;
+        const ZONE *zone = &col->zones[row / ZONE_ROWS];
+        int whole = row == block_start && stop == block_end;
+        if (whole && (zone->count == 0 || zone->max < p)) {
+            counts->less += zone->count;
+            counts->equal += zone->nan_count;
+        } else if (whole && zone->min > p) {
+            counts->greater += zone->count;
+            counts->equal += zone->nan_count;
+        } else if (whole && zone->min == p && zone->max == p) {
+            counts->equal += zone->count + zone->nan_count;
+        } else {
+            // Partial block, or bounds straddling the pivot
+            col->ops->scan(col, row, stop, pivot, counts);
+        }
+        row = stop;
+    }
+}
+
+// Function to tell whether a block of a column can be skipped by a filter
+// NaN values only pass FILTER_NE: they keep a block for it alone
+int zone_map_rules_out(const COLUMN *col, unsigned int row, FILTER_OP op, const void *pivot, const void *high) {
+    if (col->zones == NULL) return 0;
+    const ZONE *zone = &col->zones[row / ZONE_ROWS];
+    double p = value_as_double(col->column_type, pivot);
+    double h = op == FILTER_BETWEEN ? value_as_double(col->column_type, high) : p;
+    // A NaN bound is left to the kernels
+    if (p != p || h != h) return 0;
+    int no_number = zone->count == 0;
+    switch (op) {
+        case FILTER_LT: return no_number || zone->min >= p;
+        case FILTER_LE: return no_number || zone->min > p;
+        case FILTER_EQ: return no_number || zone->min > p || zone->max < p;
+        case FILTER_NE: return zone->nan_count == 0 && (no_number || (zone->min == p && zone->max == p));
+        case FILTER_GE: return no_number || zone->max < p;
+        case FILTER_GT: return no_number || zone->max <= p;
+        default: return no_number || zone->min > h || zone->max < p;
+    }
+}
+
+// Function to get the memory footprint of the zone map of a column
+size_t zone_map_memory_usage(const COLUMN *col) {
+    if (col == NULL || col->zones == NULL) return 0;
+    return zone_count(col->max_size) * sizeof(ZONE);
+}
@@ -0,0 +1,40 @@
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include "column.h"
+
+// Rows summarized by one zone
+#define ZONE_ROWS 4096
+_Static_assert(SEGMENT_ROWS % ZONE_ROWS == 0, "A column segment holds whole zone map blocks");
+
+// Bounds of the values of one block of ZONE_ROWS rows of a numeric column
+// The bounds only widen: after an overwrite or a removal they may be loose, never wrong
+struct zone {
+    double min;
+    double max;
+    unsigned int count;  // Non-null, non-NaN values in the block
+    unsigned int nan_count;  // NaN values, equal to every pivot
+};
+
+// Function prototypes for maintaining the zone maps of UINT, INT, CHAR, FLOAT and DOUBLE columns
+
+// Make room for the zones of capacity rows, called whenever the column storage grows
+int zone_map_reserve(COLUMN *col, size_t capacity);
+
+// Account for the value of a row once it is stored, or before it is overwritten or removed
+void zone_map_add_row(COLUMN *col, unsigned int row);
+void zone_map_remove_row(COLUMN *col, unsigned int row);
+
+// Size the zone map to the capacity of the column and recompute it from the values, after rows have moved
+int zone_map_rebuild(COLUMN *col);
+
+// Same as col->ops->scan, but blocks whose bounds settle the comparison are counted without reading them
+void zone_map_scan(const COLUMN *col, unsigned int start, unsigned int end, const void *pivot, COMPARE_COUNTS *counts);
+
+// Whether the bounds of the block of a row prove that none of its values passes a filter, 0 without a zone map
+int zone_map_rules_out(const COLUMN *col, unsigned int row, FILTER_OP op, const void *pivot, const void *high);
+
+// Bytes used by the zone map of a column
+size_t zone_map_memory_usage(const COLUMN *col);
+
+#endif // ZONEMAP_H